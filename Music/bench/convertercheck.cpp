@@ -0,0 +1,159 @@
+#include "convertercheck.h"
+#include "yuvconverter.h"
+#include <QString>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+// 宽度不是16/32/64的整数倍，各SIMD内核的行尾补齐部分都会执行到
+const int kWidth = 1366;
+const int kHeight = 770;
+
+// 每个组合用几组不同的随机数据
+const quint32 kSeeds[] = { 1, 2, 3 };
+
+const YuvConverter::Backend kBackends[] = {
+    YuvConverter::Backend::SSE41,
+    YuvConverter::Backend::AVX2,
+    YuvConverter::Backend::AVX512,
+};
+
+/**
+ * @brief 以指定实现整帧转换
+ * @param backend 实现类型
+ * @param source 源帧
+ * @param dst 目标像素格式
+ * @param output 输出图像（按源帧尺寸分配，每行width*4字节）
+ * @return 转换器不支持该组合时返回false
+ */
+bool convertFrame(YuvConverter::Backend backend, const AVFrame *source, AVPixelFormat dst,
+                  std::vector<uint8_t> *output)
+{
+    YuvConverter converter;
+    if (!converter.setBackend(backend)
+            || !converter.prepare(static_cast<AVPixelFormat>(source->format), dst)) {
+        return false;
+    }
+    const int stride = source->width * 4;
+    output->assign(static_cast<size_t>(stride) * source->height, 0);
+    converter.convert(source, output->data(), stride, 0, source->height);
+    return true;
+}
+
+} // namespace
+
+ConverterCheck::ConverterCheck()
+    : m_failures(0)
+{
+}
+
+bool ConverterCheck::run()
+{
+    m_results = QJsonArray();
+    m_failures = 0;
+
+    std::vector<uint8_t> reference;
+    std::vector<uint8_t> output;
+    for (const auto &conversion : YuvConverter::supportedConversions()) {
+        QJsonArray backends;
+        QJsonArray mismatches;
+        backends.append(YuvConverter::backendName(YuvConverter::Backend::Scalar));
+
+        for (quint32 seed : kSeeds) {
+            AVFrame *source = makeRandomFrame(conversion.first, kWidth, kHeight, seed);
+            if (!source || !convertFrame(YuvConverter::Backend::Scalar, source, conversion.second, &reference)) {
+                av_frame_free(&source);
+                mismatches.append(YuvConverter::backendName(YuvConverter::Backend::Scalar));
+                continue;
+            }
+
+            for (YuvConverter::Backend backend : kBackends) {
+                if (!YuvConverter::isBackendAvailable(backend)) {
+                    continue;
+                }
+                const QString name = YuvConverter::backendName(backend);
+                if (seed == kSeeds[0]) {
+                    backends.append(name);
+                }
+                const bool same = convertFrame(backend, source, conversion.second, &output)
+                        && std::memcmp(output.data(), reference.data(), reference.size()) == 0;
+                if (!same && !mismatches.contains(name)) {
+                    mismatches.append(name);
+                }
+            }
+            av_frame_free(&source);
+        }
+
+        QJsonObject result;
+        result["src"] = QString::fromUtf8(av_get_pix_fmt_name(conversion.first));
+        result["dst"] = QString::fromUtf8(av_get_pix_fmt_name(conversion.second));
+        result["backends"] = backends;
+        result["mismatches"] = mismatches;
+        result["status"] = mismatches.isEmpty() ? "pass" : "fail";
+        m_failures += mismatches.size();
+        m_results.append(result);
+    }
+    return m_failures == 0;
+}
+
+int ConverterCheck::failureCount() const
+{
+    return m_failures;
+}
+
+QJsonObject ConverterCheck::report() const
+{
+    QJsonObject report;
+    report["width"] = kWidth;
+    report["height"] = kHeight;
+    report["conversions"] = m_results;
+    report["failures"] = m_failures;
+    return report;
+}
+
+AVFrame *ConverterCheck::makeRandomFrame(AVPixelFormat format, int width, int height, quint32 seed)
+{
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+    AVFrame *frame = av_frame_alloc();
+    if (!descriptor || !frame) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    // 行尾对齐填充也一并填上随机数据，越界读取填充区的内核同样会暴露差异
+    std::mt19937 random(seed);
+    const int depth = descriptor->comp[0].depth;
+    const int planes = av_pix_fmt_count_planes(format);
+    for (int plane = 0; plane < planes; ++plane) {
+        const int rows = plane == 0 ? height : AV_CEIL_RSHIFT(height, descriptor->log2_chroma_h);
+        for (int y = 0; y < rows; ++y) {
+            uint8_t *row = frame->data[plane] + static_cast<ptrdiff_t>(y) * frame->linesize[plane];
+            if (depth > 8) {
+                uint16_t *samples = reinterpret_cast<uint16_t *>(row);
+                const uint16_t mask = static_cast<uint16_t>((1 << depth) - 1);
+                for (int x = 0; x < frame->linesize[plane] / 2; ++x) {
+                    samples[x] = static_cast<uint16_t>(random()) & mask;
+                }
+            } else {
+                for (int x = 0; x < frame->linesize[plane]; ++x) {
+                    row[x] = static_cast<uint8_t>(random());
+                }
+            }
+        }
+    }
+    return frame;
+}
@@ -0,0 +1,62 @@
+#ifndef CONVERTERCHECK_H
+#define CONVERTERCHECK_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QtGlobal>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+    struct AVFrame;
+}
+
+/**
+ * @brief YuvConverter各实现的正确性校验
+ *
+ * 对转换表中的每个(源格式, 目标格式)组合，用随机数据填充源帧的各平面，
+ * 分别以本机支持的每种实现整帧转换，与标量参考实现的输出逐字节比较（memcmp）。
+ * 各实现使用相同的定点运算，任何差异都说明某个SIMD内核偏离了参考实现。
+ * 画面宽度不是向量宽度的整数倍，行尾的标量补齐部分同样被覆盖。
+ */
+class ConverterCheck
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    ConverterCheck();
+
+    /**
+     * @brief 校验全部组合和实现
+     * @return 是否全部一致
+     */
+    bool run();
+
+    /**
+     * @brief 获取输出不一致的(组合, 实现)数
+     * @return 数量
+     */
+    int failureCount() const;
+
+    /**
+     * @brief 获取校验报告
+     * @return JSON格式的报告
+     */
+    QJsonObject report() const;
+
+    /**
+     * @brief 分配一帧并用伪随机数据填充各平面（高位深格式只填有效位）
+     * @param format 像素格式
+     * @param width 宽度
+     * @param height 高度
+     * @param seed 随机种子，相同参数得到相同内容
+     * @return 帧，调用者负责释放；分配失败时为nullptr
+     */
+    static AVFrame *makeRandomFrame(AVPixelFormat format, int width, int height, quint32 seed);
+
+private:
+    QJsonArray m_results;
+    int m_failures;
+};
+
+#endif // CONVERTERCHECK_H
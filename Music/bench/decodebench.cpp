@@ -0,0 +1,334 @@
+#include "decodebench.h"
+#include "mediadecoder.h"
+#include "frameconverter.h"
+#include <QElapsedTimer>
+#include <QThread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+/**
+ * @brief 获取输出图像格式的名称
+ * @param format 图像格式
+ * @return 名称
+ */
+QString imageFormatName(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+        return "rgb32";
+    case QImage::Format_ARGB32:
+        return "argb32";
+    case QImage::Format_ARGB32_Premultiplied:
+        return "argb32_premultiplied";
+    case QImage::Format_RGBX8888:
+        return "rgbx8888";
+    case QImage::Format_RGBA8888:
+        return "rgba8888";
+    case QImage::Format_RGBA8888_Premultiplied:
+        return "rgba8888_premultiplied";
+    case QImage::Format_RGB888:
+        return "rgb888";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+} // namespace
+
+DecodeBench::DecodeBench(const Options &options)
+    : m_options(options)
+    , m_wallSeconds(0.0)
+    , m_frames(0)
+    , m_frameAllocations(0)
+    , m_timeToFirstFrame(-1.0)
+    , m_demux("demux")
+    , m_decode("decode")
+    , m_convert("convert")
+    , m_deliver("deliver")
+    , m_seek("seek")
+{
+}
+
+bool DecodeBench::run()
+{
+    // 首帧耗时从打开输入开始计算，包含探测流信息和打开解码器
+    QElapsedTimer openClock;
+    openClock.start();
+    m_timeToFirstFrame = -1.0;
+
+    MediaDecoder decoder;
+    decoder.setDecoderThreadCount(m_options.decoderThreads);
+    // 时长窗口覆盖整个文件，只由字节上限决定缓存范围
+    decoder.setReadAheadSize(static_cast<qint64>(m_options.readAheadMegabytes) * 1024 * 1024);
+    decoder.setIoUringEnabled(m_options.ioUring);
+    decoder.setMemoryMapEnabled(m_options.memoryMap);
+    decoder.setPacketCacheLimits(static_cast<qint64>(m_options.packetCacheMegabytes) * 1024 * 1024, 1.0e9);
+    if (!decoder.open(m_options.input, m_options.inputFormat)) {
+        m_errorString = decoder.errorString();
+        return false;
+    }
+
+    FrameConverter converter;
+    converter.setFastPathEnabled(m_options.fastPath);
+    if (!converter.setOutputFormat(m_options.outputFormat)
+            || !converter.open(decoder.width(), decoder.height(), decoder.pixelFormat())) {
+        m_errorString = "无法创建格式转换上下文";
+        return false;
+    }
+
+    const AVRational rate = decoder.frameRate();
+    const char *pixelFormat = av_get_pix_fmt_name(decoder.pixelFormat());
+    m_stream = QJsonObject();
+    m_stream["input"] = m_options.input;
+    m_stream["codec"] = decoder.codecName();
+    m_stream["width"] = decoder.width();
+    m_stream["height"] = decoder.height();
+    m_stream["pixel_format"] = pixelFormat ? QString::fromUtf8(pixelFormat) : QString("none");
+    m_stream["frame_rate"] = rate.den > 0 ? av_q2d(rate) : 0.0;
+    m_stream["duration"] = decoder.duration();
+
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    if (!packet || !frame) {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        m_errorString = "内存不足";
+        return false;
+    }
+
+    // 投递目标运行在独立线程的事件循环中，与播放器中界面线程接收帧的方式一致
+    QThread consumerThread;
+    QObject sink;
+    sink.moveToThread(&consumerThread);
+    consumerThread.start();
+    QImage lastDelivered;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    bool hasFirstPosition = false;
+    double firstPosition = 0.0;
+    m_frames = 0;
+
+    // 处理一帧：（实时模式下等待到期）-> 转换 -> 投递
+    auto processFrame = [&]() {
+        double position = 0.0;
+        if (m_options.realtime && decoder.framePosition(frame, &position)) {
+            if (!hasFirstPosition) {
+                firstPosition = position;
+                hasFirstPosition = true;
+            }
+            const qint64 due = static_cast<qint64>((position - firstPosition) * 1e9);
+            const qint64 wait = due - clock.nsecsElapsed();
+            if (wait > 0) {
+                QThread::usleep(static_cast<unsigned long>(wait / 1000));
+            }
+        }
+
+        const qint64 convertStart = clock.nsecsElapsed();
+        const QImage image = converter.convert(frame);
+        const qint64 sentAt = clock.nsecsElapsed();
+        m_convert.addSample(sentAt - convertStart, image.sizeInBytes());
+        if (image.isNull()) {
+            return;
+        }
+        if (m_frames == 0) {
+            m_timeToFirstFrame = openClock.nsecsElapsed() / 1e6;
+        }
+
+        // 接收方持有最新一帧直到下一帧到达，帧池的复用情况与播放时相同
+        QMetaObject::invokeMethod(&sink, [this, &clock, &lastDelivered, image, sentAt]() {
+            m_deliver.addSample(clock.nsecsElapsed() - sentAt);
+            lastDelivered = image;
+        }, Qt::QueuedConnection);
+        ++m_frames;
+    };
+
+    // 取出解码器中的全部帧，返回false表示已达到帧数上限
+    auto drainFrames = [&](qint64 &decodeNanoseconds) {
+        for (;;) {
+            const qint64 receiveStart = clock.nsecsElapsed();
+            const int ret = decoder.receiveFrame(frame);
+            decodeNanoseconds += clock.nsecsElapsed() - receiveStart;
+            if (ret < 0) {
+                return true;
+            }
+
+            processFrame();
+            av_frame_unref(frame);
+            if (m_options.maxFrames > 0 && m_frames >= m_options.maxFrames) {
+                return false;
+            }
+        }
+    };
+
+    bool more = true;
+    while (more) {
+        const qint64 readStart = clock.nsecsElapsed();
+        const int ret = decoder.readPacket(packet);
+        const qint64 readNanoseconds = clock.nsecsElapsed() - readStart;
+
+        if (ret < 0) {
+            // 输入结束，冲刷解码器中缓存的帧
+            qint64 decodeNanoseconds = 0;
+            decoder.sendPacket(nullptr);
+            drainFrames(decodeNanoseconds);
+            break;
+        }
+        m_demux.addSample(readNanoseconds, packet->size);
+
+        // 只测解复用时丢弃全部数据包，demux阶段的吞吐量即输入层的吞吐量
+        if (m_options.demuxOnly) {
+            av_packet_unref(packet);
+        } else if (decoder.isVideoPacket(packet)) {
+            const qint64 sendStart = clock.nsecsElapsed();
+            decoder.sendPacket(packet);
+            qint64 decodeNanoseconds = clock.nsecsElapsed() - sendStart;
+            const int packetSize = packet->size;
+            av_packet_unref(packet);
+
+            more = drainFrames(decodeNanoseconds);
+            m_decode.addSample(decodeNanoseconds, packetSize);
+        } else {
+            av_packet_unref(packet);
+        }
+    }
+
+    // 队列中的帧按顺序处理完后再退出接收线程
+    QMetaObject::invokeMethod(&sink, [&consumerThread]() {
+        consumerThread.quit();
+    }, Qt::QueuedConnection);
+    consumerThread.wait();
+    m_wallSeconds = clock.nsecsElapsed() / 1e9;
+    lastDelivered = QImage();
+
+    // 解码到目标位置的第一帧并完成转换（跳转只能落在关键帧上，之后的帧需要解码丢弃）
+    auto decodeUntil = [&](double target) {
+        const double tolerance = rate.num > 0 ? 0.5 * rate.den / rate.num : 0.0;
+        bool flushed = false;
+        for (;;) {
+            const int received = decoder.receiveFrame(frame);
+            if (received >= 0) {
+                double position = 0.0;
+                const bool reached = !decoder.framePosition(frame, &position)
+                        || position >= target - tolerance;
+                if (reached) {
+                    const QImage image = converter.convert(frame);
+                    av_frame_unref(frame);
+                    return !image.isNull();
+                }
+                av_frame_unref(frame);
+                continue;
+            }
+            if (received == AVERROR_EOF || flushed) {
+                return false;
+            }
+
+            const int ret = decoder.readPacket(packet);
+            if (ret < 0) {
+                decoder.sendPacket(nullptr);
+                flushed = true;
+                continue;
+            }
+            if (decoder.isVideoPacket(packet)) {
+                decoder.sendPacket(packet);
+            }
+            av_packet_unref(packet);
+        }
+    };
+
+    // 目标位置在前后两端交替选取，向前和向后的跳转都会覆盖到
+    const double duration = decoder.duration();
+    const int seekCount = m_options.seekCount;
+    for (int i = 0; i < seekCount && duration > 0.0; ++i) {
+        const int slot = (i % 2 == 0) ? i / 2 + 1 : seekCount - i / 2;
+        const double target = duration * slot / (seekCount + 1);
+        const qint64 seekStart = clock.nsecsElapsed();
+        if (!decoder.seek(target) || !decodeUntil(target)) {
+            av_frame_free(&frame);
+            av_packet_free(&packet);
+            m_errorString = QString("跳转到%1秒失败").arg(target, 0, 'f', 3);
+            return false;
+        }
+        m_seek.addSample(clock.nsecsElapsed() - seekStart);
+    }
+    m_frameAllocations = converter.frameAllocations();
+
+    const ReadAheadIO::Stats io = decoder.readAhead().stats();
+    m_readAhead = QJsonObject();
+    if (decoder.readAhead().context()) {
+        m_readAhead["bytes_read"] = static_cast<double>(io.bytesRead);
+        m_readAhead["read_mbps"] = io.readMBps;
+        m_readAhead["stalls"] = static_cast<double>(io.stalls);
+        m_readAhead["stall_ms"] = io.stallMs;
+        m_readAhead["seeks"] = static_cast<double>(io.seeks);
+        m_readAhead["backend"] = decoder.readAhead().isUsingUring() ? "io_uring" : "thread";
+    }
+
+    const PacketCache &cache = decoder.packetCache();
+    m_packetCache = QJsonObject();
+    if (cache.isEnabled()) {
+        m_packetCache["hits"] = static_cast<double>(cache.hitCount());
+        m_packetCache["misses"] = static_cast<double>(cache.missCount());
+        m_packetCache["packets"] = cache.packetCount();
+        m_packetCache["bytes"] = static_cast<double>(cache.byteSize());
+    }
+
+    m_config = QJsonObject();
+    m_config["realtime"] = m_options.realtime;
+    m_config["decoder_threads"] = m_options.decoderThreads;
+    m_config["packet_cache_mb"] = m_options.packetCacheMegabytes;
+    m_config["read_ahead_mb"] = m_options.readAheadMegabytes;
+    m_config["io_uring"] = m_options.ioUring;
+    m_config["demux_only"] = m_options.demuxOnly;
+    m_config["input"] = decoder.inputBackend();
+    m_config["fast_path"] = converter.isUsingFastPath();
+    m_config["yuv_backend"] = converter.isUsingFastPath()
+            ? QString(YuvConverter::backendName(converter.yuvConverter().backend()))
+            : QString("swscale");
+    m_config["output_format"] = imageFormatName(converter.outputFormat());
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    return true;
+}
+
+QString DecodeBench::errorString() const
+{
+    return m_errorString;
+}
+
+QJsonObject DecodeBench::report() const
+{
+    QJsonObject stages;
+    for (const StageStats *stage : { &m_demux, &m_decode, &m_convert, &m_deliver }) {
+        stages[stage->name()] = stage->toJson(m_wallSeconds);
+    }
+    if (m_seek.count() > 0) {
+        stages[m_seek.name()] = m_seek.toJson(m_wallSeconds);
+    }
+
+    QJsonObject report;
+    report["stream"] = m_stream;
+    report["config"] = m_config;
+    report["wall_seconds"] = m_wallSeconds;
+    report["frames"] = static_cast<double>(m_frames);
+    report["fps"] = m_wallSeconds > 0.0 ? m_frames / m_wallSeconds : 0.0;
+    report["frame_allocations"] = static_cast<double>(m_frameAllocations);
+    report["time_to_first_frame_ms"] = m_timeToFirstFrame;
+    if (!m_packetCache.isEmpty()) {
+        report["packet_cache"] = m_packetCache;
+    }
+    if (!m_readAhead.isEmpty()) {
+        report["read_ahead"] = m_readAhead;
+    }
+    report["stages"] = stages;
+    return report;
+}
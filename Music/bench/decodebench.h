@@ -0,0 +1,98 @@
+#ifndef DECODEBENCH_H
+#define DECODEBENCH_H
+
+#include <QImage>
+#include <QJsonObject>
+#include <QString>
+#include "stagestats.h"
+
+/**
+ * @brief 无界面解码基准测试
+ *
+ * 使用与播放器相同的MediaDecoder和FrameConverter跑完整条流水线：
+ * 解复用 -> 解码 -> 格式转换 -> 投递到另一线程（模拟界面线程接收帧），
+ * 分别统计各阶段的吞吐量和耗时分位数。可全速运行，也可按时间戳实时运行。
+ * 解码结束后可再做若干次随机跳转，统计从发起跳转到目标帧转换完成的耗时。
+ */
+class DecodeBench
+{
+public:
+    /**
+     * @brief 测试参数
+     */
+    struct Options {
+        QString input;
+        QString inputFormat;
+        bool realtime;
+        qint64 maxFrames;
+        int decoderThreads;
+        bool fastPath;
+        QImage::Format outputFormat;
+        int seekCount;
+        int packetCacheMegabytes;
+        int readAheadMegabytes;
+        bool ioUring;
+        bool demuxOnly;
+        bool memoryMap;
+
+        Options()
+            : realtime(false)
+            , maxFrames(0)
+            , decoderThreads(1)
+            , fastPath(true)
+            , outputFormat(QImage::Format_RGB32)
+            , seekCount(0)
+            , packetCacheMegabytes(0)
+            , readAheadMegabytes(0)
+            , ioUring(false)
+            , demuxOnly(false)
+            , memoryMap(false)
+        {
+        }
+    };
+
+    /**
+     * @brief 构造函数
+     * @param options 测试参数
+     */
+    explicit DecodeBench(const Options &options);
+
+    /**
+     * @brief 运行测试（阻塞直到输入结束或达到帧数上限）
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool run();
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 获取测试报告
+     * @return JSON格式的报告
+     */
+    QJsonObject report() const;
+
+private:
+    Options m_options;
+    QString m_errorString;
+    QJsonObject m_stream;
+    QJsonObject m_config;
+    double m_wallSeconds;
+    qint64 m_frames;
+    quint64 m_frameAllocations;
+    double m_timeToFirstFrame;
+    QJsonObject m_packetCache;
+    QJsonObject m_readAhead;
+
+    // Per-stage statistics
+    StageStats m_demux;
+    StageStats m_decode;
+    StageStats m_convert;
+    StageStats m_deliver;
+    StageStats m_seek;
+};
+
+#endif // DECODEBENCH_H
@@ -0,0 +1,389 @@
+#include <QGuiApplication>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSemaphore>
+#include <QThread>
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+#include "convertercheck.h"
+#include "frameconverter.h"
+#include "framepool.h"
+#include "yuvconverter.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+// 显示链路的微基准测试：格式转换、帧交接、QPixmap转换与缩放、跨线程投递，
+// 各项按分辨率（480p到8K）参数化，为显示路径的取舍提供数据；格式转换另按转换表逐个组合和实现对比。
+// 运行：qvp-microbench --benchmark_filter=PixmapScaled
+
+namespace {
+
+/**
+ * @brief 测试分辨率（宽、高）
+ */
+const int kResolutions[][2] = {
+    { 854, 480 },
+    { 1280, 720 },
+    { 1920, 1080 },
+    { 2560, 1440 },
+    { 3840, 2160 },
+    { 7680, 4320 },
+};
+
+// 逐个格式组合对比时使用的分辨率
+const int kConversionWidth = 1920;
+const int kConversionHeight = 1080;
+
+// 格式组合对比中表示swscale（SWS_BILINEAR）的实现编号
+const int kSwscaleBackend = -1;
+
+// onFrameReady中视频区域的典型大小
+const int kLabelWidth = 1280;
+const int kLabelHeight = 720;
+
+/**
+ * @brief 为每个分辨率注册一组参数
+ * @param bench 基准测试
+ */
+void resolutionArgs(benchmark::internal::Benchmark *bench)
+{
+    bench->ArgNames({ "width", "height" });
+    for (const auto &resolution : kResolutions) {
+        bench->Args({ resolution[0], resolution[1] });
+    }
+}
+
+/**
+ * @brief 为每个分辨率和每种swscale算法注册一组参数
+ * @param bench 基准测试
+ */
+void scalerArgs(benchmark::internal::Benchmark *bench)
+{
+    bench->ArgNames({ "width", "height", "flags" });
+    for (const auto &resolution : kResolutions) {
+        for (int flags : { SWS_FAST_BILINEAR, SWS_BILINEAR, SWS_BICUBIC, SWS_POINT }) {
+            bench->Args({ resolution[0], resolution[1], flags });
+        }
+    }
+}
+
+/**
+ * @brief 为转换表中的每个格式组合注册本机支持的每种实现，外加同一组合的swscale
+ * @param bench 基准测试
+ */
+void conversionArgs(benchmark::internal::Benchmark *bench)
+{
+    const YuvConverter::Backend backends[] = {
+        YuvConverter::Backend::Scalar,
+        YuvConverter::Backend::SSE41,
+        YuvConverter::Backend::AVX2,
+        YuvConverter::Backend::AVX512,
+    };
+    bench->ArgNames({ "conversion", "backend" });
+    const int count = static_cast<int>(YuvConverter::supportedConversions().size());
+    for (int conversion = 0; conversion < count; ++conversion) {
+        for (YuvConverter::Backend backend : backends) {
+            if (YuvConverter::isBackendAvailable(backend)) {
+                bench->Args({ conversion, static_cast<int>(backend) });
+            }
+        }
+        bench->Args({ conversion, kSwscaleBackend });
+    }
+}
+
+/**
+ * @brief 分配并填充一帧YUV420P测试画面
+ * @param width 宽度
+ * @param height 高度
+ * @return 帧，调用者负责释放
+ */
+AVFrame *makeTestFrame(int width, int height)
+{
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    // 亮度为水平渐变，色度取常量，避免全零数据让某些实现走捷径
+    for (int y = 0; y < height; ++y) {
+        uint8_t *row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+        for (int x = 0; x < width; ++x) {
+            row[x] = static_cast<uint8_t>((x + y) & 0xff);
+        }
+    }
+    for (int plane = 1; plane < 3; ++plane) {
+        for (int y = 0; y < (height + 1) / 2; ++y) {
+            std::memset(frame->data[plane] + static_cast<ptrdiff_t>(y) * frame->linesize[plane],
+                        plane == 1 ? 96 : 160, (width + 1) / 2);
+        }
+    }
+    return frame;
+}
+
+/**
+ * @brief 生成一帧32位测试图像
+ * @param width 宽度
+ * @param height 高度
+ * @return 图像
+ */
+QImage makeTestImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(0xff336699);
+    return image;
+}
+
+/**
+ * @brief 记录每次迭代处理的字节数和帧数
+ * @param state 基准测试状态
+ * @param bytesPerFrame 每帧字节数
+ */
+void setFrameCounters(benchmark::State &state, qint64 bytesPerFrame)
+{
+    state.SetBytesProcessed(state.iterations() * bytesPerFrame);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                               benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+// 单个swscale上下文整帧转换（不分条带），对比不同缩放算法在同尺寸格式转换下的开销
+static void BM_SwsScale(benchmark::State &state)
+{
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const int flags = static_cast<int>(state.range(2));
+
+    AVFrame *source = makeTestFrame(width, height);
+    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_YUV420P,
+                                         width, height, AV_PIX_FMT_BGRA,
+                                         flags, nullptr, nullptr, nullptr);
+    if (!source || !context) {
+        av_frame_free(&source);
+        sws_freeContext(context);
+        state.SkipWithError("无法创建swscale上下文");
+        return;
+    }
+
+    QImage target = makeTestImage(width, height);
+    uint8_t *dstData[4] = { target.bits(), nullptr, nullptr, nullptr };
+    int dstLinesize[4] = { static_cast<int>(target.bytesPerLine()), 0, 0, 0 };
+    for (auto _ : state) {
+        sws_scale(context, source->data, source->linesize, 0, height, dstData, dstLinesize);
+        benchmark::ClobberMemory();
+    }
+    setFrameCounters(state, target.sizeInBytes());
+
+    sws_freeContext(context);
+    av_frame_free(&source);
+}
+BENCHMARK(BM_SwsScale)->Apply(scalerArgs)->Unit(benchmark::kMicrosecond);
+
+// 播放器实际使用的转换路径：条带并行 + SIMD快速路径（range(2)为0时只用swscale条带）
+static void BM_FrameConverter(benchmark::State &state)
+{
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+
+    AVFrame *source = makeTestFrame(width, height);
+    FrameConverter converter;
+    converter.setFastPathEnabled(state.range(2) != 0);
+    if (!source || !converter.open(width, height, AV_PIX_FMT_YUV420P)) {
+        av_frame_free(&source);
+        state.SkipWithError("无法创建转换器");
+        return;
+    }
+
+    // 与界面线程一样持有上一帧，帧池的复用情况与播放时相同
+    QImage held;
+    for (auto _ : state) {
+        held = converter.convert(source);
+        benchmark::DoNotOptimize(held.constBits());
+    }
+    setFrameCounters(state, held.sizeInBytes());
+    state.SetLabel(converter.isUsingFastPath() ? "simd" : "swscale");
+
+    av_frame_free(&source);
+}
+BENCHMARK(BM_FrameConverter)
+    ->Apply([](benchmark::internal::Benchmark *bench) {
+        bench->ArgNames({ "width", "height", "fast" });
+        for (const auto &resolution : kResolutions) {
+            bench->Args({ resolution[0], resolution[1], 0 });
+            bench->Args({ resolution[0], resolution[1], 1 });
+        }
+    })
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// 转换表中每个格式组合的特化内核，逐个实现对比，并与同一组合的swscale（SWS_BILINEAR）对照
+static void BM_YuvConversion(benchmark::State &state)
+{
+    const auto conversion = YuvConverter::supportedConversions().at(static_cast<size_t>(state.range(0)));
+    const int backend = static_cast<int>(state.range(1));
+    const int width = kConversionWidth;
+    const int height = kConversionHeight;
+
+    AVFrame *source = ConverterCheck::makeRandomFrame(conversion.first, width, height, 1);
+    if (!source) {
+        state.SkipWithError("无法分配测试帧");
+        return;
+    }
+    std::vector<uint8_t> target(static_cast<size_t>(width) * 4 * height);
+    uint8_t *dstData[4] = { target.data(), nullptr, nullptr, nullptr };
+    int dstLinesize[4] = { width * 4, 0, 0, 0 };
+
+    const QString label = QString("%1->%2 ")
+            .arg(QString::fromUtf8(av_get_pix_fmt_name(conversion.first)))
+            .arg(QString::fromUtf8(av_get_pix_fmt_name(conversion.second)));
+    if (backend == kSwscaleBackend) {
+        SwsContext *context = sws_getContext(width, height, conversion.first,
+                                             width, height, conversion.second,
+                                             SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!context) {
+            av_frame_free(&source);
+            state.SkipWithError("无法创建swscale上下文");
+            return;
+        }
+        for (auto _ : state) {
+            sws_scale(context, source->data, source->linesize, 0, height, dstData, dstLinesize);
+            benchmark::ClobberMemory();
+        }
+        sws_freeContext(context);
+        state.SetLabel((label + "swscale").toStdString());
+    } else {
+        YuvConverter converter;
+        if (!converter.setBackend(static_cast<YuvConverter::Backend>(backend))
+                || !converter.prepare(conversion.first, conversion.second)) {
+            av_frame_free(&source);
+            state.SkipWithError("转换器不支持该组合");
+            return;
+        }
+        for (auto _ : state) {
+            converter.convert(source, target.data(), dstLinesize[0], 0, height);
+            benchmark::ClobberMemory();
+        }
+        state.SetLabel((label + YuvConverter::backendName(converter.backend())).toStdString());
+    }
+    setFrameCounters(state, static_cast<qint64>(target.size()));
+
+    av_frame_free(&source);
+}
+BENCHMARK(BM_YuvConversion)->Apply(conversionArgs)->Unit(benchmark::kMicrosecond);
+
+// 交出帧时整帧深拷贝（早期实现的做法）
+static void BM_ImageCopyHandoff(benchmark::State &state)
+{
+    const QImage source = makeTestImage(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    QImage held;
+    for (auto _ : state) {
+        held = source.copy();
+        benchmark::DoNotOptimize(held.constBits());
+    }
+    setFrameCounters(state, source.sizeInBytes());
+}
+BENCHMARK(BM_ImageCopyHandoff)->Apply(resolutionArgs)->Unit(benchmark::kMicrosecond);
+
+// 从帧池取缓冲区并以浅拷贝交出（当前实现），不含写入像素的开销
+static void BM_PooledHandoff(benchmark::State &state)
+{
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    FramePool pool;
+    QImage held;
+    for (auto _ : state) {
+        QImage *image = pool.acquire(width, height, QImage::Format_RGB32);
+        held = *image;
+        benchmark::DoNotOptimize(held.constBits());
+    }
+    setFrameCounters(state, held.sizeInBytes());
+    state.counters["allocations"] = static_cast<double>(pool.allocationCount());
+}
+BENCHMARK(BM_PooledHandoff)->Apply(resolutionArgs)->Unit(benchmark::kMicrosecond);
+
+// onFrameReady当前的显示路径：QPixmap::fromImage + 缩放到视频区域（range(2)为1时平滑缩放）
+static void BM_PixmapScaled(benchmark::State &state)
+{
+    const QImage source = makeTestImage(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const Qt::TransformationMode mode = state.range(2) ? Qt::SmoothTransformation : Qt::FastTransformation;
+    for (auto _ : state) {
+        const QPixmap pixmap = QPixmap::fromImage(source);
+        const QPixmap scaled = pixmap.scaled(kLabelWidth, kLabelHeight, Qt::KeepAspectRatio, mode);
+        benchmark::DoNotOptimize(scaled.cacheKey());
+    }
+    setFrameCounters(state, source.sizeInBytes());
+}
+BENCHMARK(BM_PixmapScaled)
+    ->Apply([](benchmark::internal::Benchmark *bench) {
+        bench->ArgNames({ "width", "height", "smooth" });
+        for (const auto &resolution : kResolutions) {
+            bench->Args({ resolution[0], resolution[1], 0 });
+            bench->Args({ resolution[0], resolution[1], 1 });
+        }
+    })
+    ->Unit(benchmark::kMicrosecond);
+
+// 只做QPixmap::fromImage，用于从上一项中拆出缩放的开销
+static void BM_PixmapFromImage(benchmark::State &state)
+{
+    const QImage source = makeTestImage(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        const QPixmap pixmap = QPixmap::fromImage(source);
+        benchmark::DoNotOptimize(pixmap.cacheKey());
+    }
+    setFrameCounters(state, source.sizeInBytes());
+}
+BENCHMARK(BM_PixmapFromImage)->Apply(resolutionArgs)->Unit(benchmark::kMicrosecond);
+
+// 跨线程排队投递一帧并等待接收方处理完（frameReady信号从解码线程到界面线程的开销）
+static void BM_QueuedDelivery(benchmark::State &state)
+{
+    const QImage source = makeTestImage(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+
+    QThread receiverThread;
+    QObject receiver;
+    receiver.moveToThread(&receiverThread);
+    receiverThread.start();
+
+    QSemaphore delivered;
+    QImage held;
+    for (auto _ : state) {
+        QMetaObject::invokeMethod(&receiver, [&delivered, &held, source]() {
+            held = source;
+            delivered.release();
+        }, Qt::QueuedConnection);
+        delivered.acquire();
+    }
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                               benchmark::Counter::kIsRate);
+
+    receiverThread.quit();
+    receiverThread.wait();
+}
+BENCHMARK(BM_QueuedDelivery)->Apply(resolutionArgs)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+int main(int argc, char *argv[])
+{
+    // QPixmap需要QGuiApplication，无显示环境时使用offscreen平台
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,368 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include "convertercheck.h"
+#include "decodebench.h"
+#include "libraryindex.h"
+#include "libraryscanner.h"
+#include "librarysearch.h"
+#include "regressionsuite.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavdevice/avdevice.h>
+}
+
+namespace {
+
+// 回归测试的全部用例都因缺少编码器而跳过时的退出码（CTest的SKIP_RETURN_CODE）
+const int kSkippedExitCode = 77;
+
+/**
+ * @brief 解析输出图像格式名称
+ * @param name 名称
+ * @param format 输出格式
+ * @return 名称无效时返回false
+ */
+bool parseOutputFormat(const QString &name, QImage::Format *format)
+{
+    if (name == "rgb32") {
+        *format = QImage::Format_RGB32;
+    } else if (name == "argb32pm") {
+        *format = QImage::Format_ARGB32_Premultiplied;
+    } else if (name == "rgbx8888") {
+        *format = QImage::Format_RGBX8888;
+    } else if (name == "rgba8888") {
+        *format = QImage::Format_RGBA8888;
+    } else if (name == "rgb888") {
+        *format = QImage::Format_RGB888;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 扫描目录并写入媒体库索引，报告扫描吞吐量和索引打开耗时
+ * @param roots 根目录
+ * @param indexPath 索引文件，已存在时未变化的文件沿用其中的记录
+ * @param threadCount 扫描线程数，0表示CPU核心数
+ * @param report 输出报告
+ * @param errorString 失败时输出原因
+ * @return 是否成功
+ */
+bool scanLibrary(const QStringList &roots, const QString &indexPath, int threadCount,
+                 QJsonObject *report, QString *errorString)
+{
+    QElapsedTimer clock;
+
+    // 上次的索引不存在或格式不符时全部重新探测
+    LibraryIndex previous;
+    clock.start();
+    const bool hasPrevious = QFile::exists(indexPath) && previous.open(indexPath);
+    const double previousOpenMs = clock.nsecsElapsed() / 1e6;
+
+    LibraryScanner scanner;
+    scanner.setThreadCount(threadCount);
+    scanner.setPreviousIndex(hasPrevious ? &previous : nullptr);
+    scanner.scan(roots);
+    std::vector<LibraryRecord> records = scanner.takeRecords();
+
+    // 替换索引文件前先解除旧映射（Windows上被映射的文件不能替换）
+    previous.close();
+    clock.restart();
+    if (!LibraryIndex::write(indexPath, std::move(records), errorString)) {
+        return false;
+    }
+    const double writeMs = clock.nsecsElapsed() / 1e6;
+
+    LibraryIndex index;
+    clock.restart();
+    if (!index.open(indexPath)) {
+        *errorString = index.errorString();
+        return false;
+    }
+    const double openMs = clock.nsecsElapsed() / 1e6;
+
+    const LibraryScanner::Stats stats = scanner.stats();
+    QJsonObject scan;
+    scan["directories"] = static_cast<double>(stats.directories);
+    scan["files"] = static_cast<double>(stats.files);
+    scan["probed"] = static_cast<double>(stats.probed);
+    scan["reused"] = static_cast<double>(stats.reused);
+    scan["failed"] = static_cast<double>(stats.failed);
+    scan["steals"] = static_cast<double>(stats.steals);
+    scan["seconds"] = stats.seconds;
+    scan["files_per_second"] = stats.seconds > 0.0 ? stats.files / stats.seconds : 0.0;
+
+    QJsonObject indexReport;
+    indexReport["path"] = indexPath;
+    indexReport["records"] = index.count();
+    indexReport["bytes"] = static_cast<double>(QFileInfo(indexPath).size());
+    indexReport["previous_open_ms"] = hasPrevious ? previousOpenMs : -1.0;
+    indexReport["write_ms"] = writeMs;
+    indexReport["open_ms"] = openMs;
+
+    report->insert("scan", scan);
+    report->insert("index", indexReport);
+    return true;
+}
+
+/**
+ * @brief 在媒体库索引上建立倒排索引，按逐字输入的方式执行查询，报告每次按键的搜索耗时
+ * @param indexPath 索引文件
+ * @param queries 查询文本，每个都从第一个字符开始逐字输入
+ * @param report 输出报告
+ * @param errorString 失败时输出原因
+ * @return 是否成功
+ */
+bool searchLibrary(const QString &indexPath, const QStringList &queries, QJsonObject *report,
+                   QString *errorString)
+{
+    LibraryIndex index;
+    if (!index.open(indexPath)) {
+        *errorString = index.errorString();
+        return false;
+    }
+
+    LibrarySearch search;
+    QElapsedTimer clock;
+    clock.start();
+    search.build(index);
+    const double buildMs = clock.nsecsElapsed() / 1e6;
+
+    QJsonArray results;
+    double maxMs = 0.0;
+    for (const QString &query : queries) {
+        // 每个查询从空白开始，模拟用户在搜索框中逐字输入
+        search.search(QString());
+        double queryMaxMs = 0.0;
+        int matches = 0;
+        for (int length = 1; length <= query.size(); ++length) {
+            matches = static_cast<int>(search.search(query.left(length)).size());
+            queryMaxMs = qMax(queryMaxMs, search.lastSearchMilliseconds());
+        }
+        maxMs = qMax(maxMs, queryMaxMs);
+
+        QJsonObject result;
+        result["query"] = query;
+        result["matches"] = matches;
+        result["last_ms"] = search.lastSearchMilliseconds();
+        result["max_keystroke_ms"] = queryMaxMs;
+        results.append(result);
+    }
+
+    QJsonObject searchReport;
+    searchReport["records"] = search.count();
+    searchReport["build_ms"] = buildMs;
+    searchReport["memory_bytes"] = static_cast<double>(search.memoryUsage());
+    searchReport["max_keystroke_ms"] = maxMs;
+    searchReport["queries"] = results;
+    report->insert("search", searchReport);
+    return true;
+}
+
+/**
+ * @brief 输出JSON报告
+ * @param json 报告内容
+ * @param filePath 输出文件，为空时输出到标准输出
+ * @return 是否成功
+ */
+bool writeReport(const QByteArray &json, const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        QTextStream out(stdout);
+        out << json;
+        return true;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write(json);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("qvp-bench");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "无界面解码基准测试：统计解复用、解码、格式转换和投递各阶段的吞吐量与耗时分位数，以JSON输出。\n"
+        "示例：qvp-bench -f lavfi \"testsrc2=size=1920x1080:rate=30:duration=10\"\n"
+        "回归测试：qvp-bench --suite bench/baselines.json（有用例超出预算时退出码为2，全部用例被跳过时为77）\n"
+        "转换校验：qvp-bench --check-converters（SIMD实现与标量实现输出不一致时退出码为2）");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("input", "视频文件路径，或配合--format使用的输入描述（如lavfi滤镜图）");
+
+    QCommandLineOption formatOption(QStringList() << "f" << "format", "强制使用的输入格式（如lavfi）", "name");
+    QCommandLineOption realtimeOption("realtime", "按帧时间戳实时运行，而不是全速解码");
+    QCommandLineOption framesOption(QStringList() << "n" << "frames", "最多处理的帧数（0表示不限）", "count", "0");
+    QCommandLineOption threadsOption("decoder-threads", "解码线程数（0表示自动）", "count", "1");
+    QCommandLineOption outputFormatOption("output-format",
+                                          "输出图像格式：rgb32、argb32pm、rgbx8888、rgba8888、rgb888", "name", "rgb32");
+    QCommandLineOption noFastPathOption("no-fast-path", "禁用SIMD快速路径，全部使用swscale");
+    QCommandLineOption seeksOption("seeks", "解码结束后的随机跳转次数", "count", "0");
+    QCommandLineOption packetCacheOption("packet-cache", "视频包缓存上限（MB，0表示禁用），用于对比缓存命中的跳转", "mb", "0");
+    QCommandLineOption readAheadOption("read-ahead", "本地文件预读缓冲区（MB，0表示使用FFmpeg的file协议）", "mb", "0");
+    QCommandLineOption ioUringOption("io-uring", "预读层优先使用io_uring（仅Linux，需配合--read-ahead）");
+    QCommandLineOption mmapOption("mmap", "本地文件以内存映射读取（文件过大时退回--read-ahead的设置）");
+    QCommandLineOption demuxOnlyOption("demux-only", "只读取数据包不解码，用于对比输入层的吞吐量");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "报告输出文件（默认输出到标准输出）", "file");
+    QCommandLineOption suiteOption("suite", "按基线文件生成测试视频并运行性能回归测试", "baseline");
+    QCommandLineOption mediaDirOption("media-dir", "回归测试视频的缓存目录", "dir",
+                                      QDir(QDir::tempPath()).filePath("qvp-bench-media"));
+    QCommandLineOption scanLibraryOption("scan-library", "并行扫描目录并写入媒体库索引（可重复指定）", "dir");
+    QCommandLineOption libraryIndexOption("library-index", "媒体库索引文件（已存在时未变化的文件沿用其中的记录）", "file",
+                                          QDir(QDir::tempPath()).filePath("qvp-library.idx"));
+    QCommandLineOption scanThreadsOption("scan-threads", "扫描线程数（0表示CPU核心数）", "count", "0");
+    QCommandLineOption searchQueryOption("search-query", "在媒体库索引上逐字输入执行查询并报告耗时（可重复指定）", "text");
+    QCommandLineOption checkConvertersOption("check-converters", "以随机数据校验各SIMD格式转换实现与标量实现的输出逐字节一致");
+    QCommandLineOption updateBaselineOption("update-baseline", "按本机实测结果重写基线文件中的预算");
+    parser.addOption(formatOption);
+    parser.addOption(realtimeOption);
+    parser.addOption(framesOption);
+    parser.addOption(threadsOption);
+    parser.addOption(outputFormatOption);
+    parser.addOption(noFastPathOption);
+    parser.addOption(seeksOption);
+    parser.addOption(packetCacheOption);
+    parser.addOption(readAheadOption);
+    parser.addOption(ioUringOption);
+    parser.addOption(mmapOption);
+    parser.addOption(demuxOnlyOption);
+    parser.addOption(outputOption);
+    parser.addOption(suiteOption);
+    parser.addOption(mediaDirOption);
+    parser.addOption(updateBaselineOption);
+    parser.addOption(scanLibraryOption);
+    parser.addOption(libraryIndexOption);
+    parser.addOption(scanThreadsOption);
+    parser.addOption(searchQueryOption);
+    parser.addOption(checkConvertersOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    // lavfi等虚拟输入设备需要先注册
+    avformat_network_init();
+    avdevice_register_all();
+
+    if (parser.isSet(checkConvertersOption)) {
+        ConverterCheck check;
+        const bool consistent = check.run();
+        const QByteArray json = QJsonDocument(check.report()).toJson(QJsonDocument::Indented);
+        if (!writeReport(json, parser.value(outputOption))) {
+            err << "无法写入报告文件：" << parser.value(outputOption) << Qt::endl;
+            return 1;
+        }
+        if (!consistent) {
+            err << check.failureCount() << " 个转换实现与标量实现不一致" << Qt::endl;
+            return 2;
+        }
+        return 0;
+    }
+
+    if (parser.isSet(suiteOption)) {
+        const QString baselinePath = parser.value(suiteOption);
+        const bool updateBaseline = parser.isSet(updateBaselineOption);
+        RegressionSuite suite(parser.value(mediaDirOption));
+        if (!suite.load(baselinePath) || !suite.run(updateBaseline)
+                || (updateBaseline && !suite.saveBaseline(baselinePath))) {
+            err << suite.errorString() << Qt::endl;
+            return 1;
+        }
+
+        const QByteArray json = QJsonDocument(suite.report()).toJson(QJsonDocument::Indented);
+        if (!writeReport(json, parser.value(outputOption))) {
+            err << "无法写入报告文件：" << parser.value(outputOption) << Qt::endl;
+            return 1;
+        }
+        if (suite.failureCount() > 0) {
+            err << suite.failureCount() << " 个用例超出预算" << Qt::endl;
+            return 2;
+        }
+        // 没有一个用例真正运行时不能算通过
+        if (!updateBaseline && suite.skippedCount() == suite.caseCount()) {
+            err << "本机FFmpeg缺少测试所需的编码器，全部用例已跳过" << Qt::endl;
+            return kSkippedExitCode;
+        }
+        return 0;
+    }
+
+    if (parser.isSet(scanLibraryOption) || parser.isSet(searchQueryOption)) {
+        QJsonObject report;
+        QString errorString;
+        if (parser.isSet(scanLibraryOption)
+                && !scanLibrary(parser.values(scanLibraryOption), parser.value(libraryIndexOption),
+                                parser.value(scanThreadsOption).toInt(), &report, &errorString)) {
+            err << errorString << Qt::endl;
+            return 1;
+        }
+        if (parser.isSet(searchQueryOption)
+                && !searchLibrary(parser.value(libraryIndexOption), parser.values(searchQueryOption),
+                                  &report, &errorString)) {
+            err << errorString << Qt::endl;
+            return 1;
+        }
+
+        const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+        if (!writeReport(json, parser.value(outputOption))) {
+            err << "无法写入报告文件：" << parser.value(outputOption) << Qt::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    const QStringList inputs = parser.positionalArguments();
+    if (inputs.size() != 1) {
+        err << "需要指定一个输入" << Qt::endl;
+        parser.showHelp(1);
+    }
+
+    DecodeBench::Options options;
+    options.input = inputs.first();
+    options.inputFormat = parser.value(formatOption);
+    options.realtime = parser.isSet(realtimeOption);
+    options.maxFrames = parser.value(framesOption).toLongLong();
+    options.decoderThreads = parser.value(threadsOption).toInt();
+    options.fastPath = !parser.isSet(noFastPathOption);
+    options.seekCount = parser.value(seeksOption).toInt();
+    options.packetCacheMegabytes = parser.value(packetCacheOption).toInt();
+    options.readAheadMegabytes = parser.value(readAheadOption).toInt();
+    options.ioUring = parser.isSet(ioUringOption);
+    options.demuxOnly = parser.isSet(demuxOnlyOption);
+    options.memoryMap = parser.isSet(mmapOption);
+    if (!parseOutputFormat(parser.value(outputFormatOption), &options.outputFormat)) {
+        err << "不支持的输出格式：" << parser.value(outputFormatOption) << Qt::endl;
+        return 1;
+    }
+
+    DecodeBench bench(options);
+    if (!bench.run()) {
+        err << bench.errorString() << Qt::endl;
+        return 1;
+    }
+
+    const QByteArray json = QJsonDocument(bench.report()).toJson(QJsonDocument::Indented);
+    if (!writeReport(json, parser.value(outputOption))) {
+        err << "无法写入报告文件：" << parser.value(outputOption) << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
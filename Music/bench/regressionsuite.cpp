@@ -0,0 +1,206 @@
+#include "regressionsuite.h"
+#include "decodebench.h"
+#include "syntheticmedia.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <cmath>
+
+namespace {
+
+// 更新基线时预算相对实测值留出的默认余量
+const double kDefaultTolerance = 0.25;
+
+// 默认每个用例的跳转次数
+const int kDefaultSeekCount = 8;
+
+} // namespace
+
+RegressionSuite::RegressionSuite(const QString &mediaDir)
+    : m_mediaDir(mediaDir)
+    , m_failures(0)
+    , m_skipped(0)
+{
+}
+
+bool RegressionSuite::load(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法读取基线文件：%1").arg(filePath);
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        m_errorString = QString("基线文件格式错误：%1").arg(parseError.errorString());
+        return false;
+    }
+
+    m_baseline = document.object();
+    if (m_baseline["cases"].toArray().size() == 0) {
+        m_errorString = "基线文件中没有测试用例";
+        return false;
+    }
+    return true;
+}
+
+bool RegressionSuite::run(bool updateBaseline)
+{
+    if (!QDir().mkpath(m_mediaDir)) {
+        m_errorString = QString("无法创建测试视频目录：%1").arg(m_mediaDir);
+        return false;
+    }
+
+    m_results = QJsonArray();
+    m_failures = 0;
+    m_skipped = 0;
+
+    QJsonArray cases = m_baseline["cases"].toArray();
+    for (int i = 0; i < cases.size(); ++i) {
+        QJsonObject testCase = cases[i].toObject();
+        QJsonObject result;
+        if (!runCase(testCase, &result, updateBaseline)) {
+            return false;
+        }
+        if (result["status"].toString() == "fail") {
+            ++m_failures;
+        } else if (result["status"].toString() == "skipped") {
+            ++m_skipped;
+        }
+        cases[i] = testCase;
+        m_results.append(result);
+    }
+
+    m_baseline["cases"] = cases;
+    return true;
+}
+
+int RegressionSuite::failureCount() const
+{
+    return m_failures;
+}
+
+int RegressionSuite::skippedCount() const
+{
+    return m_skipped;
+}
+
+int RegressionSuite::caseCount() const
+{
+    return m_baseline["cases"].toArray().size();
+}
+
+QJsonObject RegressionSuite::report() const
+{
+    QJsonObject report;
+    report["media_dir"] = m_mediaDir;
+    report["cases"] = m_results;
+    report["failures"] = m_failures;
+    report["skipped"] = m_skipped;
+    return report;
+}
+
+bool RegressionSuite::saveBaseline(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QString("无法写入基线文件：%1").arg(filePath);
+        return false;
+    }
+    file.write(QJsonDocument(m_baseline).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+QString RegressionSuite::errorString() const
+{
+    return m_errorString;
+}
+
+bool RegressionSuite::runCase(QJsonObject &testCase, QJsonObject *result, bool updateBaseline)
+{
+    SyntheticMedia::Spec spec;
+    spec.codec = testCase["codec"].toString(spec.codec);
+    spec.width = testCase["width"].toInt(spec.width);
+    spec.height = testCase["height"].toInt(spec.height);
+    spec.frameRate = testCase["frame_rate"].toInt(spec.frameRate);
+    spec.durationSeconds = testCase["duration"].toInt(spec.durationSeconds);
+
+    const QString name = testCase["name"].toString(SyntheticMedia::fileNameFor(spec));
+    (*result)["name"] = name;
+
+    // 生成（或复用已缓存的）测试视频；本机FFmpeg缺少对应编码器时跳过该用例
+    const QString mediaPath = QDir(m_mediaDir).filePath(SyntheticMedia::fileNameFor(spec));
+    if (!QFile::exists(mediaPath)) {
+        SyntheticMedia media;
+        if (!media.generate(spec, mediaPath)) {
+            (*result)["status"] = "skipped";
+            (*result)["reason"] = media.errorString();
+            return true;
+        }
+    }
+
+    DecodeBench::Options options;
+    options.input = mediaPath;
+    options.seekCount = m_baseline["seek_count"].toInt(kDefaultSeekCount);
+    DecodeBench bench(options);
+    if (!bench.run()) {
+        m_errorString = QString("%1：%2").arg(name).arg(bench.errorString());
+        return false;
+    }
+
+    const QJsonObject benchReport = bench.report();
+    const double fps = benchReport["fps"].toDouble();
+    const double seekP90 = benchReport["stages"].toObject()["seek"].toObject()
+            ["latency_us"].toObject()["p90"].toDouble() / 1000.0;
+    const double allocations = benchReport["frame_allocations"].toDouble();
+    const double timeToFirstFrame = benchReport["time_to_first_frame_ms"].toDouble();
+
+    QJsonObject measured;
+    measured["fps"] = fps;
+    measured["seek_p90_ms"] = seekP90;
+    measured["frame_allocations"] = allocations;
+    measured["time_to_first_frame_ms"] = timeToFirstFrame;
+    (*result)["measured"] = measured;
+    (*result)["bench"] = benchReport;
+
+    if (updateBaseline) {
+        // 按实测值留出余量写入预算，分配次数本身是确定的，只留1个的余量
+        const double tolerance = m_baseline["tolerance"].toDouble(kDefaultTolerance);
+        QJsonObject budget;
+        budget["min_fps"] = std::floor(fps * (1.0 - tolerance));
+        budget["max_seek_p90_ms"] = std::ceil(seekP90 * (1.0 + tolerance));
+        budget["max_frame_allocations"] = allocations + 1;
+        budget["max_ttff_ms"] = std::ceil(timeToFirstFrame * (1.0 + tolerance));
+        testCase["budget"] = budget;
+        (*result)["status"] = "updated";
+        return true;
+    }
+
+    const QJsonObject budget = testCase["budget"].toObject();
+    QJsonArray violations;
+    if (budget.contains("min_fps") && fps < budget["min_fps"].toDouble()) {
+        violations.append(QString("fps %1 < %2")
+                          .arg(fps, 0, 'f', 1).arg(budget["min_fps"].toDouble(), 0, 'f', 1));
+    }
+    if (budget.contains("max_seek_p90_ms") && seekP90 > budget["max_seek_p90_ms"].toDouble()) {
+        violations.append(QString("seek p90 %1 ms > %2 ms")
+                          .arg(seekP90, 0, 'f', 2).arg(budget["max_seek_p90_ms"].toDouble(), 0, 'f', 2));
+    }
+    if (budget.contains("max_frame_allocations")
+            && allocations > budget["max_frame_allocations"].toDouble()) {
+        violations.append(QString("frame allocations %1 > %2")
+                          .arg(allocations, 0, 'f', 0).arg(budget["max_frame_allocations"].toDouble(), 0, 'f', 0));
+    }
+
+    if (budget.contains("max_ttff_ms") && timeToFirstFrame > budget["max_ttff_ms"].toDouble()) {
+        violations.append(QString("time to first frame %1 ms > %2 ms")
+                          .arg(timeToFirstFrame, 0, 'f', 2).arg(budget["max_ttff_ms"].toDouble(), 0, 'f', 2));
+    }
+
+    (*result)["budget"] = budget;
+    (*result)["violations"] = violations;
+    (*result)["status"] = violations.size() > 0 ? "fail" : "pass";
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef REGRESSIONSUITE_H
+#define REGRESSIONSUITE_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * @brief 播放性能回归测试
+ *
+ * 从基线文件读取测试用例（编码器、分辨率、帧率、时长）和各自的预算，
+ * 用SyntheticMedia生成测试视频后以DecodeBench全速运行，检查：
+ * - 吞吐量（fps）不低于min_fps
+ * - 跳转耗时的p90不超过max_seek_p90_ms
+ * - 帧池新分配的缓冲区数不超过max_frame_allocations（防止退化为逐帧分配）
+ * - 从打开文件到第一帧转换完成的耗时不超过max_ttff_ms
+ * 生成的视频缓存在媒体目录中，参数不变时不再重复生成。
+ */
+class RegressionSuite
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param mediaDir 测试视频缓存目录
+     */
+    explicit RegressionSuite(const QString &mediaDir);
+
+    /**
+     * @brief 读取基线文件
+     * @param filePath 基线文件路径
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool load(const QString &filePath);
+
+    /**
+     * @brief 运行全部用例
+     * @param updateBaseline 为true时不做检查，而是按本机实测结果（留出容差）重写各用例的预算
+     * @return 是否运行完成（超出预算不算失败，见failureCount）
+     */
+    bool run(bool updateBaseline);
+
+    /**
+     * @brief 获取超出预算的用例数
+     * @return 用例数
+     */
+    int failureCount() const;
+
+    /**
+     * @brief 获取跳过的用例数（本机FFmpeg缺少对应编码器）
+     * @return 用例数
+     */
+    int skippedCount() const;
+
+    /**
+     * @brief 获取用例总数
+     * @return 用例数
+     */
+    int caseCount() const;
+
+    /**
+     * @brief 获取测试报告
+     * @return JSON格式的报告
+     */
+    QJsonObject report() const;
+
+    /**
+     * @brief 把（更新后的）基线写回文件
+     * @param filePath 基线文件路径
+     * @return 是否成功
+     */
+    bool saveBaseline(const QString &filePath);
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+private:
+    /**
+     * @brief 运行单个用例
+     * @param testCase 基线中的用例，更新基线时其预算会被改写
+     * @param result 输出用例结果
+     * @param updateBaseline 是否更新基线
+     * @return 是否运行完成
+     */
+    bool runCase(QJsonObject &testCase, QJsonObject *result, bool updateBaseline);
+
+    QString m_mediaDir;
+    QJsonObject m_baseline;
+    QJsonArray m_results;
+    int m_failures;
+    int m_skipped;
+    QString m_errorString;
+};
+
+#endif // REGRESSIONSUITE_H
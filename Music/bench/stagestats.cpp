@@ -0,0 +1,75 @@
+#include "stagestats.h"
+#include <algorithm>
+#include <cmath>
+
+StageStats::StageStats(const QString &name)
+    : m_name(name)
+    , m_totalNanoseconds(0)
+    , m_totalBytes(0)
+{
+    // 预留常见长度视频的样本空间，避免测量过程中频繁扩容
+    m_samples.reserve(1 << 16);
+}
+
+void StageStats::addSample(qint64 nanoseconds, qint64 bytes)
+{
+    m_samples.push_back(nanoseconds);
+    m_totalNanoseconds += nanoseconds;
+    m_totalBytes += bytes;
+}
+
+QString StageStats::name() const
+{
+    return m_name;
+}
+
+int StageStats::count() const
+{
+    return static_cast<int>(m_samples.size());
+}
+
+qint64 StageStats::totalNanoseconds() const
+{
+    return m_totalNanoseconds;
+}
+
+double StageStats::percentile(double fraction) const
+{
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+
+    // 最近秩法：取第ceil(p*n)个样本
+    std::vector<qint64> sorted(m_samples);
+    const double clamped = std::min(1.0, std::max(0.0, fraction));
+    size_t rank = static_cast<size_t>(std::ceil(clamped * sorted.size()));
+    rank = std::max<size_t>(rank, 1) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank] / 1000.0;
+}
+
+QJsonObject StageStats::toJson(double wallSeconds) const
+{
+    const double busySeconds = m_totalNanoseconds / 1e9;
+
+    QJsonObject latency;
+    latency["mean"] = m_samples.empty() ? 0.0 : m_totalNanoseconds / 1000.0 / m_samples.size();
+    latency["p50"] = percentile(0.50);
+    latency["p90"] = percentile(0.90);
+    latency["p99"] = percentile(0.99);
+    latency["p999"] = percentile(0.999);
+    latency["max"] = percentile(1.0);
+
+    QJsonObject stage;
+    stage["count"] = count();
+    stage["busy_ms"] = busySeconds * 1000.0;
+    // 阶段自身的处理能力（只算忙碌时间）与实际达到的速率（按墙钟时间）
+    stage["capacity_per_s"] = busySeconds > 0.0 ? count() / busySeconds : 0.0;
+    stage["rate_per_s"] = wallSeconds > 0.0 ? count() / wallSeconds : 0.0;
+    if (m_totalBytes > 0) {
+        stage["bytes"] = static_cast<double>(m_totalBytes);
+        stage["mb_per_s"] = busySeconds > 0.0 ? m_totalBytes / busySeconds / (1024.0 * 1024.0) : 0.0;
+    }
+    stage["latency_us"] = latency;
+    return stage;
+}
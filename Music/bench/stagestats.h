@@ -0,0 +1,69 @@
+#ifndef STAGESTATS_H
+#define STAGESTATS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief 单个流水线阶段的耗时统计
+ *
+ * 记录每次执行的耗时（纳秒）和处理的字节数，
+ * 汇总为吞吐量和耗时分位数。不做线程同步，每个阶段只能由一个线程写入。
+ */
+class StageStats
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param name 阶段名称
+     */
+    explicit StageStats(const QString &name);
+
+    /**
+     * @brief 记录一次执行
+     * @param nanoseconds 耗时（纳秒）
+     * @param bytes 处理的字节数
+     */
+    void addSample(qint64 nanoseconds, qint64 bytes = 0);
+
+    /**
+     * @brief 获取阶段名称
+     * @return 名称
+     */
+    QString name() const;
+
+    /**
+     * @brief 获取执行次数
+     * @return 次数
+     */
+    int count() const;
+
+    /**
+     * @brief 获取累计耗时
+     * @return 耗时（纳秒）
+     */
+    qint64 totalNanoseconds() const;
+
+    /**
+     * @brief 计算耗时分位数
+     * @param fraction 分位（0~1）
+     * @return 耗时（微秒），没有样本时为0
+     */
+    double percentile(double fraction) const;
+
+    /**
+     * @brief 汇总为JSON
+     * @param wallSeconds 整个测试的墙钟时间（秒），用于计算实际速率
+     * @return 统计结果
+     */
+    QJsonObject toJson(double wallSeconds) const;
+
+private:
+    QString m_name;
+    std::vector<qint64> m_samples;
+    qint64 m_totalNanoseconds;
+    qint64 m_totalBytes;
+};
+
+#endif // STAGESTATS_H
@@ -0,0 +1,199 @@
+#include "syntheticmedia.h"
+#include "mediadecoder.h"
+#include <QFile>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+}
+
+bool SyntheticMedia::generate(const Spec &spec, const QString &filePath)
+{
+    if (spec.width <= 0 || spec.height <= 0 || spec.frameRate <= 0 || spec.durationSeconds <= 0) {
+        m_errorString = "测试视频参数无效";
+        return false;
+    }
+
+    const AVCodec *codec = avcodec_find_encoder_by_name(spec.codec.toUtf8().constData());
+    if (!codec) {
+        m_errorString = QString("编码器不可用：%1").arg(spec.codec);
+        return false;
+    }
+
+    // 使用编码器支持的第一种像素格式，由滤镜图完成格式转换
+    const AVPixelFormat pixelFormat = codec->pix_fmts ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+    const QString graph = QString("testsrc2=size=%1x%2:rate=%3:duration=%4,format=%5")
+            .arg(spec.width)
+            .arg(spec.height)
+            .arg(spec.frameRate)
+            .arg(spec.durationSeconds)
+            .arg(QString::fromUtf8(av_get_pix_fmt_name(pixelFormat)));
+
+    MediaDecoder source;
+    if (!source.open(graph, "lavfi")) {
+        m_errorString = source.errorString();
+        return false;
+    }
+
+    // 先写入临时文件，成功后再改名，中途失败不会留下不完整的缓存
+    const QString partialPath = filePath + ".part";
+    const QByteArray partialPathUtf8 = partialPath.toUtf8();
+
+    AVFormatContext *output = nullptr;
+    AVCodecContext *encoder = nullptr;
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+
+    auto encode = [&]() {
+        if (!packet || !frame) {
+            m_errorString = "内存不足";
+            return false;
+        }
+
+        if (avformat_alloc_output_context2(&output, nullptr, "matroska", partialPathUtf8.constData()) < 0) {
+            m_errorString = "无法创建输出封装";
+            return false;
+        }
+        output->flags |= AVFMT_FLAG_BITEXACT;
+
+        encoder = avcodec_alloc_context3(codec);
+        if (!encoder) {
+            m_errorString = "内存不足";
+            return false;
+        }
+        encoder->width = spec.width;
+        encoder->height = spec.height;
+        encoder->pix_fmt = pixelFormat;
+        encoder->time_base = AVRational{1, spec.frameRate};
+        encoder->framerate = AVRational{spec.frameRate, 1};
+        // 每秒一个关键帧，跳转测试的落点与常见点播文件相近
+        encoder->gop_size = spec.frameRate;
+        encoder->max_b_frames = 0;
+        encoder->bit_rate = static_cast<int64_t>(spec.width) * spec.height * spec.frameRate / 10;
+        // 单线程、bitexact编码，保证生成结果可复现
+        encoder->thread_count = 1;
+        encoder->flags |= AV_CODEC_FLAG_BITEXACT;
+        if (output->oformat->flags & AVFMT_GLOBALHEADER) {
+            encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+        if (avcodec_open2(encoder, codec, nullptr) < 0) {
+            m_errorString = QString("无法打开编码器：%1").arg(spec.codec);
+            return false;
+        }
+
+        AVStream *stream = avformat_new_stream(output, nullptr);
+        if (!stream || avcodec_parameters_from_context(stream->codecpar, encoder) < 0) {
+            m_errorString = "无法创建输出流";
+            return false;
+        }
+        stream->time_base = encoder->time_base;
+
+        if (avio_open(&output->pb, partialPathUtf8.constData(), AVIO_FLAG_WRITE) < 0) {
+            m_errorString = QString("无法写入文件：%1").arg(partialPath);
+            return false;
+        }
+        if (avformat_write_header(output, nullptr) < 0) {
+            m_errorString = "无法写入文件头";
+            return false;
+        }
+
+        // 取出编码器中已完成的数据包并写入文件
+        auto writePackets = [&]() {
+            for (;;) {
+                const int ret = avcodec_receive_packet(encoder, packet);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                    return true;
+                }
+                if (ret < 0) {
+                    return false;
+                }
+                av_packet_rescale_ts(packet, encoder->time_base, stream->time_base);
+                packet->stream_index = stream->index;
+                if (av_interleaved_write_frame(output, packet) < 0) {
+                    return false;
+                }
+            }
+        };
+
+        // 把解码出的一帧按顺序编号后送入编码器
+        int64_t frameIndex = 0;
+        auto encodeFrames = [&]() {
+            while (source.receiveFrame(frame) >= 0) {
+                frame->pts = frameIndex++;
+                frame->pict_type = AV_PICTURE_TYPE_NONE;
+                const int ret = avcodec_send_frame(encoder, frame);
+                av_frame_unref(frame);
+                if (ret < 0 || !writePackets()) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        while (source.readPacket(packet) >= 0) {
+            if (source.isVideoPacket(packet)) {
+                source.sendPacket(packet);
+            }
+            av_packet_unref(packet);
+            if (!encodeFrames()) {
+                m_errorString = "编码失败";
+                return false;
+            }
+        }
+
+        // 冲刷源解码器和编码器
+        source.sendPacket(nullptr);
+        if (!encodeFrames() || avcodec_send_frame(encoder, nullptr) < 0 || !writePackets()) {
+            m_errorString = "编码失败";
+            return false;
+        }
+        if (av_write_trailer(output) < 0) {
+            m_errorString = "无法写入文件尾";
+            return false;
+        }
+        return true;
+    };
+
+    bool ok = encode();
+
+    if (output) {
+        if (output->pb) {
+            avio_closep(&output->pb);
+        }
+        avformat_free_context(output);
+    }
+    avcodec_free_context(&encoder);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+
+    if (ok) {
+        QFile::remove(filePath);
+        ok = QFile::rename(partialPath, filePath);
+        if (!ok) {
+            m_errorString = QString("无法写入文件：%1").arg(filePath);
+        }
+    }
+    if (!ok) {
+        QFile::remove(partialPath);
+        return false;
+    }
+
+    m_errorString.clear();
+    return true;
+}
+
+QString SyntheticMedia::errorString() const
+{
+    return m_errorString;
+}
+
+QString SyntheticMedia::fileNameFor(const Spec &spec)
+{
+    return QString("%1-%2x%3-%4fps-%5s.mkv")
+            .arg(spec.codec)
+            .arg(spec.width)
+            .arg(spec.height)
+            .arg(spec.frameRate)
+            .arg(spec.durationSeconds);
+}
@@ -0,0 +1,61 @@
+#ifndef SYNTHETICMEDIA_H
+#define SYNTHETICMEDIA_H
+
+#include <QString>
+
+/**
+ * @brief 合成测试视频生成器
+ *
+ * 用lavfi的testsrc2滤镜生成画面，按指定编码器编码后写入文件。
+ * 编码器和封装器均开启bitexact，同一参数每次生成的文件完全相同，
+ * 不依赖网络、GPU或外部素材，适合作为性能回归测试的输入。
+ */
+class SyntheticMedia
+{
+public:
+    /**
+     * @brief 生成参数
+     */
+    struct Spec {
+        QString codec;
+        int width;
+        int height;
+        int frameRate;
+        int durationSeconds;
+
+        Spec()
+            : codec("mpeg4")
+            , width(640)
+            , height(360)
+            , frameRate(30)
+            , durationSeconds(5)
+        {
+        }
+    };
+
+    /**
+     * @brief 生成测试视频
+     * @param spec 生成参数
+     * @param filePath 输出文件路径（按扩展名选择封装格式，建议使用.mkv）
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool generate(const Spec &spec, const QString &filePath);
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 按生成参数得到缓存文件名，参数相同的视频只需生成一次
+     * @param spec 生成参数
+     * @return 文件名（不含目录）
+     */
+    static QString fileNameFor(const Spec &spec);
+
+private:
+    QString m_errorString;
+};
+
+#endif // SYNTHETICMEDIA_H
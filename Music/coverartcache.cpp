@@ -0,0 +1,92 @@
+#include "coverartcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+
+namespace {
+
+// 档位边长：列表图标、较大的图标和播放界面各取其一，相邻档位相差一倍
+const int kBuckets[] = { 64, 128, 256, 512, 1024 };
+
+// 缩小后的封面细节不多，质量90时512档约几十KB
+const int kJpegQuality = 90;
+
+} // namespace
+
+CoverArtCache::CoverArtCache(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QString CoverArtCache::directory() const
+{
+    return m_directory;
+}
+
+bool CoverArtCache::isEnabled() const
+{
+    return !m_directory.isEmpty();
+}
+
+QByteArray CoverArtCache::keyFor(const QByteArray &coverArt)
+{
+    return QCryptographicHash::hash(coverArt, QCryptographicHash::Sha1).toHex();
+}
+
+int CoverArtCache::bucketFor(const QSize &size)
+{
+    const int side = qMax(size.width(), size.height());
+    for (int bucket : kBuckets) {
+        if (side <= bucket) {
+            return bucket;
+        }
+    }
+    return kBuckets[sizeof(kBuckets) / sizeof(kBuckets[0]) - 1];
+}
+
+QImage CoverArtCache::load(const QByteArray &key, int bucket) const
+{
+    if (!isEnabled() || key.isEmpty()) {
+        return QImage();
+    }
+
+    // 文件不存在时QImageReader只是读取失败，不必先检查
+    QImageReader reader(pathFor(key, bucket), "jpg");
+    return reader.read();
+}
+
+bool CoverArtCache::store(const QByteArray &key, int bucket, const QImage &image) const
+{
+    if (!isEnabled() || key.isEmpty() || image.isNull()) {
+        return false;
+    }
+
+    const QString filePath = pathFor(key, bucket);
+    QDir().mkpath(QFileInfo(filePath).path());
+
+    // 写入临时文件后改名，其他线程同时读取同一封面时不会读到半个文件
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QImageWriter writer(&file, "jpg");
+    writer.setQuality(kJpegQuality);
+    if (!writer.write(image.convertToFormat(QImage::Format_RGB32))) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+QString CoverArtCache::pathFor(const QByteArray &key, int bucket) const
+{
+    // 按键的前两位再分一层目录，十万张封面时每个目录也只有几百个文件
+    return QString("%1/%2/%3/%4.jpg")
+            .arg(m_directory)
+            .arg(bucket)
+            .arg(QString::fromLatin1(key.left(2)))
+            .arg(QString::fromLatin1(key));
+}
@@ -0,0 +1,82 @@
+#ifndef COVERARTCACHE_H
+#define COVERARTCACHE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+/**
+ * @brief 内嵌封面缩小图的磁盘缓存
+ *
+ * 以封面原始编码数据的SHA-1为键，同一专辑的各首曲目共用一份；按边长分档（64/128/256/512/1024），
+ * 每档一个子目录，文件为<目录>/<档位>/<键的前两位>/<键>.jpg。
+ * 缓存中的图像已缩小到档位尺寸，读出只需解码几KB到几十KB的小图，不必再解码几MB的原始封面。
+ * 封面一律存为不透明的JPEG（透明部分按黑色处理）。
+ * 只保存目录路径，不保存其他状态，可在多个线程中同时使用；写入经临时文件改名完成，读到的总是完整文件。
+ */
+class CoverArtCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param directory 缓存目录，为空时不读写磁盘
+     */
+    explicit CoverArtCache(const QString &directory = QString());
+
+    /**
+     * @brief 获取缓存目录
+     * @return 目录路径
+     */
+    QString directory() const;
+
+    /**
+     * @brief 检查是否启用
+     * @return 是否设置了缓存目录
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief 计算封面的缓存键
+     * @param coverArt 封面的原始编码数据
+     * @return SHA-1的十六进制字符串
+     */
+    static QByteArray keyFor(const QByteArray &coverArt);
+
+    /**
+     * @brief 选择能覆盖指定尺寸的最小档位
+     * @param size 需要的尺寸
+     * @return 档位边长，超过最大档位时为最大档位
+     */
+    static int bucketFor(const QSize &size);
+
+    /**
+     * @brief 读取缓存的缩小图
+     * @param key 缓存键
+     * @param bucket 档位边长
+     * @return 图像，未缓存或读取失败时为空图
+     */
+    QImage load(const QByteArray &key, int bucket) const;
+
+    /**
+     * @brief 写入缩小图（已存在时覆盖）
+     * @param key 缓存键
+     * @param bucket 档位边长
+     * @param image 已缩小到档位尺寸以内的图像
+     * @return 是否成功
+     */
+    bool store(const QByteArray &key, int bucket, const QImage &image) const;
+
+private:
+    /**
+     * @brief 获取缓存文件的路径
+     * @param key 缓存键
+     * @param bucket 档位边长
+     * @return 文件路径
+     */
+    QString pathFor(const QByteArray &key, int bucket) const;
+
+    QString m_directory;
+};
+
+#endif // COVERARTCACHE_H
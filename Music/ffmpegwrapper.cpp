@@ -16,44 +16,45 @@ FFmpegWrapper::FFmpegWrapper(QObject *parent) : QObject(parent)
     , m_decodeThread(nullptr)
     , m_isRunning(false)
     , m_isPaused(false)
-    , m_formatCtx(nullptr)
-    , m_videoCodecCtx(nullptr)
-    , m_videoStream(nullptr)
-    , m_videoStreamIndex(-1)
-    , m_swsCtx(nullptr)
+    , m_stepPending(false)
+    , m_isPrerolled(false)
+    , m_seekPending(false)
+    , m_seekCachedPts(AV_NOPTS_VALUE)
+    , m_stepDirection(0)
+    , m_isReversing(false)
     , m_duration(0.0)
     , m_currentPosition(0.0)
     , m_videoWidth(0)
     , m_videoHeight(0)
+    , m_isCoverArtOnly(false)
+    , m_isLooping(false)
+    , m_loopStart(0.0)
+    , m_loopEnd(0.0)
     , m_rawFrame(nullptr)
-    , m_rgbFrame(nullptr)
-    , m_rgbBuffer(nullptr)
-    , m_rgbBufferSize(0)
     , m_currentFilePath()
 {
     initializeFFmpeg();
     
-    // 创建解码线程
-    m_decodeThread = new QThread(this);
-    this->moveToThread(m_decodeThread);
+    m_decoder = createDecoder();
     
-    // 连接线程信号
-    connect(m_decodeThread, &QThread::started, this, &FFmpegWrapper::decodeLoop);
-    connect(m_decodeThread, &QThread::finished, this, [this]() {
-        m_isRunning = false;
+    // 最近解码的帧按YUV原样保留（1080p约3MB一帧），逐帧后退和回到刚看过的位置不再重新解码
+    m_frameCache.setMaxBytes(256LL * 1024 * 1024);
+    
+    // 倒放预取的帧直接放入解码帧缓存（在预取线程中调用）
+    m_gopPrefetcher.setFrameSink([this](const AVFrame *frame) {
+        QMutexLocker locker(&m_mutex);
+        m_frameCache.insert(frame);
     });
+    
+    // 排队超过一个帧间隔（30fps）的帧记为迟到
+    m_stats.setLateThreshold(1000000000LL / 30);
 }
 
 FFmpegWrapper::~FFmpegWrapper()
 {
+    // closeFile会等待解码线程退出
     closeFile();
-    freeResources();
-    
-    if (m_decodeThread) {
-        m_decodeThread->quit();
-        m_decodeThread->wait();
-        delete m_decodeThread;
-    }
+    delete m_decodeThread;
 }
 
 void FFmpegWrapper::initializeFFmpeg()
@@ -63,157 +64,162 @@ void FFmpegWrapper::initializeFFmpeg()
     avformat_network_init();
 }
 
-bool FFmpegWrapper::openFile(const QString &filePath)
+std::unique_ptr<MediaDecoder> FFmpegWrapper::createDecoder()
 {
-    QMutexLocker locker(&m_mutex);
+    std::unique_ptr<MediaDecoder> decoder(new MediaDecoder);
     
-    // 关闭之前的文件
-    closeFile();
+    // 本地文件由预读线程读入8MB环形缓冲区，慢速U盘和NFS上的读取延迟不再直接卡住解码
+    decoder->setReadAheadSize(8LL * 1024 * 1024);
     
-    // 保存当前文件路径
-    m_currentFilePath = filePath;
+    // Linux上改由io_uring保持多个读取在途，高速SSD上的高码率中间格式不再受单次读取延迟限制
+    decoder->setIoUringEnabled(true);
     
-    // 打开输入文件
-    const char *cFilePath = filePath.toUtf8().constData();
-    if (avformat_open_input(&m_formatCtx, cFilePath, nullptr, nullptr) != 0) {
-        emit errorOccurred("无法打开视频文件");
-        return false;
-    }
+    // 缓存最近一分钟（最多128MB）的视频包，向后跳转和A-B循环不再访问文件
+    decoder->setPacketCacheLimits(128LL * 1024 * 1024, 60.0);
     
-    // 获取流信息
-    if (avformat_find_stream_info(m_formatCtx, nullptr) < 0) {
-        emit errorOccurred("无法获取流信息");
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-        return false;
-    }
-    
-    // 查找视频流
-    m_videoStreamIndex = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
-    if (m_videoStreamIndex < 0) {
-        emit errorOccurred("未找到视频流");
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-        return false;
-    }
+    return decoder;
+}
+
+bool FFmpegWrapper::openFile(const QString &filePath, std::unique_ptr<MediaDecoder> prepared)
+{
+    // 首帧耗时从切换文件的一刻算起，包含关闭上一个文件的时间
+    const PipelineStats::Clock::time_point openedAt = PipelineStats::Clock::now();
+    m_trace.instant("open_file");
     
-    // 获取视频流
-    m_videoStream = m_formatCtx->streams[m_videoStreamIndex];
+    // 关闭之前的文件（需在加锁前完成，closeFile内部会等待解码线程）
+    closeFile();
     
-    // 查找视频解码器
-    const AVCodec *videoCodec = avcodec_find_decoder(m_videoStream->codecpar->codec_id);
-    if (!videoCodec) {
-        emit errorOccurred("未找到合适的解码器");
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-        return false;
-    }
+    QMutexLocker locker(&m_mutex);
     
-    // 创建解码器上下文
-    m_videoCodecCtx = avcodec_alloc_context3(videoCodec);
-    if (!m_videoCodecCtx) {
-        emit errorOccurred("无法创建解码器上下文");
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-        return false;
-    }
+    // 保存当前文件路径
+    m_currentFilePath = filePath;
     
-    // 从流复制解码器参数
-    if (avcodec_parameters_to_context(m_videoCodecCtx, m_videoStream->codecpar) < 0) {
-        emit errorOccurred("无法复制解码器参数");
-        avcodec_free_context(&m_videoCodecCtx);
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-        return false;
-    }
+    // 每个文件单独统计
+    m_stats.reset();
+    m_stats.markOpened(openedAt);
     
-    // 打开解码器
-    if (avcodec_open2(m_videoCodecCtx, videoCodec, nullptr) < 0) {
-        emit errorOccurred("无法打开解码器");
-        avcodec_free_context(&m_videoCodecCtx);
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
+    // 已在后台打开的解码器直接接管（文件头已解析，预读缓冲区已在填充）；否则现在打开
+    if (prepared && prepared->isOpen()) {
+        m_decoder = std::move(prepared);
+    } else if (!m_decoder->open(filePath)) {
+        emit errorOccurred(m_decoder->errorString());
+        m_currentFilePath.clear();
         return false;
     }
     
     // 获取视频信息
-    m_videoWidth = m_videoCodecCtx->width;
-    m_videoHeight = m_videoCodecCtx->height;
-    m_duration = m_formatCtx->duration / (double)AV_TIME_BASE;
+    m_videoWidth = m_decoder->width();
+    m_videoHeight = m_decoder->height();
+    m_duration = m_decoder->duration();
+    
+    // 音乐文件的"视频"只是内嵌封面，常有几MB、数千像素见方；界面显示缓存的缩小图，这里不再解码和转换
+    m_isCoverArtOnly = m_decoder->isAttachedPicture();
     
     // 分配视频帧
     m_rawFrame = av_frame_alloc();
-    m_rgbFrame = av_frame_alloc();
     
-    // 计算RGB缓冲区大小
-    m_rgbBufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24, m_videoWidth, m_videoHeight, 1);
-    m_rgbBuffer = (uint8_t *)av_malloc(m_rgbBufferSize);
+    // 创建分片并行的格式转换器，转换结果直接写入帧池缓冲区
+    if (!m_isCoverArtOnly && !m_frameConverter.open(m_videoWidth, m_videoHeight, m_decoder->pixelFormat())) {
+        emit errorOccurred("无法创建格式转换上下文");
+        freeResources();
+        return false;
+    }
     
-    // 设置RGB帧的数据指针
-    av_image_fill_arrays(m_rgbFrame->data, m_rgbFrame->linesize, m_rgbBuffer, 
-                         AV_PIX_FMT_RGB24, m_videoWidth, m_videoHeight, 1);
+    // 预卷：不等play，立即在后台解码并显示第一帧
+    const bool looping = m_isLooping;
+    locker.unlock();
+    startDecodeThread(true);
     
-    // 创建SWS上下文用于格式转换
-    m_swsCtx = sws_getContext(m_videoWidth, m_videoHeight, m_videoCodecCtx->pix_fmt,
-                              m_videoWidth, m_videoHeight, AV_PIX_FMT_RGB24,
-                              SWS_BILINEAR, nullptr, nullptr, nullptr);
+    // 循环播放设置跨文件保留，新文件同样需要预取循环起点
+    if (looping) {
+        openPrefetcher();
+    }
     
     return true;
 }
 
 void FFmpegWrapper::closeFile()
 {
-    QMutexLocker locker(&m_mutex);
+    // 先通知解码线程退出，并在互斥锁外等待，避免与解码循环互相等待
+    stopDecodeThread();
     
-    if (m_isRunning) {
+    // 预取线程的帧回调需要互斥锁，同样在锁外等待其退出
+    m_gopPrefetcher.close();
+    
+    QMutexLocker locker(&m_mutex);
+    freeResources();
+}
+
+void FFmpegWrapper::stopDecodeThread()
+{
+    {
+        QMutexLocker locker(&m_mutex);
         m_isRunning = false;
-        if (m_decodeThread->isRunning()) {
-            m_decodeThread->quit();
-            m_decodeThread->wait();
-        }
+        m_isPaused = false;
+        m_stepPending = false;
+        m_isPrerolled = false;
+        m_isReversing = false;
+        m_stateChanged.wakeAll();
     }
     
-    freeResources();
+    if (m_decodeThread) {
+        m_decodeThread->wait();
+    }
 }
 
-void FFmpegWrapper::freeResources()
+void FFmpegWrapper::startDecodeThread(bool preroll)
 {
-    if (m_swsCtx) {
-        sws_freeContext(m_swsCtx);
-        m_swsCtx = nullptr;
+    // 上一次播放的线程可能仍在退出，在互斥锁外回收
+    if (m_decodeThread) {
+        m_decodeThread->wait();
+        delete m_decodeThread;
+        m_decodeThread = nullptr;
     }
     
-    if (m_rgbBuffer) {
-        av_free(m_rgbBuffer);
-        m_rgbBuffer = nullptr;
+    QMutexLocker locker(&m_mutex);
+    if (!m_decoder->isOpen()) {
+        return;
     }
     
-    if (m_rgbFrame) {
-        av_frame_free(&m_rgbFrame);
-        m_rgbFrame = nullptr;
+    // 只有内嵌封面时预卷没有画面可显示
+    if (preroll && m_isCoverArtOnly) {
+        return;
     }
     
+    // 每次播放创建新的解码线程，解码循环直接运行在该线程中
+    m_isRunning = true;
+    m_isPaused = false;
+    m_stepPending = preroll;
+    m_isPrerolled = preroll;
+    m_seekPending = false;
+    m_seekCachedPts = AV_NOPTS_VALUE;
+    m_stepDirection = 0;
+    m_decodeThread = QThread::create([this]() {
+        decodeLoop();
+    });
+    m_decodeThread->setObjectName("qvp-decode");
+    m_decodeThread->start();
+}
+
+void FFmpegWrapper::freeResources()
+{
+    m_frameConverter.close();
+    m_frameCache.clear();
+    
     if (m_rawFrame) {
         av_frame_free(&m_rawFrame);
         m_rawFrame = nullptr;
     }
     
-    if (m_videoCodecCtx) {
-        avcodec_free_context(&m_videoCodecCtx);
-        m_videoCodecCtx = nullptr;
-    }
+    m_decoder->close();
     
-    if (m_formatCtx) {
-        avformat_close_input(&m_formatCtx);
-        m_formatCtx = nullptr;
-    }
-    
-    m_videoStream = nullptr;
-    m_videoStreamIndex = -1;
     m_duration = 0.0;
     m_currentPosition = 0.0;
     m_videoWidth = 0;
     m_videoHeight = 0;
+    m_isCoverArtOnly = false;
+    m_loopStart = 0.0;
+    m_loopEnd = 0.0;
     m_currentFilePath.clear();
 }
 
@@ -221,38 +227,63 @@ void FFmpegWrapper::play()
 {
     QMutexLocker locker(&m_mutex);
     
-    if (!m_formatCtx) {
+    if (!m_decoder->isOpen()) {
         return;
     }
     
-    if (!m_isRunning) {
-        m_isRunning = true;
-        m_decodeThread->start();
+    m_isReversing = false;
+    
+    // 预卷或暂停中的线程直接继续，不需要重新创建
+    if (m_isRunning) {
+        m_isPaused = false;
+        m_stepPending = false;
+        m_isPrerolled = false;
+        m_stateChanged.wakeAll();
+        return;
     }
     
-    m_isPaused = false;
+    locker.unlock();
+    startDecodeThread(false);
+}
+
+void FFmpegWrapper::playReverse()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // 只有内嵌封面时没有可倒放的画面
+        if (!m_decoder->isOpen() || m_isCoverArtOnly) {
+            return;
+        }
+    }
+    
+    openPrefetcher();
+    
+    QMutexLocker locker(&m_mutex);
+    m_isReversing = true;
+    if (m_isRunning) {
+        m_isPaused = false;
+        m_stepPending = false;
+        m_isPrerolled = false;
+        m_stateChanged.wakeAll();
+        return;
+    }
+    
+    locker.unlock();
+    startDecodeThread(false);
 }
 
 void FFmpegWrapper::pause()
 {
     QMutexLocker locker(&m_mutex);
     m_isPaused = true;
+    m_stepPending = false;
+    m_isPrerolled = false;
 }
 
 void FFmpegWrapper::stop()
 {
-    // 先设置停止标志
-    {   
-        QMutexLocker locker(&m_mutex);
-        m_isRunning = false;
-        m_isPaused = false;
-    }
-    
-    // 等待线程结束（在互斥锁外）
-    if (m_decodeThread->isRunning()) {
-        m_decodeThread->quit();
-        m_decodeThread->wait();
-    }
+    // 设置停止标志并等待线程结束（在互斥锁外）
+    stopDecodeThread();
     
     // 跳转到开头和重置位置
     {   
@@ -262,33 +293,70 @@ void FFmpegWrapper::stop()
         emit positionChanged(m_currentPosition);
         
         // 跳转到开头
-        if (m_formatCtx) {
-            int64_t targetTimestamp = 0;
-            if (av_seek_frame(m_formatCtx, m_videoStreamIndex, targetTimestamp, AVSEEK_FLAG_BACKWARD) >= 0) {
-                avcodec_flush_buffers(m_videoCodecCtx);
-            }
-        }
+        m_decoder->seek(0.0);
     }
+    
+    // 重新预卷开头的第一帧
+    startDecodeThread(true);
 }
 
 void FFmpegWrapper::seek(double position)
 {
     QMutexLocker locker(&m_mutex);
     
-    if (!m_formatCtx) {
+    if (!m_decoder->isOpen()) {
         return;
     }
     
-    // 计算目标时间戳
-    int64_t targetTimestamp = position * AV_TIME_BASE;
+    // 解码线程运行时，刚显示过的位置直接从解码帧缓存取出，解码器不移动
+    m_seekCachedPts = AV_NOPTS_VALUE;
+    if (m_isRunning) {
+        const AVFrame *cached = m_frameCache.findNearest(m_decoder->timestampFor(position));
+        double cachedPosition = 0.0;
+        if (cached && m_decoder->framePosition(cached, &cachedPosition)
+                && qAbs(cachedPosition - position) <= 0.5 * frameDuration()) {
+            m_seekCachedPts = FrameCache::timestampOf(cached);
+        }
+    }
     
-    // 跳转到指定位置
-    if (av_seek_frame(m_formatCtx, m_videoStreamIndex, targetTimestamp, AVSEEK_FLAG_BACKWARD) >= 0) {
-        // 刷新解码器缓冲区
-        avcodec_flush_buffers(m_videoCodecCtx);
+    // 跳转到指定位置（解码器缓冲区同时被刷新）
+    if (m_seekCachedPts != AV_NOPTS_VALUE || m_decoder->seek(position)) {
         m_currentPosition = position;
+        m_seekPending = true;
         emit positionChanged(m_currentPosition);
+        
+        // 停住（预卷或暂停）时解码一帧显示跳转后的画面，然后继续停住
+        if (m_isRunning && m_isPaused) {
+            m_isPaused = false;
+            m_stepPending = true;
+            m_stateChanged.wakeAll();
+        }
+    }
+}
+
+void FFmpegWrapper::stepForward()
+{
+    requestStep(1);
+}
+
+void FFmpegWrapper::stepBackward()
+{
+    requestStep(-1);
+}
+
+void FFmpegWrapper::requestStep(int direction)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_isRunning) {
+        return;
     }
+    
+    // 播放中逐帧时先停住；解码线程显示一帧后重新暂停
+    m_isPaused = false;
+    m_stepPending = true;
+    m_isPrerolled = false;
+    m_stepDirection = direction;
+    m_stateChanged.wakeAll();
 }
 
 double FFmpegWrapper::getDuration() const
@@ -315,33 +383,246 @@ int FFmpegWrapper::getVideoHeight() const
     return m_videoHeight;
 }
 
+bool FFmpegWrapper::isCoverArtOnly() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isCoverArtOnly;
+}
+
 bool FFmpegWrapper::isPlaying() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_isRunning && !m_isPaused;
+    return m_isRunning && !m_isPaused && !m_stepPending && !m_isPrerolled;
 }
 
 bool FFmpegWrapper::isPaused() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_isRunning && m_isPaused;
+    return m_isRunning && (m_isPaused || m_stepPending) && !m_isPrerolled;
+}
+
+bool FFmpegWrapper::isReversing() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isRunning && m_isReversing;
+}
+
+bool FFmpegWrapper::setOutputFormat(QImage::Format format)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameConverter.setOutputFormat(format);
+}
+
+void FFmpegWrapper::setLooping(bool looping)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isLooping = looping;
+    }
+    
+    // 循环播放时由预取器提前解码循环起点
+    if (looping) {
+        openPrefetcher();
+    }
+}
+
+bool FFmpegWrapper::isLooping() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isLooping;
+}
+
+void FFmpegWrapper::setLoopRange(double start, double end)
+{
+    QMutexLocker locker(&m_mutex);
+    m_loopStart = qMax(0.0, start);
+    // B点不大于A点时循环到文件结尾
+    m_loopEnd = end > m_loopStart ? end : 0.0;
+}
+
+void FFmpegWrapper::clearLoopRange()
+{
+    QMutexLocker locker(&m_mutex);
+    m_loopStart = 0.0;
+    m_loopEnd = 0.0;
+}
+
+double FFmpegWrapper::loopStart() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_loopStart;
+}
+
+double FFmpegWrapper::loopEnd() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_loopEnd;
+}
+
+PipelineStats &FFmpegWrapper::stats()
+{
+    // 统计对象内部无锁，不需要持有互斥锁
+    return m_stats;
+}
+
+TraceRecorder &FFmpegWrapper::trace()
+{
+    // 记录器内部无锁，不需要持有互斥锁
+    return m_trace;
+}
+
+const ReadAheadIO &FFmpegWrapper::readAhead() const
+{
+    // 预读层的统计有自己的锁，不需要持有互斥锁
+    return m_decoder->readAhead();
 }
 
 void FFmpegWrapper::decodeLoop()
 {
     AVPacket packet;
     
-    // 帧率控制：限制最大帧率为30fps
-    const int64_t frameInterval = 1000 / 30; // 毫秒
+    // 帧率控制：正放限制最大帧率为30fps；倒放每次显示后退一帧，按视频自身的帧间隔显示才是原速
+    const int64_t kForwardInterval = 1000 / 30; // 毫秒
+    int64_t reverseInterval = kForwardInterval;
+    // 尚未观察到两个关键帧时假定的GOP时长（秒）
+    const double kDefaultGopDuration = 2.0;
     int64_t lastFrameTime = av_gettime_relative() / 1000; // 毫秒
     
-    while (m_isRunning) {
+    // 最近显示的帧和解码器最近输出的帧；从解码帧缓存显示帧时解码器不移动，
+    // 两者不一致期间（fromCache）后续的帧继续从缓存取，缓存中断时再让解码器回到显示位置
+    qint64 shownPts = AV_NOPTS_VALUE;
+    double shownPosition = 0.0;
+    qint64 decodedPts = AV_NOPTS_VALUE;
+    bool fromCache = false;
+    
+    // 按帧时长的一半判断帧是否落在循环起点/终点上，以及缓存中的帧是否与当前帧相邻
+    double halfFrame = 0.0;
+    // 倒放时每次预取的时长：按缓存容量的四分之一限定，当前段、预取段和刚显示过的帧同时留在缓存中
+    double reverseWindow = 0.0;
+    // 只有内嵌封面时不解码画面，按音频包的时间戳推进位置，播放和结束都跟随实际时长
+    bool coverArtOnly = false;
+    // 只有内嵌封面时最近一次发出的位置（小于0表示跳转后尚未发出，不需要等待）
+    double coverTickPosition = -1.0;
+    {
+        QMutexLocker locker(&m_mutex);
+        halfFrame = 0.5 * frameDuration();
+        coverArtOnly = m_isCoverArtOnly;
+        if (halfFrame > 0.0) {
+            reverseInterval = qMax<int64_t>(1, qRound64(2000.0 * halfFrame));
+        }
+        
+        const int frameBytes = av_image_get_buffer_size(m_decoder->pixelFormat(), m_videoWidth, m_videoHeight, 1);
+        if (frameBytes > 0) {
+            reverseWindow = static_cast<double>(m_frameCache.maxBytes() / 4 / frameBytes) * 2.0 * halfFrame;
+        }
+        
+        // 线程重新启动（如播放结束后倒放）时从上次显示的位置继续
+        shownPosition = m_currentPosition;
+        shownPts = m_decoder->timestampFor(shownPosition);
+    }
+    
+    // 倒放预取：已预取范围的起点，以及是否有请求正在进行
+    double reverseFloor = -1.0;
+    bool prefetchPending = false;
+    bool prefetchStale = false;
+    
+    // 读到文件尾后进入冲刷状态，逐帧取出解码器中缓存的最后几帧
+    bool draining = false;
+    // 跳回循环起点后丢弃起点之前的帧，使循环接缝精确到帧（小于0表示不丢弃）
+    double skipUntil = -1.0;
+    
+    // 循环起点预取：距循环终点不到一个GOP时，预取器把起点开始的一段解码进缓存；
+    // 到达终点后先从缓存显示这一段，主解码器跳回起点后利用帧间的空闲追上显示位置（catchingUp）
+    double gopDuration = 0.0;
+    double lastKeyPosition = -1.0;
+    bool loopHeadRequested = false;
+    bool catchingUp = false;
+    
+    // 缓存中与当前显示帧相邻（不超过1.5帧）的帧才能直接使用，否则说明中间有帧已被淘汰
+    auto adjacent = [&](const AVFrame *candidate) -> const AVFrame * {
+        double candidatePosition = 0.0;
+        if (!candidate || halfFrame <= 0.0 || !m_decoder->framePosition(candidate, &candidatePosition)) {
+            return nullptr;
+        }
+        return qAbs(candidatePosition - shownPosition) <= 3.0 * halfFrame ? candidate : nullptr;
+    };
+    
+    bool finished = false;
+    for (;;) {
+        bool stepping;
+        int stepDirection;
+        bool reversing;
+        bool looping;
+        double loopStart;
+        double loopEnd;
+        qint64 cachedSeekPts = AV_NOPTS_VALUE;
         {   
             QMutexLocker locker(&m_mutex);
-            if (m_isPaused) {
-                locker.unlock();
-                QThread::msleep(100);
-                continue;
+            // 暂停时等待状态变化，play/seek/stop会立即唤醒，不再轮询
+            while (m_isRunning && m_isPaused) {
+                m_stateChanged.wait(&m_mutex);
+            }
+            if (!m_isRunning) {
+                break;
+            }
+            stepping = m_stepPending;
+            stepDirection = m_stepDirection;
+            m_stepDirection = 0;
+            reversing = m_isReversing;
+            looping = m_isLooping;
+            loopStart = m_loopStart;
+            loopEnd = m_loopEnd > m_loopStart ? m_loopEnd : m_duration;
+            
+            // 外部跳转已清空解码器（或命中解码帧缓存），之前的冲刷和丢帧状态作废
+            if (m_seekPending) {
+                m_seekPending = false;
+                draining = false;
+                skipUntil = -1.0;
+                cachedSeekPts = m_seekCachedPts;
+                m_seekCachedPts = AV_NOPTS_VALUE;
+                if (cachedSeekPts == AV_NOPTS_VALUE) {
+                    decodedPts = AV_NOPTS_VALUE;
+                    fromCache = false;
+                }
+                reverseFloor = -1.0;
+                prefetchStale = prefetchPending;
+                lastKeyPosition = -1.0;
+                loopHeadRequested = false;
+                catchingUp = false;
+                coverTickPosition = -1.0;
+            }
+        }
+        
+        // 倒放即连续的逐帧后退
+        if (reversing && !stepping) {
+            stepDirection = -1;
+        }
+        const int64_t frameInterval = reversing ? reverseInterval : kForwardInterval;
+        
+        // 倒放时在独立线程中预取当前段之前的一段，剩余未显示的部分不足一段时发出下一个请求
+        if (reversing && reverseWindow > 0.0 && m_gopPrefetcher.isOpen()) {
+            if (prefetchPending && !m_gopPrefetcher.isBusy()) {
+                prefetchPending = false;
+                if (!prefetchStale) {
+                    const double covered = m_gopPrefetcher.coveredFrom();
+                    reverseFloor = covered >= 0.0 ? covered : 0.0;
+                }
+                prefetchStale = false;
+            }
+            const double from = reverseFloor >= 0.0 ? reverseFloor : shownPosition;
+            if (!prefetchPending && from > halfFrame && shownPosition - from < reverseWindow) {
+                prefetchPending = m_gopPrefetcher.request(from, reverseWindow);
+            }
+        }
+        
+        // 正向循环播放距终点不到一个GOP时，预取循环起点开始的一段；
+        // 时长按缓存容量的四分之一限定，预取之后到终点之间解码的帧不会把它们挤出缓存
+        if (looping && !reversing && !loopHeadRequested && reverseWindow > 0.0
+                && loopEnd > loopStart && shownPosition > loopStart && m_gopPrefetcher.isOpen()) {
+            const double lead = qMin(gopDuration > 0.0 ? gopDuration : kDefaultGopDuration, reverseWindow);
+            if (shownPosition >= loopEnd - lead) {
+                const double window = qMin(lead, loopEnd - loopStart);
+                loopHeadRequested = m_gopPrefetcher.request(loopStart + window, window);
             }
         }
         
@@ -350,78 +631,346 @@ void FFmpegWrapper::decodeLoop()
         packet.data = nullptr;
         packet.size = 0;
         
-        // 读取数据包
-        int ret;
+        // 读取并解码数据包
+        QImage frame;
+        bool positionValid = false;
+        double position = 0.0;
+        qint64 framePts = TraceRecorder::kNoPts;
+        bool waitForPrefetch = false;
+        bool catchUpStep = false;
+        // 只有内嵌封面时本次发出位置前应等待的毫秒数（小于0表示本次不发出）
+        int64_t coverWait = -1;
+        
+        // 缓存的帧直接转换显示，解码器保持原位置
+        auto presentCached = [&](const AVFrame *cached) {
+            if (convertVideoFrame(cached, &frame)) {
+                shownPts = FrameCache::timestampOf(cached);
+                framePts = shownPts;
+                fromCache = shownPts != decodedPts;
+                if (m_decoder->framePosition(cached, &shownPosition)) {
+                    m_currentPosition = shownPosition;
+                    positionValid = true;
+                    position = shownPosition;
+                }
+            }
+        };
+        
+        // 跳回循环起点（调用者持有互斥锁）；起点一段已预取进缓存时立即显示其第一帧，主解码器随后追上
+        auto loopBack = [&]() -> bool {
+            if (!seekToLoopStart()) {
+                return false;
+            }
+            draining = false;
+            skipUntil = m_loopStart;
+            decodedPts = AV_NOPTS_VALUE;
+            lastKeyPosition = -1.0;
+            loopHeadRequested = false;
+            coverTickPosition = -1.0;
+            
+            const AVFrame *head = m_frameCache.findNearest(m_decoder->timestampFor(m_loopStart));
+            double headPosition = 0.0;
+            if (head && m_decoder->framePosition(head, &headPosition)
+                    && qAbs(headPosition - m_loopStart) <= halfFrame) {
+                presentCached(head);
+                catchingUp = !frame.isNull();
+            }
+            return true;
+        };
+        
         {   
             QMutexLocker locker(&m_mutex);
-            ret = av_read_frame(m_formatCtx, &packet);
-        }
-        
-        if (ret >= 0) {
-            {   
-                QMutexLocker locker(&m_mutex);
-                if (packet.stream_index == m_videoStreamIndex) {
-                    // 解码视频帧
-                    if (decodeVideoFrame(&packet)) {
-                        // 更新当前位置
-                        if (m_rawFrame->pts != AV_NOPTS_VALUE) {
-                            m_currentPosition = m_rawFrame->pts * av_q2d(m_videoStream->time_base);
-                            emit positionChanged(m_currentPosition);
-                        }
+            // 持锁区间单独记录，界面线程的阻塞可以与之对照
+            TraceRecorder::ScopedEvent locked(m_trace, "decode_locked");
+            
+            // 先看要显示的帧能否直接从解码帧缓存取得
+            const AVFrame *cached = nullptr;
+            if (cachedSeekPts != AV_NOPTS_VALUE) {
+                cached = m_frameCache.findNearest(cachedSeekPts);
+            } else if (stepDirection < 0 && shownPts != AV_NOPTS_VALUE) {
+                cached = adjacent(m_frameCache.findBefore(shownPts));
+                if (!cached && reversing && shownPosition < halfFrame) {
+                    // 倒放到开头：停在第一帧
+                    m_isReversing = false;
+                    m_isPaused = true;
+                    continue;
+                } else if (!cached && reversing && prefetchPending) {
+                    // 前一帧正在预取中，等预取完成而不是在播放线程中同步解码
+                    waitForPrefetch = true;
+                } else if (!cached) {
+                    // 缓存中没有前一帧：跳到其所在GOP的关键帧向后解码，途经的帧都会进入缓存
+                    const double target = qMax(0.0, shownPosition - 2.0 * halfFrame);
+                    if (m_decoder->seek(target)) {
+                        draining = false;
+                        skipUntil = target;
+                        decodedPts = AV_NOPTS_VALUE;
+                        fromCache = false;
+                        lastKeyPosition = -1.0;
+                        catchingUp = false;
+                    }
+                }
+            } else if (catchingUp && !stepping
+                       && av_gettime_relative() / 1000 - lastFrameTime < frameInterval * 3 / 4) {
+                // 循环起点一段正从缓存显示：下一帧到期之前让主解码器向前追赶，结果只放入缓存
+                catchUpStep = true;
+            } else if (fromCache) {
+                cached = adjacent(m_frameCache.findAfter(shownPts));
+                if (!cached) {
+                    // 缓存中断：解码器回到显示位置，丢弃已显示过的帧后继续解码
+                    if (m_decoder->seek(shownPosition)) {
+                        draining = false;
+                        skipUntil = shownPosition + 2.0 * halfFrame;
+                        decodedPts = AV_NOPTS_VALUE;
+                        lastKeyPosition = -1.0;
                     }
+                    fromCache = false;
+                    catchingUp = false;
                 }
             }
             
-            av_packet_unref(&packet);
+            bool decoded = false;
+            if (waitForPrefetch) {
+                // 在互斥锁外等待，预取线程放入缓存时需要该锁
+            } else if (cached) {
+                presentCached(cached);
+            } else if (!draining) {
+                int ret;
+                {
+                    PipelineStats::ScopedTimer timer(m_stats, PipelineStats::Stage::Read);
+                    TraceRecorder::ScopedEvent event(m_trace, "read_frame");
+                    ret = m_decoder->readPacket(&packet);
+                    event.setPts(ret >= 0 ? packet.pts : TraceRecorder::kNoPts);
+                }
+                if (ret < 0 && catchUpStep) {
+                    // 循环区间比追赶的距离还短：不再追赶，缓存用完后按缓存中断处理
+                    catchingUp = false;
+                } else if (ret < 0) {
+                    // 输入结束：送入空包，之后只取出解码器中剩余的帧
+                    m_decoder->sendPacket(nullptr);
+                    draining = true;
+                } else if (coverArtOnly) {
+                    // 封面包不解码；其他流的包只取时间戳，每隔一个帧间隔发出一次位置
+                    double packetPosition = 0.0;
+                    const bool hasPosition = !m_decoder->isVideoPacket(&packet)
+                            && m_decoder->packetPosition(&packet, &packetPosition);
+                    av_packet_unref(&packet);
+                    if (hasPosition && m_isLooping && m_loopEnd > m_loopStart && packetPosition >= m_loopEnd) {
+                        if (!loopBack()) {
+                            finished = true;
+                            break;
+                        }
+                    } else if (hasPosition && packetPosition >= coverTickPosition + frameInterval / 1000.0) {
+                        coverWait = coverTickPosition >= 0.0
+                                ? qRound64(1000.0 * (packetPosition - coverTickPosition)) : 0;
+                        coverTickPosition = packetPosition;
+                        shownPosition = packetPosition;
+                        m_currentPosition = packetPosition;
+                        positionValid = true;
+                        position = packetPosition;
+                    }
+                } else if (m_decoder->isVideoPacket(&packet)) {
+                    decoded = decodeVideoFrame(&packet);
+                }
+                av_packet_unref(&packet);
+            }
+            if (!cached && !waitForPrefetch && draining) {
+                decoded = decodeVideoFrame(nullptr);
+                if (!decoded) {
+                    // 解码器已取空：循环模式下跳回起点，否则播放结束；
+                    // 只有内嵌封面时上次跳回之后一个位置都没发出（没有可播放的包），再跳回只会空转
+                    if (!m_isLooping || (coverArtOnly && coverTickPosition < 0.0) || !loopBack()) {
+                        finished = true;
+                        break;
+                    }
+                }
+            }
             
-            // 帧率控制：限制解码速度
-            int64_t currentTime = av_gettime_relative() / 1000;
-            int64_t elapsed = currentTime - lastFrameTime;
-            if (elapsed < frameInterval) {
-                QThread::msleep(frameInterval - elapsed);
+            if (decoded) {
+                decodedPts = FrameCache::timestampOf(m_rawFrame);
+                double framePosition = 0.0;
+                const bool hasPosition = m_decoder->framePosition(m_rawFrame, &framePosition);
+                
+                // 相邻两个关键帧的间隔即GOP时长，决定何时开始预取循环起点
+                if (hasPosition && m_rawFrame->key_frame) {
+                    if (lastKeyPosition >= 0.0 && framePosition > lastKeyPosition) {
+                        gopDuration = framePosition - lastKeyPosition;
+                    }
+                    lastKeyPosition = framePosition;
+                }
+                
+                if (catchUpStep) {
+                    // 起点之前的帧不需要，只缓存起点之后的帧；追上正在显示的帧后恢复正常解码
+                    if (hasPosition && framePosition >= skipUntil - halfFrame) {
+                        m_frameCache.insert(m_rawFrame);
+                    }
+                    if (hasPosition && framePosition >= shownPosition - halfFrame) {
+                        catchingUp = false;
+                        skipUntil = -1.0;
+                    }
+                    fromCache = shownPts != decodedPts;
+                } else if (hasPosition && skipUntil >= 0.0 && framePosition < skipUntil - halfFrame) {
+                    // 关键帧到目标位置之间的帧只解码不显示，留在缓存中供逐帧后退使用
+                    m_frameCache.insert(m_rawFrame);
+                } else if (hasPosition && m_isLooping && m_loopEnd > m_loopStart
+                           && framePosition >= m_loopEnd - halfFrame) {
+                    // 到达B点：本帧不显示，直接跳回A点
+                    if (!loopBack()) {
+                        finished = true;
+                        break;
+                    }
+                } else if (convertVideoFrame(m_rawFrame, &frame)) {
+                    m_frameCache.insert(m_rawFrame);
+                    skipUntil = -1.0;
+                    shownPts = decodedPts;
+                    framePts = decodedPts;
+                    fromCache = false;
+                    if (hasPosition) {
+                        shownPosition = framePosition;
+                        m_currentPosition = framePosition;
+                        positionValid = true;
+                        position = framePosition;
+                    }
+                }
+            }
+        }
+        
+        if (waitForPrefetch) {
+            m_gopPrefetcher.waitIdle(20);
+            continue;
+        }
+        
+        // 没有产出画面（如音频包、解码器仍在缓冲或正在跳过循环起点前的帧）时立即处理下一个包
+        if (frame.isNull() && coverWait < 0) {
+            continue;
+        }
+        
+        // 帧率控制：先解码好下一帧再等到期发送，跳回循环起点等额外工作隐藏在帧间隔内；
+        // 只有内嵌封面时按两次位置之间的媒体时长等待
+        if (!stepping) {
+            const int64_t interval = coverWait >= 0 ? coverWait : frameInterval;
+            int64_t elapsed = av_gettime_relative() / 1000 - lastFrameTime;
+            if (elapsed < interval) {
+                QThread::msleep(interval - elapsed);
+            }
+        }
+        lastFrameTime = av_gettime_relative() / 1000;
+        
+        // 发送帧和位置信号（在互斥锁外发送，避免死锁）
+        if (!frame.isNull()) {
+            m_stats.frameQueued();
+            m_trace.frameQueued(framePts);
+            emit frameReady(frame);
+        }
+        if (positionValid) {
+            emit positionChanged(position);
+        }
+        
+        // 预卷或暂停中跳转只需要一帧，显示后停住等待play
+        if (stepping) {
+            QMutexLocker locker(&m_mutex);
+            if (m_stepPending) {
+                m_stepPending = false;
+                m_isPaused = true;
             }
-            lastFrameTime = currentTime;
-        } else {
-            // 播放结束
-            break;
         }
     }
     
-    // 发送播放结束信号
-    emit playbackFinished();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isRunning = false;
+    }
     
-    // 停止线程
-    m_decodeThread->quit();
+    // 播放到结尾时发送播放结束信号
+    if (finished) {
+        emit playbackFinished();
+    }
 }
 
 bool FFmpegWrapper::decodeVideoFrame(AVPacket *packet)
 {
-    QMutexLocker locker(&m_mutex);
-    
-    // 解码视频帧
-    int ret = avcodec_send_packet(m_videoCodecCtx, packet);
-    if (ret < 0) {
-        return false;
+    PipelineStats::ScopedTimer timer(m_stats, PipelineStats::Stage::Decode);
+    int ret;
+    
+    // 空包表示冲刷阶段，只取出解码器中剩余的帧
+    if (packet) {
+        TraceRecorder::ScopedEvent event(m_trace, "send_packet", packet->pts);
+        ret = m_decoder->sendPacket(packet);
+        if (ret < 0) {
+            m_stats.addDecodeError();
+            return false;
+        }
     }
     
-    ret = avcodec_receive_frame(m_videoCodecCtx, m_rawFrame);
+    {
+        TraceRecorder::ScopedEvent event(m_trace, "receive_frame");
+        ret = m_decoder->receiveFrame(m_rawFrame);
+        if (ret >= 0) {
+            event.setPts(m_rawFrame->best_effort_timestamp);
+        }
+    }
     if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
         return false;
     } else if (ret < 0) {
+        m_stats.addDecodeError();
         return false;
     }
     
-    // 转换为RGB格式
-    sws_scale(m_swsCtx, m_rawFrame->data, m_rawFrame->linesize,
-              0, m_videoHeight, m_rgbFrame->data, m_rgbFrame->linesize);
+    m_stats.addDecodedFrame();
+    return true;
+}
+
+bool FFmpegWrapper::convertVideoFrame(const AVFrame *source, QImage *image)
+{
+    // 按水平条带并行转换为界面原生的32位格式，结果直接写入帧池缓冲区（无需再整帧拷贝）
+    {
+        PipelineStats::ScopedTimer timer(m_stats, PipelineStats::Stage::Convert);
+        TraceRecorder::ScopedEvent event(m_trace, "convert", source->best_effort_timestamp);
+        *image = m_frameConverter.convert(source);
+    }
+    if (image->isNull()) {
+        m_stats.addDroppedFrame();
+        return false;
+    }
     
-    // 创建QImage（使用copy避免线程安全问题）
-    QImage image(m_rgbBuffer, m_videoWidth, m_videoHeight, QImage::Format_RGB888);
-    QImage frameCopy = image.copy();
+    // 分辨率可能在流中途变化，以实际解码帧为准
+    m_videoWidth = image->width();
+    m_videoHeight = image->height();
     
-    // 发送帧信号（在互斥锁外发送，避免死锁）
-    locker.unlock();
-    emit frameReady(frameCopy);
+    return true;
+}
+
+double FFmpegWrapper::frameDuration() const
+{
+    const AVRational rate = m_decoder->frameRate();
+    if (rate.num <= 0 || rate.den <= 0) {
+        return 0.0;
+    }
+    return static_cast<double>(rate.den) / rate.num;
+}
+
+void FFmpegWrapper::openPrefetcher()
+{
+    QString filePath;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_decoder->isOpen() || m_isCoverArtOnly) {
+            return;
+        }
+        filePath = m_currentFilePath;
+    }
     
+    // 预取器使用独立的文件句柄，第一次需要时才打开（在互斥锁外，其帧回调需要该锁）
+    if (!m_gopPrefetcher.isOpen() && !m_gopPrefetcher.open(filePath)) {
+        qWarning() << "GOP预取不可用：" << m_gopPrefetcher.errorString();
+    }
+}
+
+bool FFmpegWrapper::seekToLoopStart()
+{
+    // 跳到循环起点之前的关键帧，解码器同时被清空
+    m_trace.instant("loop");
+    if (!m_decoder->seek(m_loopStart)) {
+        emit errorOccurred("循环播放跳转失败");
+        return false;
+    }
     return true;
 }
@@ -6,13 +6,17 @@
 #include <QString>
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include "frameconverter.h"
+#include "mediadecoder.h"
+#include "pipelinestats.h"
+#include "tracerecorder.h"
+#include "framecache.h"
+#include "gopprefetcher.h"
 
 // Forward declarations for FFmpeg structs to improve compile time
 extern "C" {
-    struct AVFormatContext;
-    struct AVCodecContext;
-    struct AVStream;
-    struct SwsContext;
     struct AVFrame;
     struct AVPacket;
 }
@@ -22,6 +26,7 @@ extern "C" {
  * 
  * 该类封装了FFmpeg的核心功能，提供了简洁的接口用于视频播放控制
  * 使用多线程进行视频解码，避免阻塞UI线程
+ * 只依赖Qt Core/Gui，属于qvp_core库，可在无界面的程序中使用
  */
 class FFmpegWrapper : public QObject
 {
@@ -40,11 +45,18 @@ public:
     ~FFmpegWrapper() override;
     
     /**
-     * @brief 打开视频文件
+     * @brief 打开视频文件，并在后台预先解码显示第一帧（预卷）
      * @param filePath 视频文件路径
+     * @param prepared 已在其他线程用createDecoder创建并打开同一文件的解码器，为空时由本函数打开
      * @return 是否成功打开
      */
-    bool openFile(const QString &filePath);
+    bool openFile(const QString &filePath, std::unique_ptr<MediaDecoder> prepared = nullptr);
+    
+    /**
+     * @brief 创建按播放需要配置好的解码器（预读、包缓存等），供播放列表提前打开下一项
+     * @return 未打开的解码器
+     */
+    static std::unique_ptr<MediaDecoder> createDecoder();
     
     /**
      * @brief 关闭视频文件
@@ -56,22 +68,37 @@ public:
      */
     void play();
     
+    /**
+     * @brief 开始倒放（从当前位置逆序播放到开头后暂停）
+     */
+    void playReverse();
+    
     /**
      * @brief 暂停视频播放
      */
     void pause();
     
     /**
-     * @brief 停止视频播放
+     * @brief 停止视频播放，回到开头并重新预卷第一帧
      */
     void stop();
     
     /**
-     * @brief 跳转到指定位置
+     * @brief 跳转到指定位置（未在播放时会解码显示目标位置的一帧）
      * @param position 目标位置（秒）
      */
     void seek(double position);
     
+    /**
+     * @brief 显示下一帧后暂停
+     */
+    void stepForward();
+    
+    /**
+     * @brief 显示上一帧后暂停（最近解码过的帧直接从缓存取出）
+     */
+    void stepBackward();
+    
     /**
      * @brief 获取视频时长
      * @return 视频时长（秒）
@@ -96,6 +123,14 @@ public:
      */
     int getVideoHeight() const;
     
+    /**
+     * @brief 检查当前文件的画面是否只是内嵌封面（音乐文件）
+     *
+     * 这种文件不解码封面帧，也不预卷，界面应自行显示缓存的封面缩小图；播放时按音频包的时间戳推进位置。
+     * @return 是否只有内嵌封面
+     */
+    bool isCoverArtOnly() const;
+    
     /**
      * @brief 检查是否正在播放
      * @return 是否正在播放
@@ -107,6 +142,75 @@ public:
      * @return 是否已暂停
      */
     bool isPaused() const;
+    
+    /**
+     * @brief 检查是否正在倒放
+     * @return 是否正在倒放
+     */
+    bool isReversing() const;
+
+    /**
+     * @brief 设置输出帧的图像格式（下次打开文件时生效）
+     * @param format 图像格式，应与绘制设备的原生格式一致以避免绘制时转换
+     * @return 是否支持该格式
+     */
+    bool setOutputFormat(QImage::Format format);
+
+    /**
+     * @brief 设置是否循环播放（播放到结尾或B点时无缝跳回开头或A点，跨文件保持）
+     * @param looping 是否循环
+     */
+    void setLooping(bool looping);
+
+    /**
+     * @brief 检查是否循环播放
+     * @return 是否循环
+     */
+    bool isLooping() const;
+
+    /**
+     * @brief 设置A-B循环区间（仅在循环播放时生效，打开新文件时清除）
+     * @param start A点（秒）
+     * @param end B点（秒），不大于A点时循环到文件结尾
+     */
+    void setLoopRange(double start, double end);
+
+    /**
+     * @brief 清除A-B循环区间，恢复整个文件循环
+     */
+    void clearLoopRange();
+
+    /**
+     * @brief 获取循环起点
+     * @return A点（秒），未设置时为0
+     */
+    double loopStart() const;
+
+    /**
+     * @brief 获取循环终点
+     * @return B点（秒），未设置时为0
+     */
+    double loopEnd() const;
+
+    /**
+     * @brief 获取流水线各阶段的统计（可在任意线程读取快照）
+     * @return 统计对象
+     */
+    PipelineStats &stats();
+
+    /**
+     * @brief 获取流水线事件跟踪记录器（默认不启用）
+     * @return 跟踪记录器
+     */
+    TraceRecorder &trace();
+
+    /**
+     * @brief 获取本地文件预读层（读取吞吐量和停顿统计，可在任意线程读取）
+     *
+     * 预读层属于当前解码器，openFile接管预先打开的解码器后会换成新的对象，需重新获取。
+     * @return 预读层
+     */
+    const ReadAheadIO &readAhead() const;
 
 signals:
     /**
@@ -132,13 +236,23 @@ signals:
      */
     void positionChanged(double position);
 
-private slots:
+private:
     /**
      * @brief 解码线程主函数
      */
     void decodeLoop();
 
-private:
+    /**
+     * @brief 通知解码线程退出并等待其结束（调用时不能持有互斥锁）
+     */
+    void stopDecodeThread();
+
+    /**
+     * @brief 回收上一个解码线程并启动新的解码线程（调用时不能持有互斥锁）
+     * @param preroll 为true时只解码并显示一帧后停住，等待play
+     */
+    void startDecodeThread(bool preroll);
+
     /**
      * @brief 初始化FFmpeg库
      */
@@ -150,39 +264,88 @@ private:
     void freeResources();
     
     /**
-     * @brief 解码单个视频帧
-     * @param packet 待解码的数据包
-     * @return 是否成功解码
+     * @brief 请求解码线程显示相邻的一帧后暂停
+     * @param direction 1为下一帧，-1为上一帧
+     */
+    void requestStep(int direction);
+    
+    /**
+     * @brief 获取一帧的时长（调用者需持有互斥锁）
+     * @return 时长（秒），帧率未知时为0
+     */
+    double frameDuration() const;
+    
+    /**
+     * @brief 解码单个视频帧到m_rawFrame（调用者需持有互斥锁）
+     * @param packet 待解码的数据包，为nullptr时只取出解码器中剩余的帧
+     * @return 是否得到一帧
      */
     bool decodeVideoFrame(AVPacket *packet);
     
+    /**
+     * @brief 把解码后的帧转换为图像（调用者需持有互斥锁）
+     * @param source 解码后的帧（m_rawFrame或缓存中的帧）
+     * @param image 输出转换后的图像
+     * @return 是否成功转换
+     */
+    bool convertVideoFrame(const AVFrame *source, QImage *image);
+    
+    /**
+     * @brief 打开GOP预取器（倒放和循环播放时使用，已打开时不做任何事；调用者不能持有互斥锁）
+     */
+    void openPrefetcher();
+    
+    /**
+     * @brief 跳回循环起点（调用者需持有互斥锁）
+     * @return 是否成功
+     */
+    bool seekToLoopStart();
+    
     // Thread management
     QThread *m_decodeThread;
     bool m_isRunning;
     bool m_isPaused;
+    bool m_stepPending;
+    bool m_isPrerolled;
+    bool m_seekPending;
+    qint64 m_seekCachedPts;
+    int m_stepDirection;
+    bool m_isReversing;
     mutable QMutex m_mutex;
+    QWaitCondition m_stateChanged;
     
-    // FFmpeg core components
-    AVFormatContext *m_formatCtx;
-    AVCodecContext *m_videoCodecCtx;
-    AVStream *m_videoStream;
-    int m_videoStreamIndex;
-    SwsContext *m_swsCtx;
+    // Demuxing and decoding; replaced by a prepared decoder when the next item was opened ahead
+    std::unique_ptr<MediaDecoder> m_decoder;
     
     // Video information
     double m_duration;
     double m_currentPosition;
     int m_videoWidth;
     int m_videoHeight;
+    bool m_isCoverArtOnly;
+    
+    // Looping
+    bool m_isLooping;
+    double m_loopStart;
+    double m_loopEnd;
     
     // Frame buffers
     AVFrame *m_rawFrame;
-    AVFrame *m_rgbFrame;
-    uint8_t *m_rgbBuffer;
-    int m_rgbBufferSize;
+    FrameCache m_frameCache;
+    
+    // Decodes into m_frameCache off the playback thread: the preceding GOP
+    // during reverse playback, the loop start ahead of a loop seam
+    GopPrefetcher m_gopPrefetcher;
+    
+    // Slice-parallel pixel format conversion
+    FrameConverter m_frameConverter;
     
     // Current file path
     QString m_currentFilePath;
+    
+    // Pipeline instrumentation
+    PipelineStats m_stats;
+    TraceRecorder m_trace;
 };
 
 #endif // FFMPEGWRAPPER_H
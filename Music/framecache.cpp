@@ -0,0 +1,145 @@
+#include "framecache.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+FrameCache::FrameCache(qint64 maxBytes)
+    : m_bytes(0)
+    , m_maxBytes(qMax<qint64>(0, maxBytes))
+{
+}
+
+FrameCache::~FrameCache()
+{
+    clear();
+}
+
+void FrameCache::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    evict();
+}
+
+bool FrameCache::isEnabled() const
+{
+    return m_maxBytes > 0;
+}
+
+qint64 FrameCache::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+void FrameCache::clear()
+{
+    for (auto &item : m_frames) {
+        av_frame_free(&item.second.frame);
+    }
+    m_frames.clear();
+    m_recent.clear();
+    m_bytes = 0;
+}
+
+void FrameCache::insert(const AVFrame *frame)
+{
+    const qint64 timestamp = timestampOf(frame);
+    if (!isEnabled() || timestamp == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    auto existing = m_frames.find(timestamp);
+    if (existing != m_frames.end()) {
+        remove(existing);
+    }
+
+    // 只增加解码器缓冲区的引用，数据保持解码输出的YUV格式
+    AVFrame *copy = av_frame_clone(frame);
+    if (!copy) {
+        return;
+    }
+
+    // 按实际持有的缓冲区大小计算，而不是按宽高估算（含行对齐的填充）
+    qint64 bytes = 0;
+    for (AVBufferRef *buffer : copy->buf) {
+        if (buffer) {
+            bytes += buffer->size;
+        }
+    }
+
+    m_recent.push_front(timestamp);
+    m_frames[timestamp] = Entry{ copy, bytes, m_recent.begin() };
+    m_bytes += bytes;
+    evict();
+}
+
+const AVFrame *FrameCache::findNearest(qint64 timestamp)
+{
+    if (m_frames.empty()) {
+        return nullptr;
+    }
+
+    auto after = m_frames.lower_bound(timestamp);
+    if (after == m_frames.end()) {
+        return touch(std::prev(after));
+    }
+    if (after == m_frames.begin() || after->first == timestamp) {
+        return touch(after);
+    }
+    auto before = std::prev(after);
+    return touch(timestamp - before->first <= after->first - timestamp ? before : after);
+}
+
+const AVFrame *FrameCache::findBefore(qint64 timestamp)
+{
+    auto it = m_frames.lower_bound(timestamp);
+    if (it == m_frames.begin()) {
+        return nullptr;
+    }
+    return touch(std::prev(it));
+}
+
+const AVFrame *FrameCache::findAfter(qint64 timestamp)
+{
+    auto it = m_frames.upper_bound(timestamp);
+    if (it == m_frames.end()) {
+        return nullptr;
+    }
+    return touch(it);
+}
+
+int FrameCache::frameCount() const
+{
+    return static_cast<int>(m_frames.size());
+}
+
+qint64 FrameCache::byteSize() const
+{
+    return m_bytes;
+}
+
+qint64 FrameCache::timestampOf(const AVFrame *frame)
+{
+    return frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+}
+
+const AVFrame *FrameCache::touch(std::map<qint64, Entry>::iterator it)
+{
+    m_recent.splice(m_recent.begin(), m_recent, it->second.recent);
+    return it->second.frame;
+}
+
+void FrameCache::remove(std::map<qint64, Entry>::iterator it)
+{
+    m_bytes -= it->second.bytes;
+    m_recent.erase(it->second.recent);
+    av_frame_free(&it->second.frame);
+    m_frames.erase(it);
+}
+
+void FrameCache::evict()
+{
+    while (m_bytes > m_maxBytes && !m_recent.empty()) {
+        remove(m_frames.find(m_recent.back()));
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QtGlobal>
+#include <list>
+#include <map>
+
+extern "C" {
+    struct AVFrame;
+}
+
+/**
+ * @brief 最近解码帧的LRU缓存
+ *
+ * 以帧的时间戳为键保存解码器输出的原始帧（YUV平面格式，只增加引用、不拷贝，
+ * 420格式每像素约1.5字节，远小于转换后的32位图像）。按时间戳有序保存，
+ * 可以直接取得某帧的前一帧或后一帧，逐帧后退、回到刚看过的位置时无需“跳到关键帧再向后解码”。
+ * 总字节数超过上限时淘汰最久未使用的帧。
+ * 不做线程同步，调用者负责保证同一时刻只有一个线程访问。
+ */
+class FrameCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param maxBytes 缓存的总字节数上限，0表示禁用缓存
+     */
+    explicit FrameCache(qint64 maxBytes = 0);
+
+    /**
+     * @brief 析构函数
+     */
+    ~FrameCache();
+
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+
+    /**
+     * @brief 设置总字节数上限（超出的帧立即淘汰）
+     * @param maxBytes 字节数，0表示禁用缓存
+     */
+    void setMaxBytes(qint64 maxBytes);
+
+    /**
+     * @brief 检查缓存是否启用
+     * @return 是否启用
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief 获取总字节数上限
+     * @return 字节数
+     */
+    qint64 maxBytes() const;
+
+    /**
+     * @brief 清空缓存（打开新文件时调用）
+     */
+    void clear();
+
+    /**
+     * @brief 加入一帧，相同时间戳的旧帧被替换
+     * @param frame 解码后的帧，缓存持有其引用，调用者仍需自行unref；没有时间戳的帧被忽略
+     */
+    void insert(const AVFrame *frame);
+
+    /**
+     * @brief 查找时间戳最接近的帧
+     * @param timestamp 目标时间戳（流时间基）
+     * @return 帧，缓存为空时返回nullptr；指针在下一次insert或clear前有效
+     */
+    const AVFrame *findNearest(qint64 timestamp);
+
+    /**
+     * @brief 查找时间戳早于目标的最后一帧
+     * @param timestamp 目标时间戳（流时间基）
+     * @return 帧，不存在时返回nullptr；指针在下一次insert或clear前有效
+     */
+    const AVFrame *findBefore(qint64 timestamp);
+
+    /**
+     * @brief 查找时间戳晚于目标的第一帧
+     * @param timestamp 目标时间戳（流时间基）
+     * @return 帧，不存在时返回nullptr；指针在下一次insert或clear前有效
+     */
+    const AVFrame *findAfter(qint64 timestamp);
+
+    /**
+     * @brief 获取缓存的帧数
+     * @return 帧数
+     */
+    int frameCount() const;
+
+    /**
+     * @brief 获取缓存的总字节数
+     * @return 字节数
+     */
+    qint64 byteSize() const;
+
+    /**
+     * @brief 获取帧用作键的时间戳（优先best_effort_timestamp，缺失时用pts）
+     * @param frame 解码后的帧
+     * @return 时间戳，均缺失时为AV_NOPTS_VALUE
+     */
+    static qint64 timestampOf(const AVFrame *frame);
+
+private:
+    /**
+     * @brief 缓存项
+     */
+    struct Entry {
+        AVFrame *frame;
+        qint64 bytes;
+        std::list<qint64>::iterator recent;
+    };
+
+    /**
+     * @brief 把缓存项标记为最近使用
+     * @param it 缓存项
+     * @return 缓存项中的帧
+     */
+    const AVFrame *touch(std::map<qint64, Entry>::iterator it);
+
+    /**
+     * @brief 移除缓存项并释放帧
+     * @param it 缓存项
+     */
+    void remove(std::map<qint64, Entry>::iterator it);
+
+    /**
+     * @brief 淘汰最久未使用的帧直到不超过上限
+     */
+    void evict();
+
+    // Frames ordered by timestamp, plus recency order (front is most recent)
+    std::map<qint64, Entry> m_frames;
+    std::list<qint64> m_recent;
+    qint64 m_bytes;
+    qint64 m_maxBytes;
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,144 @@
+#include "frameconverter.h"
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/frame.h>
+}
+
+FrameConverter::FrameConverter()
+    : m_fastPathEnabled(true)
+    , m_useFastPath(false)
+    , m_outputFormat(QImage::Format_RGB32)
+    , m_width(0)
+    , m_height(0)
+    , m_srcFormat(AV_PIX_FMT_NONE)
+{
+}
+
+bool FrameConverter::open(int width, int height, AVPixelFormat srcFormat)
+{
+    close();
+    return configure(width, height, srcFormat);
+}
+
+void FrameConverter::close()
+{
+    m_scaler.release();
+    m_framePool.clear();
+    m_useFastPath = false;
+    m_width = 0;
+    m_height = 0;
+    m_srcFormat = AV_PIX_FMT_NONE;
+}
+
+QImage FrameConverter::convert(const AVFrame *frame)
+{
+    // 以帧自身的参数为准，分辨率或格式在流中途变化时重新配置
+    const AVPixelFormat srcFormat = static_cast<AVPixelFormat>(frame->format);
+    if (frame->width != m_width || frame->height != m_height || srcFormat != m_srcFormat) {
+        if (!configure(frame->width, frame->height, srcFormat)) {
+            return QImage();
+        }
+    }
+
+    QImage *target = m_framePool.acquire(m_width, m_height, m_outputFormat);
+    if (!target) {
+        return QImage();
+    }
+
+    // 直接写入池中缓冲区，使用其实际（已对齐的）行跨度
+    uint8_t *bits = target->bits();
+    const int stride = static_cast<int>(target->bytesPerLine());
+
+    if (m_useFastPath) {
+        m_scaler.forEachSlice([this, frame, bits, stride](int y, int height) {
+            m_yuvConverter.convert(frame, bits, stride, y, height);
+        });
+    } else {
+        uint8_t *dst[4] = { bits, nullptr, nullptr, nullptr };
+        int dstStride[4] = { stride, 0, 0, 0 };
+        m_scaler.scale(frame, dst, dstStride);
+    }
+
+    return *target;
+}
+
+bool FrameConverter::configure(int width, int height, AVPixelFormat srcFormat)
+{
+    // 快速路径和swscale输出相同的格式，有无快速路径对界面透明
+    const AVPixelFormat dstFormat = pixelFormatFor(m_outputFormat);
+    m_useFastPath = m_fastPathEnabled && m_yuvConverter.prepare(srcFormat, dstFormat);
+
+    // 快速路径只复用SliceScaler的条带划分和线程池，不需要各条带的SwsContext，
+    // 只在回退到swscale时才创建，流中途频繁切换分辨率时省去每次的上下文初始化
+    const bool ready = m_useFastPath
+            ? m_scaler.initSlices(width, height, srcFormat, dstFormat)
+            : m_scaler.init(width, height, srcFormat, dstFormat, SWS_BILINEAR);
+    if (!ready) {
+        m_useFastPath = false;
+        m_width = 0;
+        m_height = 0;
+        m_srcFormat = AV_PIX_FMT_NONE;
+        return false;
+    }
+
+    // 帧池按分辨率分组，切换分辨率时无需清空，切回原分辨率可直接复用旧缓冲区
+    m_width = width;
+    m_height = height;
+    m_srcFormat = srcFormat;
+    return true;
+}
+
+bool FrameConverter::setOutputFormat(QImage::Format format)
+{
+    if (pixelFormatFor(format) == AV_PIX_FMT_NONE) {
+        return false;
+    }
+    m_outputFormat = format;
+    return true;
+}
+
+QImage::Format FrameConverter::outputFormat() const
+{
+    return m_outputFormat;
+}
+
+void FrameConverter::setFastPathEnabled(bool enabled)
+{
+    m_fastPathEnabled = enabled;
+}
+
+bool FrameConverter::isUsingFastPath() const
+{
+    return m_useFastPath;
+}
+
+YuvConverter &FrameConverter::yuvConverter()
+{
+    return m_yuvConverter;
+}
+
+quint64 FrameConverter::frameAllocations() const
+{
+    return m_framePool.allocationCount();
+}
+
+AVPixelFormat FrameConverter::pixelFormatFor(QImage::Format format)
+{
+    // 视频帧不透明，Alpha恒为0xFF，因此预乘与非预乘格式的内存内容相同
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return AV_PIX_FMT_RGB32;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return AV_PIX_FMT_RGBA;
+    case QImage::Format_RGB888:
+        return AV_PIX_FMT_RGB24;
+    default:
+        break;
+    }
+    return AV_PIX_FMT_NONE;
+}
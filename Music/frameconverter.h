@@ -0,0 +1,112 @@
+#ifndef FRAMECONVERTER_H
+#define FRAMECONVERTER_H
+
+#include <QImage>
+#include "slicescaler.h"
+#include "framepool.h"
+#include "yuvconverter.h"
+
+/**
+ * @brief 视频帧转换器，负责把解码帧转换为可显示的QImage
+ *
+ * 内部使用分片并行的SliceScaler完成像素格式转换，
+ * 转换结果直接写入FramePool中的缓冲区，不再额外拷贝整帧。
+ * 常见YUV格式优先走YuvConverter的SIMD快速路径，其余格式回退到swscale。
+ * 输出格式默认为Format_RGB32，可按绘制设备的原生格式调整，避免Qt绘制时再整帧转换。
+ * 转换参数跟随每一帧的实际宽高和像素格式，流中途切换分辨率或格式时自动重新配置。
+ */
+class FrameConverter
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    FrameConverter();
+
+    /**
+     * @brief 按视频参数准备转换器（之后的帧参数变化时会自动重新配置）
+     * @param width 视频宽度
+     * @param height 视频高度
+     * @param srcFormat 解码输出的像素格式
+     * @return 是否成功
+     */
+    bool open(int width, int height, AVPixelFormat srcFormat);
+
+    /**
+     * @brief 释放转换器资源
+     */
+    void close();
+
+    /**
+     * @brief 转换一帧图像
+     * @param frame 解码后的帧
+     * @return 转换后的图像，失败时返回空图像
+     */
+    QImage convert(const AVFrame *frame);
+
+    /**
+     * @brief 设置输出图像格式（下次open时生效）
+     * @param format 图像格式，支持RGB32/ARGB32(_Premultiplied)、RGBX8888/RGBA8888(_Premultiplied)和RGB888
+     * @return 不支持该格式时返回false且不做修改
+     */
+    bool setOutputFormat(QImage::Format format);
+
+    /**
+     * @brief 获取输出图像格式
+     * @return 图像格式
+     */
+    QImage::Format outputFormat() const;
+
+    /**
+     * @brief 启用或禁用SIMD快速路径（下次open时生效）
+     * @param enabled 是否启用
+     */
+    void setFastPathEnabled(bool enabled);
+
+    /**
+     * @brief 检查当前是否使用SIMD快速路径
+     * @return 是否使用
+     */
+    bool isUsingFastPath() const;
+
+    /**
+     * @brief 获取YUV快速转换器（用于选择实现或查询当前实现）
+     * @return 转换器引用
+     */
+    YuvConverter &yuvConverter();
+
+    /**
+     * @brief 获取帧池新分配的输出缓冲区总数
+     * @return 分配次数
+     */
+    quint64 frameAllocations() const;
+
+private:
+    /**
+     * @brief 按帧参数配置条带和快速路径，参数未变的条带上下文会被复用
+     * @param width 帧宽度
+     * @param height 帧高度
+     * @param srcFormat 帧像素格式
+     * @return 是否成功
+     */
+    bool configure(int width, int height, AVPixelFormat srcFormat);
+
+    /**
+     * @brief 获取与图像格式内存布局一致的FFmpeg像素格式
+     * @param format 图像格式
+     * @return 像素格式，不支持时返回AV_PIX_FMT_NONE
+     */
+    static AVPixelFormat pixelFormatFor(QImage::Format format);
+
+    SliceScaler m_scaler;
+    FramePool m_framePool;
+    YuvConverter m_yuvConverter;
+    bool m_fastPathEnabled;
+    bool m_useFastPath;
+    QImage::Format m_outputFormat;
+    int m_width;
+    int m_height;
+    AVPixelFormat m_srcFormat;
+};
+
+#endif // FRAMECONVERTER_H
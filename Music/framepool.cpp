@@ -0,0 +1,114 @@
+#include "framepool.h"
+#include <climits>
+
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+namespace {
+
+/**
+ * @brief QImage释放外部缓冲区的回调
+ */
+void freeImageBuffer(void *buffer)
+{
+    av_free(buffer);
+}
+
+} // namespace
+
+FramePool::FramePool(int capacity, int maxResolutions)
+    : m_capacity(capacity > 0 ? capacity : 1)
+    , m_maxResolutions(maxResolutions > 0 ? maxResolutions : 1)
+    , m_useCounter(0)
+    , m_allocations(0)
+{
+}
+
+QImage *FramePool::acquire(int width, int height, QImage::Format format)
+{
+    Bucket &bucket = bucketFor(width, height, format);
+    bucket.lastUsed = ++m_useCounter;
+
+    // 优先复用已无外部引用的缓冲区
+    for (QImage &image : bucket.images) {
+        if (image.isDetached()) {
+            return &image;
+        }
+    }
+
+    QImage image = allocateImage(width, height, format);
+    if (image.isNull()) {
+        return nullptr;
+    }
+    ++m_allocations;
+
+    // 分组未满时直接加入，否则轮换替换最旧的一个（旧缓冲区由持有者负责释放）
+    if (bucket.images.size() < m_capacity) {
+        bucket.images.append(std::move(image));
+        return &bucket.images.last();
+    }
+
+    bucket.next = bucket.next % m_capacity;
+    bucket.images[bucket.next] = std::move(image);
+    return &bucket.images[bucket.next++];
+}
+
+void FramePool::clear()
+{
+    m_buckets.clear();
+    m_useCounter = 0;
+}
+
+quint64 FramePool::allocationCount() const
+{
+    return m_allocations;
+}
+
+FramePool::Bucket &FramePool::bucketFor(int width, int height, QImage::Format format)
+{
+    for (Bucket &bucket : m_buckets) {
+        if (bucket.width == width && bucket.height == height && bucket.format == format) {
+            return bucket;
+        }
+    }
+
+    // 分组已满时淘汰最久未使用的分组（仍被界面持有的图像由持有者释放）
+    if (m_buckets.size() >= m_maxResolutions) {
+        int oldest = 0;
+        for (int i = 1; i < m_buckets.size(); ++i) {
+            if (m_buckets[i].lastUsed < m_buckets[oldest].lastUsed) {
+                oldest = i;
+            }
+        }
+        m_buckets.remove(oldest);
+    }
+
+    Bucket bucket;
+    bucket.width = width;
+    bucket.height = height;
+    bucket.format = format;
+    bucket.next = 0;
+    bucket.lastUsed = 0;
+    m_buckets.append(bucket);
+    return m_buckets.last();
+}
+
+QImage FramePool::allocateImage(int width, int height, QImage::Format format)
+{
+    // QImage自身只保证每行4字节对齐，这里自行分配对齐的缓冲区交给QImage管理
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qsizetype rowBytes = (static_cast<qsizetype>(width) * depth + 7) / 8;
+    const qsizetype stride = (rowBytes + kStrideAlignment - 1) / kStrideAlignment * kStrideAlignment;
+    if (width <= 0 || height <= 0 || depth <= 0 || stride > INT_MAX) {
+        return QImage();
+    }
+
+    // av_malloc按FFmpeg编译时启用的最宽指令集对齐首地址
+    uchar *buffer = static_cast<uchar *>(av_malloc(static_cast<size_t>(stride) * height));
+    if (!buffer) {
+        return QImage();
+    }
+
+    return QImage(buffer, width, height, stride, format, freeImageBuffer, buffer);
+}
@@ -0,0 +1,90 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QVector>
+
+/**
+ * @brief 视频帧缓冲池
+ *
+ * 复用已被界面线程释放的QImage缓冲区，避免每帧分配和拷贝整帧数据。
+ * 池中图像只有在没有其他引用（界面已不再持有）时才会被重新取出写入。
+ * 缓冲区首地址和行跨度按kStrideAlignment对齐，便于SIMD转换内核和swscale整块读写。
+ * 缓冲区按(宽, 高, 格式)分组保存，分辨率来回切换（如自适应码流）时旧分组仍可直接复用，
+ * 分组数超过上限时淘汰最久未使用的分组。
+ */
+class FramePool
+{
+public:
+    /**
+     * @brief 行跨度对齐字节数（满足AVX-512的64字节对齐）
+     */
+    static const int kStrideAlignment = 64;
+
+    /**
+     * @brief 构造函数
+     * @param capacity 每个分辨率分组最多保留的缓冲区数量
+     * @param maxResolutions 最多保留的分辨率分组数量
+     */
+    explicit FramePool(int capacity = 4, int maxResolutions = 3);
+
+    /**
+     * @brief 取出一个可写的缓冲区
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param format 图像格式
+     * @return 池内图像指针，调用者可直接写入其bits()，写完后拷贝（浅拷贝）交出
+     */
+    QImage *acquire(int width, int height, QImage::Format format);
+
+    /**
+     * @brief 清空缓冲池
+     */
+    void clear();
+
+    /**
+     * @brief 获取创建以来新分配的缓冲区总数（用于检查是否退化为逐帧分配）
+     * @return 分配次数
+     */
+    quint64 allocationCount() const;
+
+private:
+    /**
+     * @brief 同一尺寸和格式的缓冲区分组
+     */
+    struct Bucket {
+        int width;
+        int height;
+        QImage::Format format;
+        QVector<QImage> images;
+        int next;
+        quint64 lastUsed;
+    };
+
+    /**
+     * @brief 查找或创建对应的分组，必要时淘汰最久未使用的分组
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param format 图像格式
+     * @return 分组引用
+     */
+    Bucket &bucketFor(int width, int height, QImage::Format format);
+
+    /**
+     * @brief 分配行跨度对齐的图像
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param format 图像格式
+     * @return 图像，失败时返回空图像
+     */
+    static QImage allocateImage(int width, int height, QImage::Format format);
+
+
+    QVector<Bucket> m_buckets;
+    int m_capacity;
+    int m_maxResolutions;
+    quint64 m_useCounter;
+    quint64 m_allocations;
+};
+
+#endif // FRAMEPOOL_H
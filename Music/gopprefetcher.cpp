@@ -0,0 +1,209 @@
+#include "gopprefetcher.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+GopPrefetcher::GopPrefetcher()
+    : m_thread(nullptr)
+    , m_running(false)
+    , m_busy(false)
+    , m_requestEnd(0.0)
+    , m_requestWindow(0.0)
+    , m_coveredFrom(-1.0)
+{
+    // 预取不在显示路径上，解码线程数交给FFmpeg按核心数选择
+    m_decoder.setDecoderThreadCount(0);
+}
+
+GopPrefetcher::~GopPrefetcher()
+{
+    close();
+}
+
+void GopPrefetcher::setFrameSink(FrameSink sink)
+{
+    m_sink = std::move(sink);
+}
+
+bool GopPrefetcher::open(const QString &filePath)
+{
+    close();
+
+    if (!m_decoder.open(filePath)) {
+        m_errorString = m_decoder.errorString();
+        return false;
+    }
+
+    m_running = true;
+    m_busy = false;
+    m_coveredFrom = -1.0;
+    m_thread = QThread::create([this]() {
+        run();
+    });
+    m_thread->setObjectName("qvp-prefetch");
+    m_thread->start();
+    return true;
+}
+
+void GopPrefetcher::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        m_changed.wakeAll();
+    }
+
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_busy = false;
+    m_decoder.close();
+}
+
+bool GopPrefetcher::isOpen() const
+{
+    return m_thread != nullptr;
+}
+
+bool GopPrefetcher::request(double end, double window)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_running || m_busy) {
+        return false;
+    }
+
+    m_requestEnd = end;
+    m_requestWindow = window;
+    m_busy = true;
+    m_changed.wakeAll();
+    return true;
+}
+
+bool GopPrefetcher::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_busy;
+}
+
+bool GopPrefetcher::waitIdle(unsigned long timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_busy) {
+        if (!m_changed.wait(&m_mutex, timeoutMs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double GopPrefetcher::coveredFrom() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_coveredFrom;
+}
+
+QString GopPrefetcher::errorString() const
+{
+    return m_errorString;
+}
+
+void GopPrefetcher::run()
+{
+    for (;;) {
+        double end;
+        double window;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_running && !m_busy) {
+                m_changed.wait(&m_mutex);
+            }
+            if (!m_running) {
+                break;
+            }
+            end = m_requestEnd;
+            window = m_requestWindow;
+        }
+
+        const double coveredFrom = decodeRange(qMax(0.0, end - window), end);
+
+        QMutexLocker locker(&m_mutex);
+        m_coveredFrom = coveredFrom;
+        m_busy = false;
+        m_changed.wakeAll();
+    }
+}
+
+double GopPrefetcher::decodeRange(double start, double end)
+{
+    // 跳到起点之前的关键帧，解码器同时被清空
+    if (!m_decoder.seek(start)) {
+        return -1.0;
+    }
+
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    if (!packet || !frame) {
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        return -1.0;
+    }
+
+    // 用半帧的容差判断边界，与播放线程的接缝判断一致
+    const AVRational rate = m_decoder.frameRate();
+    const double halfFrame = rate.num > 0 && rate.den > 0 ? 0.5 * rate.den / rate.num : 0.0;
+
+    double coveredFrom = -1.0;
+    bool flushed = false;
+    while (isRunning()) {
+        const int ret = m_decoder.receiveFrame(frame);
+        if (ret == AVERROR(EAGAIN)) {
+            if (flushed) {
+                break;
+            }
+            if (m_decoder.readPacket(packet) < 0) {
+                m_decoder.sendPacket(nullptr);
+                flushed = true;
+                continue;
+            }
+            if (m_decoder.isVideoPacket(packet)) {
+                m_decoder.sendPacket(packet);
+            }
+            av_packet_unref(packet);
+            continue;
+        }
+        if (ret < 0) {
+            break;
+        }
+
+        double position = 0.0;
+        const bool hasPosition = m_decoder.framePosition(frame, &position);
+        if (hasPosition && position >= end - halfFrame) {
+            av_frame_unref(frame);
+            break;
+        }
+        // 关键帧到区间起点之间的帧只解码不交出
+        if (hasPosition && position >= start - halfFrame) {
+            if (m_sink) {
+                m_sink(frame);
+            }
+            if (coveredFrom < 0.0) {
+                coveredFrom = position;
+            }
+        }
+        av_frame_unref(frame);
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    return coveredFrom;
+}
+
+bool GopPrefetcher::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running;
+}
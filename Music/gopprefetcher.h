@@ -0,0 +1,140 @@
+#ifndef GOPPREFETCHER_H
+#define GOPPREFETCHER_H
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <functional>
+#include "mediadecoder.h"
+
+extern "C" {
+    struct AVFrame;
+}
+
+/**
+ * @brief 倒放用的GOP预取器
+ *
+ * 在独立线程中用另一个MediaDecoder（独立的文件句柄和多线程解码器）向后解码一段：
+ * 跳到目标区间起点之前的关键帧，向前解码到区间终点，把区间内的帧交给回调（通常放入解码帧缓存）。
+ * 倒放时播放线程从缓存中逆序显示当前一段，同时预取更早的一段，GOP边界处不再停顿。
+ * 区间长度由调用者按缓存容量限定，GOP很长时只保留区间内的帧，更早的部分留给下一次请求。
+ * 循环播放接近终点时也用它提前解码循环起点开始的一段，跳回起点时直接从缓存显示。
+ */
+class GopPrefetcher
+{
+public:
+    /**
+     * @brief 帧回调，在预取线程中调用，帧只在回调期间有效
+     */
+    using FrameSink = std::function<void(const AVFrame *frame)>;
+
+    /**
+     * @brief 构造函数
+     */
+    GopPrefetcher();
+
+    /**
+     * @brief 析构函数
+     */
+    ~GopPrefetcher();
+
+    GopPrefetcher(const GopPrefetcher &) = delete;
+    GopPrefetcher &operator=(const GopPrefetcher &) = delete;
+
+    /**
+     * @brief 设置帧回调（需在open之前设置）
+     * @param sink 回调
+     */
+    void setFrameSink(FrameSink sink);
+
+    /**
+     * @brief 打开文件并启动预取线程
+     * @param filePath 文件路径
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool open(const QString &filePath);
+
+    /**
+     * @brief 停止预取线程并关闭文件（会等待正在进行的请求结束）
+     */
+    void close();
+
+    /**
+     * @brief 检查是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 请求预取终点之前的一段
+     * @param end 区间终点（秒，不含）
+     * @param window 区间长度（秒）
+     * @return 上一个请求尚未完成时返回false
+     */
+    bool request(double end, double window);
+
+    /**
+     * @brief 检查是否有请求正在进行
+     * @return 是否忙
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief 等待当前请求完成
+     * @param timeoutMs 最长等待时间（毫秒）
+     * @return 是否已空闲
+     */
+    bool waitIdle(unsigned long timeoutMs);
+
+    /**
+     * @brief 获取最近完成的请求实际交出的第一帧位置
+     * @return 位置（秒），没有交出任何帧时为-1
+     */
+    double coveredFrom() const;
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+private:
+    /**
+     * @brief 预取线程主函数
+     */
+    void run();
+
+    /**
+     * @brief 解码一段并交出区间内的帧
+     * @param start 区间起点（秒）
+     * @param end 区间终点（秒，不含）
+     * @return 交出的第一帧位置，没有交出任何帧时为-1
+     */
+    double decodeRange(double start, double end);
+
+    /**
+     * @brief 检查预取线程是否应继续运行
+     * @return 是否继续
+     */
+    bool isRunning() const;
+
+    MediaDecoder m_decoder;
+    FrameSink m_sink;
+
+    // Thread management
+    QThread *m_thread;
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;
+    bool m_running;
+    bool m_busy;
+
+    // Current request and its result
+    double m_requestEnd;
+    double m_requestWindow;
+    double m_coveredFrom;
+
+    QString m_errorString;
+};
+
+#endif // GOPPREFETCHER_H
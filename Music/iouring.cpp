@@ -0,0 +1,297 @@
+#include "iouring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define QVP_HAVE_IO_URING 1
+#endif
+#endif
+
+#if defined(QVP_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+IoUring::IoUring()
+    : m_fd(-1)
+    , m_sqRing(nullptr)
+    , m_sqRingSize(0)
+    , m_cqRing(nullptr)
+    , m_cqRingSize(0)
+    , m_sqes(nullptr)
+    , m_sqesSize(0)
+    , m_sqHead(nullptr)
+    , m_sqTail(nullptr)
+    , m_sqArray(nullptr)
+    , m_sqMask(0)
+    , m_sqEntries(0)
+    , m_queued(0)
+    , m_cqHead(nullptr)
+    , m_cqTail(nullptr)
+    , m_cqes(nullptr)
+    , m_cqMask(0)
+{
+}
+
+IoUring::~IoUring()
+{
+    close();
+}
+
+#if defined(QVP_HAVE_IO_URING)
+
+namespace {
+
+/**
+ * @brief 获取共享队列中的一个字段
+ */
+inline unsigned *ringField(void *ring, unsigned offset)
+{
+    return reinterpret_cast<unsigned *>(static_cast<char *>(ring) + offset);
+}
+
+} // namespace
+
+bool IoUring::open(unsigned entries)
+{
+    close();
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    m_fd = fd;
+
+    // IORING_OP_READ与IORING_FEAT_RW_CUR_POS同在5.6加入，没有该特性时读请求会以EINVAL失败
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close();
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize, m_cqRingSize);
+    }
+
+    void *sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_sqRing = sqRing;
+
+    // 5.4起提交队列和完成队列共用一次映射
+    if (singleMap) {
+        m_cqRing = m_sqRing;
+    } else {
+        void *cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            close();
+            return false;
+        }
+        m_cqRing = cqRing;
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_sqes = sqes;
+
+    m_sqHead = ringField(m_sqRing, params.sq_off.head);
+    m_sqTail = ringField(m_sqRing, params.sq_off.tail);
+    m_sqArray = ringField(m_sqRing, params.sq_off.array);
+    m_sqMask = *ringField(m_sqRing, params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_queued = 0;
+
+    m_cqHead = ringField(m_cqRing, params.cq_off.head);
+    m_cqTail = ringField(m_cqRing, params.cq_off.tail);
+    m_cqes = static_cast<char *>(m_cqRing) + params.cq_off.cqes;
+    m_cqMask = *ringField(m_cqRing, params.cq_off.ring_mask);
+    return true;
+}
+
+void IoUring::close()
+{
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+
+    m_fd = -1;
+    m_sqRing = nullptr;
+    m_cqRing = nullptr;
+    m_sqes = nullptr;
+    m_sqHead = nullptr;
+    m_sqTail = nullptr;
+    m_sqArray = nullptr;
+    m_cqHead = nullptr;
+    m_cqTail = nullptr;
+    m_cqes = nullptr;
+    m_queued = 0;
+}
+
+bool IoUring::queueRead(int fd, void *buffer, unsigned length, qint64 offset, quint64 userData)
+{
+    if (!m_sqes) {
+        return false;
+    }
+
+    // 提交队列的头由内核推进，尾由本线程推进
+    const unsigned tail = *m_sqTail;
+    if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+        return false;
+    }
+
+    const unsigned index = tail & m_sqMask;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(m_sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = static_cast<__u64>(offset);
+    sqe->addr = reinterpret_cast<__u64>(buffer);
+    sqe->len = length;
+    sqe->user_data = userData;
+    m_sqArray[index] = index;
+
+    // 先写完请求内容再发布新的尾位置
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_queued;
+    return true;
+}
+
+bool IoUring::queueCancel(quint64 target, quint64 userData)
+{
+    if (!m_sqes) {
+        return false;
+    }
+
+    const unsigned tail = *m_sqTail;
+    if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+        return false;
+    }
+
+    const unsigned index = tail & m_sqMask;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(m_sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = userData;
+    m_sqArray[index] = index;
+
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_queued;
+    return true;
+}
+
+int IoUring::submit(unsigned waitCount)
+{
+    if (m_fd < 0) {
+        return -EBADF;
+    }
+
+    const unsigned flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        const long ret = syscall(__NR_io_uring_enter, m_fd, m_queued, waitCount, flags, nullptr, 0);
+        if (ret >= 0) {
+            m_queued -= qMin<unsigned>(m_queued, static_cast<unsigned>(ret));
+            return static_cast<int>(ret);
+        }
+        // 被信号打断时重试；等待中被打断不会丢失已提交的请求
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+bool IoUring::popCompletion(quint64 *userData, int *result)
+{
+    if (!m_cqes) {
+        return false;
+    }
+
+    // 完成队列的尾由内核推进，头由本线程推进
+    const unsigned head = *m_cqHead;
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    const io_uring_cqe *cqe = static_cast<const io_uring_cqe *>(m_cqes) + (head & m_cqMask);
+    *userData = cqe->user_data;
+    *result = cqe->res;
+
+    // 读完事件内容后才把槽位还给内核
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#else
+
+bool IoUring::open(unsigned entries)
+{
+    Q_UNUSED(entries);
+    return false;
+}
+
+void IoUring::close()
+{
+}
+
+bool IoUring::queueRead(int fd, void *buffer, unsigned length, qint64 offset, quint64 userData)
+{
+    Q_UNUSED(fd);
+    Q_UNUSED(buffer);
+    Q_UNUSED(length);
+    Q_UNUSED(offset);
+    Q_UNUSED(userData);
+    return false;
+}
+
+bool IoUring::queueCancel(quint64 target, quint64 userData)
+{
+    Q_UNUSED(target);
+    Q_UNUSED(userData);
+    return false;
+}
+
+int IoUring::submit(unsigned waitCount)
+{
+    Q_UNUSED(waitCount);
+    return -1;
+}
+
+bool IoUring::popCompletion(quint64 *userData, int *result)
+{
+    Q_UNUSED(userData);
+    Q_UNUSED(result);
+    return false;
+}
+
+#endif
+
+bool IoUring::isOpen() const
+{
+    return m_fd >= 0;
+}
@@ -0,0 +1,109 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+/**
+ * @brief io_uring提交/完成队列的最小封装（仅Linux）
+ *
+ * 直接使用io_uring_setup/io_uring_enter系统调用并映射内核共享的队列，不依赖liburing。
+ * 只提供预读需要的两种操作：按偏移读文件和取消在途请求。
+ * 内核不支持（非Linux、内核早于5.6、被seccomp禁止等）时open返回false，调用者应改用普通读取。
+ * 不做线程同步，同一时刻只能由一个线程使用。
+ */
+class IoUring
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    IoUring();
+
+    /**
+     * @brief 析构函数
+     */
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    /**
+     * @brief 创建队列
+     * @param entries 提交队列长度（内核会向上取整到2的幂）
+     * @return 内核是否支持
+     */
+    bool open(unsigned entries);
+
+    /**
+     * @brief 释放队列（调用前必须等所有在途请求完成，否则内核可能仍在写入缓冲区）
+     */
+    void close();
+
+    /**
+     * @brief 检查队列是否已创建
+     * @return 是否已创建
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 在提交队列中加入一个读请求（submit后才交给内核）
+     * @param fd 文件描述符
+     * @param buffer 目标缓冲区，请求完成前必须保持有效
+     * @param length 读取字节数
+     * @param offset 文件偏移
+     * @param userData 完成时原样返回的标识
+     * @return 提交队列已满时返回false
+     */
+    bool queueRead(int fd, void *buffer, unsigned length, qint64 offset, quint64 userData);
+
+    /**
+     * @brief 在提交队列中加入一个取消请求（取消操作本身也会产生一个完成事件）
+     * @param target 要取消的请求的标识
+     * @param userData 取消操作自身的标识
+     * @return 提交队列已满时返回false
+     */
+    bool queueCancel(quint64 target, quint64 userData);
+
+    /**
+     * @brief 把已加入的请求交给内核，并可等待完成
+     * @param waitCount 至少等待多少个完成事件，0表示不等待
+     * @return 交给内核的请求数，失败时为负的errno
+     */
+    int submit(unsigned waitCount);
+
+    /**
+     * @brief 取出一个完成事件（不等待）
+     * @param userData 输出请求的标识
+     * @param result 输出结果：读取的字节数，或负的errno
+     * @return 没有完成事件时返回false
+     */
+    bool popCompletion(quint64 *userData, int *result);
+
+private:
+    int m_fd;
+
+    // Shared ring mappings
+    void *m_sqRing;
+    size_t m_sqRingSize;
+    void *m_cqRing;
+    size_t m_cqRingSize;
+    void *m_sqes;
+    size_t m_sqesSize;
+
+    // Submission queue
+    unsigned *m_sqHead;
+    unsigned *m_sqTail;
+    unsigned *m_sqArray;
+    unsigned m_sqMask;
+    unsigned m_sqEntries;
+    unsigned m_queued;
+
+    // Completion queue
+    unsigned *m_cqHead;
+    unsigned *m_cqTail;
+    void *m_cqes;
+    unsigned m_cqMask;
+};
+
+#endif // IOURING_H
@@ -0,0 +1,351 @@
+#include "libraryindex.h"
+#include <QByteArray>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <QDateTime>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = { 'Q', 'V', 'P', 'L', 'I', 'B', '\0', '\0' };
+const quint32 kVersion = 1;
+
+/**
+ * @brief 文件头
+ */
+struct IndexHeader {
+    char magic[8];
+    quint32 version;
+    quint32 recordSize;
+    quint64 recordCount;
+    quint64 recordsOffset;
+    quint64 stringsOffset;
+    quint64 stringsSize;
+    quint64 reserved[2];
+};
+static_assert(sizeof(IndexHeader) == 64, "IndexHeader layout");
+
+/**
+ * @brief 记录中字符串字段的顺序
+ */
+enum StringField {
+    PathField,
+    TitleField,
+    ArtistField,
+    AlbumField,
+    FormatField,
+    VideoCodecField,
+    AudioCodecField,
+    StringFieldCount
+};
+
+/**
+ * @brief 定长记录，字符串为字符串表中的（偏移, 字节数）
+ */
+struct IndexRecord {
+    quint64 device;
+    quint64 inode;
+    qint64 modified;
+    qint64 size;
+    quint32 strings[StringFieldCount][2];
+    quint32 durationMs;
+    quint16 width;
+    quint16 height;
+    quint32 flags;
+    quint32 reserved;
+};
+static_assert(sizeof(IndexRecord) == 104, "IndexRecord layout");
+
+const quint32 kFlagCoverArt = 0x1;
+
+/**
+ * @brief 构建去重的字符串表
+ */
+class StringTable
+{
+public:
+    /**
+     * @brief 加入字符串
+     * @param text 字符串
+     * @param ref 输出（偏移, 字节数）
+     */
+    void add(const QString &text, quint32 ref[2])
+    {
+        const QByteArray utf8 = text.toUtf8();
+        if (utf8.isEmpty()) {
+            ref[0] = 0;
+            ref[1] = 0;
+            return;
+        }
+        auto it = m_offsets.constFind(utf8);
+        if (it == m_offsets.constEnd()) {
+            it = m_offsets.insert(utf8, static_cast<quint32>(m_data.size()));
+            m_data.append(utf8);
+        }
+        ref[0] = it.value();
+        ref[1] = static_cast<quint32>(utf8.size());
+    }
+
+    /**
+     * @brief 获取字符串表内容
+     */
+    const QByteArray &data() const
+    {
+        return m_data;
+    }
+
+private:
+    QByteArray m_data;
+    QHash<QByteArray, quint32> m_offsets;
+};
+
+} // namespace
+
+bool LibraryFileKey::fromFile(const QString &filePath, LibraryFileKey *key)
+{
+#if defined(_WIN32)
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        return false;
+    }
+    key->device = 0;
+    key->inode = qHash(info.absoluteFilePath());
+    key->modified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    key->size = info.size();
+#else
+    struct stat status;
+    if (::stat(QFile::encodeName(filePath).constData(), &status) != 0 || !S_ISREG(status.st_mode)) {
+        return false;
+    }
+    key->device = static_cast<quint64>(status.st_dev);
+    key->inode = static_cast<quint64>(status.st_ino);
+#if defined(__linux__)
+    key->modified = static_cast<qint64>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+#else
+    key->modified = static_cast<qint64>(status.st_mtime) * 1000000000;
+#endif
+    key->size = static_cast<qint64>(status.st_size);
+#endif
+    return true;
+}
+
+LibraryIndex::LibraryIndex()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_records(nullptr)
+    , m_count(0)
+    , m_strings(nullptr)
+    , m_stringsSize(0)
+{
+}
+
+LibraryIndex::~LibraryIndex()
+{
+    close();
+}
+
+bool LibraryIndex::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开索引文件：%1").arg(filePath);
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    uchar *data = size >= static_cast<qint64>(sizeof(IndexHeader)) ? m_file.map(0, size) : nullptr;
+    if (!data) {
+        m_errorString = QString("无法映射索引文件：%1").arg(filePath);
+        m_file.close();
+        return false;
+    }
+    m_data = data;
+    m_size = size;
+
+    // 版本、记录大小和各段范围都要与本程序一致，否则视为无效索引
+    IndexHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    const quint64 fileSize = static_cast<quint64>(size);
+    const bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+            && header.version == kVersion
+            && header.recordSize == sizeof(IndexRecord)
+            && header.recordCount <= 0x7fffffff
+            && header.recordsOffset % alignof(IndexRecord) == 0
+            && header.recordsOffset <= fileSize
+            && header.recordCount <= (fileSize - header.recordsOffset) / sizeof(IndexRecord)
+            && header.stringsOffset <= fileSize
+            && header.stringsSize <= fileSize - header.stringsOffset;
+    if (!valid) {
+        m_errorString = QString("索引文件格式不符：%1").arg(filePath);
+        close();
+        return false;
+    }
+
+    m_records = m_data + header.recordsOffset;
+    m_count = static_cast<int>(header.recordCount);
+    m_strings = reinterpret_cast<const char *>(m_data + header.stringsOffset);
+    m_stringsSize = header.stringsSize;
+    return true;
+}
+
+void LibraryIndex::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_records = nullptr;
+    m_count = 0;
+    m_strings = nullptr;
+    m_stringsSize = 0;
+}
+
+bool LibraryIndex::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+int LibraryIndex::count() const
+{
+    return m_count;
+}
+
+LibraryRecord LibraryIndex::record(int index) const
+{
+    const IndexRecord &data = static_cast<const IndexRecord *>(m_records)[index];
+
+    LibraryRecord record;
+    record.key = key(index);
+    record.filePath = string(data.strings[PathField][0], data.strings[PathField][1]);
+    record.title = string(data.strings[TitleField][0], data.strings[TitleField][1]);
+    record.artist = string(data.strings[ArtistField][0], data.strings[ArtistField][1]);
+    record.album = string(data.strings[AlbumField][0], data.strings[AlbumField][1]);
+    record.formatName = string(data.strings[FormatField][0], data.strings[FormatField][1]);
+    record.videoCodec = string(data.strings[VideoCodecField][0], data.strings[VideoCodecField][1]);
+    record.audioCodec = string(data.strings[AudioCodecField][0], data.strings[AudioCodecField][1]);
+    record.duration = data.durationMs / 1000.0;
+    record.width = data.width;
+    record.height = data.height;
+    record.hasCoverArt = data.flags & kFlagCoverArt;
+    return record;
+}
+
+LibraryFileKey LibraryIndex::key(int index) const
+{
+    const IndexRecord &data = static_cast<const IndexRecord *>(m_records)[index];
+
+    LibraryFileKey key;
+    key.device = data.device;
+    key.inode = data.inode;
+    key.modified = data.modified;
+    key.size = data.size;
+    return key;
+}
+
+QString LibraryIndex::filePath(int index) const
+{
+    const IndexRecord &data = static_cast<const IndexRecord *>(m_records)[index];
+    return string(data.strings[PathField][0], data.strings[PathField][1]);
+}
+
+int LibraryIndex::find(const LibraryFileKey &key) const
+{
+    int low = 0;
+    int high = m_count;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (this->key(middle) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < m_count && this->key(low).sameFile(key) ? low : -1;
+}
+
+QString LibraryIndex::errorString() const
+{
+    return m_errorString;
+}
+
+bool LibraryIndex::write(const QString &filePath, std::vector<LibraryRecord> records, QString *errorString)
+{
+    // 按身份排序后去掉重复（硬链接、重叠的扫描目录），保留先出现的一条
+    std::stable_sort(records.begin(), records.end(), [](const LibraryRecord &a, const LibraryRecord &b) {
+        return a.key < b.key;
+    });
+    records.erase(std::unique(records.begin(), records.end(), [](const LibraryRecord &a, const LibraryRecord &b) {
+        return a.key.sameFile(b.key);
+    }), records.end());
+
+    StringTable strings;
+    std::vector<IndexRecord> table(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const LibraryRecord &record = records[i];
+        IndexRecord &data = table[i];
+        std::memset(&data, 0, sizeof(data));
+        data.device = record.key.device;
+        data.inode = record.key.inode;
+        data.modified = record.key.modified;
+        data.size = record.key.size;
+        strings.add(record.filePath, data.strings[PathField]);
+        strings.add(record.title, data.strings[TitleField]);
+        strings.add(record.artist, data.strings[ArtistField]);
+        strings.add(record.album, data.strings[AlbumField]);
+        strings.add(record.formatName, data.strings[FormatField]);
+        strings.add(record.videoCodec, data.strings[VideoCodecField]);
+        strings.add(record.audioCodec, data.strings[AudioCodecField]);
+        data.durationMs = static_cast<quint32>(qBound(0.0, record.duration * 1000.0, 4294967295.0));
+        data.width = static_cast<quint16>(qBound(0, record.width, 65535));
+        data.height = static_cast<quint16>(qBound(0, record.height, 65535));
+        data.flags = record.hasCoverArt ? kFlagCoverArt : 0;
+    }
+
+    IndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recordSize = sizeof(IndexRecord);
+    header.recordCount = table.size();
+    header.recordsOffset = sizeof(IndexHeader);
+    header.stringsOffset = header.recordsOffset + table.size() * sizeof(IndexRecord);
+    header.stringsSize = static_cast<quint64>(strings.data().size());
+
+    // 写入临时文件，全部成功后才替换原索引
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) {
+            *errorString = QString("无法写入索引文件：%1").arg(filePath);
+        }
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table.data()), static_cast<qint64>(table.size() * sizeof(IndexRecord)));
+    file.write(strings.data());
+    if (!file.commit()) {
+        if (errorString) {
+            *errorString = QString("无法写入索引文件：%1").arg(filePath);
+        }
+        return false;
+    }
+    return true;
+}
+
+QString LibraryIndex::string(quint32 offset, quint32 length) const
+{
+    if (length == 0 || static_cast<quint64>(offset) + length > m_stringsSize) {
+        return QString();
+    }
+    return QString::fromUtf8(m_strings + offset, static_cast<int>(length));
+}
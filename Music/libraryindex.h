@@ -0,0 +1,202 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief 文件身份：同一设备上的inode加修改时间和大小，任一变化都说明需要重新探测
+ *
+ * 没有inode的平台（Windows）用路径的哈希代替inode，重命名后会被视为新文件。
+ */
+struct LibraryFileKey {
+    quint64 device;
+    quint64 inode;
+    qint64 modified;
+    qint64 size;
+
+    LibraryFileKey()
+        : device(0)
+        , inode(0)
+        , modified(0)
+        , size(0)
+    {
+    }
+
+    /**
+     * @brief 读取文件的身份
+     * @param filePath 文件路径
+     * @param key 输出身份
+     * @return 文件不存在或不是普通文件时返回false
+     */
+    static bool fromFile(const QString &filePath, LibraryFileKey *key);
+
+    /**
+     * @brief 只比较设备和inode（索引按此排序）
+     */
+    bool sameFile(const LibraryFileKey &other) const
+    {
+        return device == other.device && inode == other.inode;
+    }
+
+    /**
+     * @brief 比较文件和版本
+     */
+    bool operator==(const LibraryFileKey &other) const
+    {
+        return sameFile(other) && modified == other.modified && size == other.size;
+    }
+
+    /**
+     * @brief 按设备、inode排序
+     */
+    bool operator<(const LibraryFileKey &other) const
+    {
+        return device != other.device ? device < other.device : inode < other.inode;
+    }
+};
+
+/**
+ * @brief 媒体库中的一条记录（写入索引前和从索引中取出后的形式）
+ */
+struct LibraryRecord {
+    LibraryFileKey key;
+    QString filePath;
+    QString title;
+    QString artist;
+    QString album;
+    QString formatName;
+    QString videoCodec;
+    QString audioCodec;
+    double duration;
+    int width;
+    int height;
+    bool hasCoverArt;
+
+    LibraryRecord()
+        : duration(0.0)
+        , width(0)
+        , height(0)
+        , hasCoverArt(false)
+    {
+    }
+};
+
+/**
+ * @brief 媒体库的持久化二进制索引
+ *
+ * 文件由定长记录表和字符串表组成，打开时整个文件内存映射，不解析、不逐条分配，
+ * 20万条记录的库也能立即打开；记录按需读取，字符串在读取时才转成QString。
+ * 记录按（设备, inode）排序，可二分查找某个文件是否已在索引中以及是否已变化。
+ * 字符串表中相同的字符串（同一专辑、艺术家、编码器名）只存一份。
+ * 文件使用本机字节序，换机器或换版本时格式不符则open失败，重新扫描即可。
+ * 写入通过临时文件完成后整体替换，写到一半中断不会损坏旧索引；
+ * 但已打开的映射会在替换后继续指向旧内容，需重新open。
+ */
+class LibraryIndex
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    LibraryIndex();
+
+    /**
+     * @brief 析构函数
+     */
+    ~LibraryIndex();
+
+    LibraryIndex(const LibraryIndex &) = delete;
+    LibraryIndex &operator=(const LibraryIndex &) = delete;
+
+    /**
+     * @brief 映射并校验索引文件
+     * @param filePath 索引文件路径
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool open(const QString &filePath);
+
+    /**
+     * @brief 解除映射
+     */
+    void close();
+
+    /**
+     * @brief 检查是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取记录数
+     * @return 记录数
+     */
+    int count() const;
+
+    /**
+     * @brief 读取一条完整记录
+     * @param index 序号
+     * @return 记录
+     */
+    LibraryRecord record(int index) const;
+
+    /**
+     * @brief 只读取文件身份（不转换字符串）
+     * @param index 序号
+     * @return 身份
+     */
+    LibraryFileKey key(int index) const;
+
+    /**
+     * @brief 只读取文件路径
+     * @param index 序号
+     * @return 路径
+     */
+    QString filePath(int index) const;
+
+    /**
+     * @brief 按设备和inode查找记录
+     * @param key 文件身份（只比较设备和inode）
+     * @return 序号，不存在时为-1
+     */
+    int find(const LibraryFileKey &key) const;
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 把记录写成索引文件（记录会按身份排序，同一文件只保留一条）
+     * @param filePath 索引文件路径
+     * @param records 记录
+     * @param errorString 失败时输出原因，可为nullptr
+     * @return 是否成功
+     */
+    static bool write(const QString &filePath, std::vector<LibraryRecord> records, QString *errorString);
+
+private:
+    /**
+     * @brief 读取字符串表中的字符串
+     * @param offset 偏移
+     * @param length 字节数
+     * @return 字符串
+     */
+    QString string(quint32 offset, quint32 length) const;
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+
+    // Views into the mapping
+    const void *m_records;
+    int m_count;
+    const char *m_strings;
+    quint64 m_stringsSize;
+
+    QString m_errorString;
+};
+
+#endif // LIBRARYINDEX_H
@@ -0,0 +1,307 @@
+#include "librarymodel.h"
+#include "thumbnailloader.h"
+#include <QFileInfo>
+#include <QThread>
+#include <numeric>
+
+namespace {
+
+// 每次分页载入的行数，约为几屏的量
+const int kPageSize = 256;
+
+// 缓存的记录数，覆盖可见行和上下滚动的余量
+const int kRecordCacheSize = 1024;
+
+} // namespace
+
+LibraryModel::LibraryModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_buildThread(nullptr)
+    , m_buildGeneration(0)
+    , m_loaded(0)
+    , m_records(kRecordCacheSize)
+    , m_thumbnails(nullptr)
+{
+}
+
+LibraryModel::~LibraryModel()
+{
+    abandonBuild();
+}
+
+void LibraryModel::setThumbnailLoader(ThumbnailLoader *thumbnails)
+{
+    if (m_thumbnails) {
+        disconnect(m_thumbnails, nullptr, this, nullptr);
+    }
+    m_thumbnails = thumbnails;
+    m_thumbnailRows.clear();
+    if (m_thumbnails) {
+        connect(m_thumbnails, &ThumbnailLoader::thumbnailReady, this, &LibraryModel::onThumbnailReady);
+    }
+}
+
+bool LibraryModel::open(const QString &indexPath)
+{
+    abandonBuild();
+
+    std::unique_ptr<LibraryIndex> index(new LibraryIndex());
+    if (!index->open(indexPath)) {
+        m_errorString = index->errorString();
+        return false;
+    }
+
+    if (!m_index) {
+        // 首次打开：先按索引顺序显示全部记录，倒排索引建好后再按路径排序和过滤
+        beginResetModel();
+        m_index = std::move(index);
+        m_search.reset();
+        m_records.clear();
+        m_thumbnailRows.clear();
+        m_matches.resize(m_index->count());
+        std::iota(m_matches.begin(), m_matches.end(), 0);
+        m_loaded = qMin<int>(kPageSize, static_cast<int>(m_matches.size()));
+        endResetModel();
+    } else {
+        // 重新打开：旧内容继续显示，直到新的倒排索引建好
+        m_pendingIndex = std::move(index);
+    }
+
+    // 线程持有索引和倒排索引的引用，被放弃后模型可以先行释放它们
+    m_pendingSearch = std::make_shared<LibrarySearch>();
+    std::shared_ptr<LibrarySearch> search = m_pendingSearch;
+    std::shared_ptr<const LibraryIndex> target = m_pendingIndex ? m_pendingIndex : m_index;
+    m_buildClock.start();
+    m_buildThread = QThread::create([search, target]() {
+        search->build(*target);
+    });
+    m_buildThread->setObjectName("qvp-search");
+    connect(m_buildThread, &QThread::finished, m_buildThread, &QObject::deleteLater);
+
+    const quint64 generation = m_buildGeneration;
+    connect(m_buildThread, &QThread::finished, this, [this, generation]() {
+        // 断开连接之前已经排队的通知属于被放弃的建立
+        if (generation != m_buildGeneration) {
+            return;
+        }
+        const double buildMs = m_buildClock.nsecsElapsed() / 1e6;
+        m_buildThread = nullptr;
+
+        // 先算出结果再重置，重置期间不做耗时操作
+        std::vector<int> matches = m_pendingSearch->search(m_filterText);
+        beginResetModel();
+        if (m_pendingIndex) {
+            m_index = std::move(m_pendingIndex);
+        }
+        m_search = std::move(m_pendingSearch);
+        m_records.clear();
+        m_thumbnailRows.clear();
+        m_matches = std::move(matches);
+        m_loaded = qMin<int>(kPageSize, static_cast<int>(m_matches.size()));
+        endResetModel();
+
+        emit searchReady(m_search->count(), buildMs);
+        emit filterApplied(matchCount(), m_search->lastSearchMilliseconds());
+    });
+    m_buildThread->start();
+    return true;
+}
+
+void LibraryModel::close()
+{
+    abandonBuild();
+
+    beginResetModel();
+    m_search.reset();
+    m_index.reset();
+    m_records.clear();
+    m_thumbnailRows.clear();
+    m_matches = std::vector<int>();
+    m_loaded = 0;
+    endResetModel();
+}
+
+QString LibraryModel::errorString() const
+{
+    return m_errorString;
+}
+
+void LibraryModel::setFilterText(const QString &text)
+{
+    if (text == m_filterText) {
+        return;
+    }
+    m_filterText = text;
+    if (m_search) {
+        applyFilter();
+    }
+}
+
+QString LibraryModel::filterText() const
+{
+    return m_filterText;
+}
+
+bool LibraryModel::isSearchReady() const
+{
+    return m_search != nullptr;
+}
+
+int LibraryModel::matchCount() const
+{
+    return static_cast<int>(m_matches.size());
+}
+
+LibraryRecord LibraryModel::record(int row) const
+{
+    const LibraryRecord *record = cachedRecord(row);
+    return record ? *record : LibraryRecord();
+}
+
+QString LibraryModel::filePath(int row) const
+{
+    if (row < 0 || row >= m_loaded) {
+        return QString();
+    }
+    return m_index->filePath(m_matches[row]);
+}
+
+int LibraryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_loaded;
+}
+
+QVariant LibraryModel::data(const QModelIndex &index, int role) const
+{
+    const LibraryRecord *record = index.isValid() ? cachedRecord(index.row()) : nullptr;
+    if (!record) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        if (record->title.isEmpty()) {
+            return QFileInfo(record->filePath).fileName();
+        }
+        if (record->artist.isEmpty()) {
+            return record->title;
+        }
+        return record->artist + " - " + record->title;
+    case Qt::DecorationRole: {
+        if (!m_thumbnails) {
+            return QVariant();
+        }
+        if (!record->hasCoverArt) {
+            return m_thumbnails->placeholder();
+        }
+        const QImage image = m_thumbnails->thumbnail(record->filePath);
+        if (image.isNull()) {
+            m_thumbnailRows.insert(record->filePath, index.row());
+            return m_thumbnails->placeholder();
+        }
+        return image;
+    }
+    case Qt::ToolTipRole:
+    case FilePathRole:
+        return record->filePath;
+    case TitleRole:
+        return record->title;
+    case ArtistRole:
+        return record->artist;
+    case AlbumRole:
+        return record->album;
+    case DurationRole:
+        return record->duration;
+    default:
+        return QVariant();
+    }
+}
+
+bool LibraryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_loaded < matchCount();
+}
+
+void LibraryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = qMin(kPageSize, matchCount() - m_loaded);
+    if (count <= 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), m_loaded, m_loaded + count - 1);
+    m_loaded += count;
+    endInsertRows();
+}
+
+QHash<int, QByteArray> LibraryModel::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractListModel::roleNames();
+    names.insert(FilePathRole, "filePath");
+    names.insert(TitleRole, "title");
+    names.insert(ArtistRole, "artist");
+    names.insert(AlbumRole, "album");
+    names.insert(DurationRole, "duration");
+    return names;
+}
+
+void LibraryModel::onThumbnailReady(const QString &filePath)
+{
+    const auto it = m_thumbnailRows.constFind(filePath);
+    if (it == m_thumbnailRows.constEnd()) {
+        return;
+    }
+    const int row = it.value();
+    m_thumbnailRows.remove(filePath);
+    if (row < m_loaded) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {Qt::DecorationRole});
+    }
+}
+
+void LibraryModel::applyFilter()
+{
+    std::vector<int> matches = m_search->search(m_filterText);
+
+    beginResetModel();
+    m_matches = std::move(matches);
+    m_loaded = qMin<int>(kPageSize, static_cast<int>(m_matches.size()));
+    m_thumbnailRows.clear();
+    endResetModel();
+
+    // 过滤前排队的缩略图多半已不在结果的前几屏中
+    if (m_thumbnails) {
+        m_thumbnails->clearQueue();
+    }
+
+    emit filterApplied(matchCount(), m_search->lastSearchMilliseconds());
+}
+
+void LibraryModel::abandonBuild()
+{
+    if (m_buildThread) {
+        // 建立过程不可中断，也不在界面线程等待：线程跑完后自行删除，结果丢弃
+        disconnect(m_buildThread, nullptr, this, nullptr);
+        m_buildThread = nullptr;
+    }
+    ++m_buildGeneration;
+    m_pendingSearch.reset();
+    m_pendingIndex.reset();
+}
+
+const LibraryRecord *LibraryModel::cachedRecord(int row) const
+{
+    if (row < 0 || row >= m_loaded) {
+        return nullptr;
+    }
+
+    const int indexRow = m_matches[row];
+    LibraryRecord *record = m_records.object(indexRow);
+    if (!record) {
+        record = new LibraryRecord(m_index->record(indexRow));
+        m_records.insert(indexRow, record);
+    }
+    return record;
+}
@@ -0,0 +1,185 @@
+#ifndef LIBRARYMODEL_H
+#define LIBRARYMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "libraryindex.h"
+#include "librarysearch.h"
+
+class QThread;
+class ThumbnailLoader;
+
+/**
+ * @brief 媒体库列表模型：按搜索结果分页提供行，数据按需从索引读取
+ *
+ * 索引内存映射后立即可用，倒排索引在后台线程建立，建好之前显示全部记录、暂不过滤。
+ * 行数随视图滚动通过canFetchMore/fetchMore分页增长，视图只为可见行取数据；
+ * 取出的记录放在一个小缓存中，重绘不会重复转换字符串；有封面的行按需异步加载缩略图。
+ * 重新open同一个（已被更新的）索引时，旧内容一直显示到新的倒排索引建好，然后整体替换。
+ */
+class LibraryModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 自定义数据角色
+     */
+    enum Roles {
+        FilePathRole = Qt::UserRole + 1,
+        TitleRole,
+        ArtistRole,
+        AlbumRole,
+        DurationRole
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit LibraryModel(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（正在进行的后台建立被放弃，线程结束后自行释放）
+     */
+    ~LibraryModel() override;
+
+    /**
+     * @brief 设置缩略图加载器
+     * @param thumbnails 加载器，可为nullptr（不显示封面），生命周期需长于本模型
+     */
+    void setThumbnailLoader(ThumbnailLoader *thumbnails);
+
+    /**
+     * @brief 打开（或重新打开）媒体库索引，并在后台建立倒排索引
+     * @param indexPath 索引文件
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool open(const QString &indexPath);
+
+    /**
+     * @brief 关闭索引，清空模型
+     */
+    void close();
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 设置过滤文本（倒排索引建好后才生效）
+     * @param text 查询文本，按空白分词，每个词都须匹配
+     */
+    void setFilterText(const QString &text);
+
+    /**
+     * @brief 获取过滤文本
+     * @return 查询文本
+     */
+    QString filterText() const;
+
+    /**
+     * @brief 检查倒排索引是否已建好
+     * @return 是否已建好
+     */
+    bool isSearchReady() const;
+
+    /**
+     * @brief 获取匹配的记录总数（含尚未分页载入的）
+     * @return 记录数
+     */
+    int matchCount() const;
+
+    /**
+     * @brief 获取某行的完整记录
+     * @param row 行号
+     * @return 记录
+     */
+    LibraryRecord record(int row) const;
+
+    /**
+     * @brief 获取某行的文件路径
+     * @param row 行号
+     * @return 路径
+     */
+    QString filePath(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    /**
+     * @brief 倒排索引已建好（或已替换为新索引的）
+     * @param records 记录数
+     * @param milliseconds 建立耗时
+     */
+    void searchReady(int records, double milliseconds);
+
+    /**
+     * @brief 过滤已生效
+     * @param matches 匹配的记录总数
+     * @param milliseconds 搜索耗时
+     */
+    void filterApplied(int matches, double milliseconds);
+
+private slots:
+    /**
+     * @brief 缩略图已加载
+     * @param filePath 媒体文件路径
+     */
+    void onThumbnailReady(const QString &filePath);
+
+private:
+    /**
+     * @brief 按当前过滤文本重新求匹配并重置模型
+     */
+    void applyFilter();
+
+    /**
+     * @brief 放弃正在进行的后台建立，不等待它结束
+     *
+     * 线程独立持有它读取的索引和正在建立的倒排索引，结束后自行释放；其结果按代数丢弃。
+     */
+    void abandonBuild();
+
+    /**
+     * @brief 读取记录（经过缓存）
+     * @param row 行号
+     * @return 记录，行号无效时为空
+     */
+    const LibraryRecord *cachedRecord(int row) const;
+
+    std::shared_ptr<LibraryIndex> m_index;
+    std::shared_ptr<LibrarySearch> m_search;
+    QString m_errorString;
+
+    // Index and search being built on the background thread
+    std::shared_ptr<LibraryIndex> m_pendingIndex;
+    std::shared_ptr<LibrarySearch> m_pendingSearch;
+    QThread *m_buildThread;
+    quint64 m_buildGeneration;
+    QElapsedTimer m_buildClock;
+
+    // Current matches (index rows); only the first m_loaded are exposed
+    QString m_filterText;
+    std::vector<int> m_matches;
+    int m_loaded;
+
+    mutable QCache<int, LibraryRecord> m_records;
+
+    // Rows waiting for a thumbnail, keyed by file path
+    ThumbnailLoader *m_thumbnails;
+    mutable QHash<QString, int> m_thumbnailRows;
+};
+
+#endif // LIBRARYMODEL_H
@@ -0,0 +1,201 @@
+#include "libraryscanner.h"
+#include "mediaprober.h"
+#include "workstealingpool.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <iterator>
+
+LibraryScanner::LibraryScanner()
+    : m_threadCount(0)
+    , m_previous(nullptr)
+    , m_pool(nullptr)
+    , m_canceled(false)
+    , m_directories(0)
+    , m_files(0)
+    , m_probed(0)
+    , m_reused(0)
+    , m_failed(0)
+    , m_steals(0)
+    , m_seconds(0.0)
+{
+    setSuffixes(defaultSuffixes());
+}
+
+LibraryScanner::~LibraryScanner()
+{
+}
+
+void LibraryScanner::setThreadCount(int count)
+{
+    m_threadCount = qMax(0, count);
+}
+
+void LibraryScanner::setSuffixes(const QStringList &suffixes)
+{
+    m_suffixes.clear();
+    for (const QString &suffix : suffixes) {
+        m_suffixes.insert(suffix.toLower());
+    }
+}
+
+void LibraryScanner::setPreviousIndex(const LibraryIndex *previous)
+{
+    m_previous = previous;
+}
+
+bool LibraryScanner::scan(const QStringList &roots)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    m_canceled = false;
+    m_directories = 0;
+    m_files = 0;
+    m_probed = 0;
+    m_reused = 0;
+    m_failed = 0;
+
+    {
+        WorkStealingPool pool("qvp-scan", m_threadCount);
+        m_pool = &pool;
+        m_results.assign(pool.threadCount(), std::vector<LibraryRecord>());
+        for (const QString &root : roots) {
+            pool.submit([this, root]() {
+                scanDirectory(root);
+            });
+        }
+        pool.waitForDone();
+        m_steals = pool.stealCount();
+        m_pool = nullptr;
+    }
+
+    m_seconds = clock.nsecsElapsed() / 1e9;
+    return !m_canceled;
+}
+
+void LibraryScanner::cancel()
+{
+    m_canceled = true;
+}
+
+std::vector<LibraryRecord> LibraryScanner::takeRecords()
+{
+    size_t total = 0;
+    for (const std::vector<LibraryRecord> &results : m_results) {
+        total += results.size();
+    }
+
+    std::vector<LibraryRecord> records;
+    records.reserve(total);
+    for (std::vector<LibraryRecord> &results : m_results) {
+        std::move(results.begin(), results.end(), std::back_inserter(records));
+    }
+    m_results.clear();
+    return records;
+}
+
+LibraryScanner::Stats LibraryScanner::stats() const
+{
+    Stats stats;
+    stats.directories = m_directories;
+    stats.files = m_files;
+    stats.probed = m_probed;
+    stats.reused = m_reused;
+    stats.failed = m_failed;
+    stats.steals = m_steals;
+    stats.seconds = m_seconds;
+    return stats;
+}
+
+QStringList LibraryScanner::defaultSuffixes()
+{
+    return QStringList()
+            << "mp3" << "flac" << "m4a" << "aac" << "ogg" << "opus" << "wav" << "wma" << "ape" << "alac"
+            << "mp4" << "m4v" << "mkv" << "webm" << "avi" << "mov" << "wmv" << "flv" << "ts" << "mpg" << "mpeg";
+}
+
+bool LibraryScanner::probeFile(const QString &filePath, const LibraryFileKey &key, LibraryRecord *record)
+{
+    // 索引只记录有没有封面，不复制封面数据
+    MediaProber prober;
+    prober.setCoverArtEnabled(false);
+    MediaInfo info;
+    if (!prober.probe(filePath, &info)) {
+        return false;
+    }
+
+    record->key = key;
+    record->filePath = filePath;
+    record->title = info.title;
+    record->artist = info.artist;
+    record->album = info.album;
+    record->formatName = info.formatName;
+    record->videoCodec = info.videoCodec;
+    record->audioCodec = info.audioCodec;
+    record->duration = info.duration;
+    record->width = info.width;
+    record->height = info.height;
+    record->hasCoverArt = info.hasCoverArt;
+    return true;
+}
+
+void LibraryScanner::scanDirectory(const QString &dirPath)
+{
+    if (m_canceled) {
+        return;
+    }
+    ++m_directories;
+
+    // 不跟随符号链接，避免目录环和重复收录
+    const QFileInfoList entries = QDir(dirPath).entryInfoList(
+                QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDir::NoSort);
+    for (const QFileInfo &entry : entries) {
+        const QString path = entry.absoluteFilePath();
+        if (entry.isDir()) {
+            m_pool->submit([this, path]() {
+                scanDirectory(path);
+            });
+        } else if (m_suffixes.contains(entry.suffix().toLower())) {
+            m_pool->submit([this, path]() {
+                scanFile(path);
+            });
+        }
+    }
+}
+
+void LibraryScanner::scanFile(const QString &filePath)
+{
+    if (m_canceled) {
+        return;
+    }
+    ++m_files;
+
+    LibraryFileKey key;
+    if (!LibraryFileKey::fromFile(filePath, &key)) {
+        ++m_failed;
+        return;
+    }
+
+    std::vector<LibraryRecord> &results = m_results[WorkStealingPool::currentWorker()];
+
+    // 身份与上次一致（同一inode，修改时间和大小未变）时沿用旧记录；文件被改名时更新路径
+    if (m_previous) {
+        const int index = m_previous->find(key);
+        if (index >= 0 && m_previous->key(index) == key) {
+            LibraryRecord record = m_previous->record(index);
+            record.filePath = filePath;
+            results.push_back(record);
+            ++m_reused;
+            return;
+        }
+    }
+
+    LibraryRecord record;
+    if (!probeFile(filePath, key, &record)) {
+        ++m_failed;
+        return;
+    }
+    results.push_back(record);
+    ++m_probed;
+}
@@ -0,0 +1,140 @@
+#ifndef LIBRARYSCANNER_H
+#define LIBRARYSCANNER_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+#include "libraryindex.h"
+
+class WorkStealingPool;
+
+/**
+ * @brief 媒体库扫描器
+ *
+ * 在工作窃取线程池中并行遍历目录：每个目录和每个媒体文件都是一个任务，
+ * 目录任务列出子项后把子目录和文件作为子任务提交，大目录会被空闲线程分走。
+ * 文件任务先比较文件身份（inode、修改时间、大小），与上次索引一致时直接沿用旧记录；
+ * 否则用MediaProber只读文件头取得标签和流信息，不打开解码器。
+ * scan阻塞直到完成，可在其他线程调用cancel提前结束。
+ */
+class LibraryScanner
+{
+public:
+    /**
+     * @brief 扫描统计
+     */
+    struct Stats {
+        quint64 directories;
+        quint64 files;
+        quint64 probed;
+        quint64 reused;
+        quint64 failed;
+        quint64 steals;
+        double seconds;
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    LibraryScanner();
+
+    /**
+     * @brief 析构函数
+     */
+    ~LibraryScanner();
+
+    LibraryScanner(const LibraryScanner &) = delete;
+    LibraryScanner &operator=(const LibraryScanner &) = delete;
+
+    /**
+     * @brief 设置工作线程数
+     * @param count 线程数，0表示CPU核心数
+     */
+    void setThreadCount(int count);
+
+    /**
+     * @brief 设置要收录的文件扩展名（小写，不含点）
+     * @param suffixes 扩展名
+     */
+    void setSuffixes(const QStringList &suffixes);
+
+    /**
+     * @brief 设置上次的索引，未变化的文件沿用其中的记录（扫描期间须保持打开）
+     * @param previous 索引，为nullptr时全部重新探测
+     */
+    void setPreviousIndex(const LibraryIndex *previous);
+
+    /**
+     * @brief 扫描目录（阻塞）
+     * @param roots 根目录
+     * @return 是否完成（被cancel时返回false）
+     */
+    bool scan(const QStringList &roots);
+
+    /**
+     * @brief 请求提前结束扫描（可在任意线程调用）
+     */
+    void cancel();
+
+    /**
+     * @brief 取走扫描结果
+     * @return 记录（未排序）
+     */
+    std::vector<LibraryRecord> takeRecords();
+
+    /**
+     * @brief 获取统计
+     * @return 统计
+     */
+    Stats stats() const;
+
+    /**
+     * @brief 获取默认收录的扩展名（常见音频和视频格式）
+     * @return 扩展名
+     */
+    static QStringList defaultSuffixes();
+
+    /**
+     * @brief 探测单个文件得到记录（不查上次的索引）
+     * @param filePath 文件路径
+     * @param key 文件身份
+     * @param record 输出记录
+     * @return 是否成功
+     */
+    static bool probeFile(const QString &filePath, const LibraryFileKey &key, LibraryRecord *record);
+
+private:
+    /**
+     * @brief 列出目录，子目录和媒体文件作为子任务提交
+     * @param dirPath 目录路径
+     */
+    void scanDirectory(const QString &dirPath);
+
+    /**
+     * @brief 处理一个文件：沿用旧记录或重新探测，结果放入当前线程的结果表
+     * @param filePath 文件路径
+     */
+    void scanFile(const QString &filePath);
+
+    int m_threadCount;
+    QSet<QString> m_suffixes;
+    const LibraryIndex *m_previous;
+
+    // Valid during scan(); each worker appends to its own result list
+    WorkStealingPool *m_pool;
+    std::vector<std::vector<LibraryRecord>> m_results;
+    std::atomic<bool> m_canceled;
+
+    // Counters
+    std::atomic<quint64> m_directories;
+    std::atomic<quint64> m_files;
+    std::atomic<quint64> m_probed;
+    std::atomic<quint64> m_reused;
+    std::atomic<quint64> m_failed;
+    quint64 m_steals;
+    double m_seconds;
+};
+
+#endif // LIBRARYSCANNER_H
@@ -0,0 +1,376 @@
+#include "librarysearch.h"
+#include "libraryindex.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringView>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// 字段之间的分隔符，同时作为字段末尾的填充，使每个位置都有一个以它开头的片段
+const QChar kSeparator = QLatin1Char('\n');
+
+// 继续输入时，上次结果不超过这么多条才直接筛选，否则重新查倒排表更快
+const size_t kRefineLimit = 20000;
+
+/**
+ * @brief 由三个UTF-16码元组成片段键，键的大小顺序与前缀顺序一致
+ */
+inline quint64 trigramKey(ushort c0, ushort c1, ushort c2)
+{
+    return (quint64(c0) << 32) | (quint64(c1) << 16) | c2;
+}
+
+/**
+ * @brief 大小写折叠，并去掉会与分隔符混淆的换行
+ */
+QString fold(const QString &text)
+{
+    QString folded = text.toCaseFolded();
+    folded.replace(kSeparator, QLatin1Char(' '));
+    return folded;
+}
+
+/**
+ * @brief 求已排序文档号与一段倒排表的交集（结果写回docs）
+ */
+void intersect(std::vector<quint32> *docs, const quint32 *begin, const quint32 *end)
+{
+    const size_t listSize = end - begin;
+    size_t kept = 0;
+
+    if (docs->size() * 16 < listSize) {
+        // 候选远少于倒排表时逐个二分查找，不必走完整个表
+        const quint32 *cursor = begin;
+        for (const quint32 doc : *docs) {
+            cursor = std::lower_bound(cursor, end, doc);
+            if (cursor == end) {
+                break;
+            }
+            if (*cursor == doc) {
+                (*docs)[kept++] = doc;
+            }
+        }
+    } else {
+        const quint32 *cursor = begin;
+        for (const quint32 doc : *docs) {
+            while (cursor != end && *cursor < doc) {
+                ++cursor;
+            }
+            if (cursor == end) {
+                break;
+            }
+            if (*cursor == doc) {
+                (*docs)[kept++] = doc;
+            }
+        }
+    }
+    docs->resize(kept);
+}
+
+} // namespace
+
+LibrarySearch::LibrarySearch()
+    : m_lastSearchMs(0.0)
+{
+}
+
+void LibrarySearch::build(const LibraryIndex &index)
+{
+    clear();
+    const int count = index.count();
+
+    // 文档号按路径排序分配，同一目录（通常是同一专辑）的文件排在一起
+    std::vector<QString> paths(count);
+    for (int i = 0; i < count; ++i) {
+        paths[i] = index.filePath(i);
+    }
+    m_rows.resize(count);
+    std::iota(m_rows.begin(), m_rows.end(), 0);
+    std::sort(m_rows.begin(), m_rows.end(), [&paths](int a, int b) {
+        return paths[a] < paths[b];
+    });
+
+    // 折叠后的可搜索文本：标题、艺术家、专辑、文件名、所在目录名
+    m_textOffsets.reserve(count + 1);
+    for (int doc = 0; doc < count; ++doc) {
+        const LibraryRecord record = index.record(m_rows[doc]);
+        const QString &filePath = paths[m_rows[doc]];
+        const int nameStart = filePath.lastIndexOf(QLatin1Char('/')) + 1;
+        const int dirStart = nameStart > 1 ? filePath.lastIndexOf(QLatin1Char('/'), nameStart - 2) + 1 : 0;
+
+        m_textOffsets.push_back(m_text.size());
+        m_text += fold(record.title);
+        m_text += kSeparator;
+        m_text += fold(record.artist);
+        m_text += kSeparator;
+        m_text += fold(record.album);
+        m_text += kSeparator;
+        m_text += fold(filePath.mid(nameStart));
+        m_text += kSeparator;
+        m_text += fold(filePath.mid(dirStart, qMax(0, nameStart - 1 - dirStart)));
+    }
+    m_textOffsets.push_back(m_text.size());
+    paths = std::vector<QString>();
+
+    // 第一遍：片段编号，记下每个文档含有的（去重的）片段编号并计数
+    QHash<quint64, quint32> ids;
+    std::vector<quint64> idKeys;
+    std::vector<quint32> idCounts;
+    std::vector<quint32> docIds;
+    std::vector<quint32> docStarts(count + 1);
+    std::vector<quint32> scratch;
+    const ushort *text = reinterpret_cast<const ushort *>(m_text.constData());
+    const ushort separator = kSeparator.unicode();
+
+    for (int doc = 0; doc < count; ++doc) {
+        scratch.clear();
+        const quint32 end = m_textOffsets[doc + 1];
+        for (quint32 i = m_textOffsets[doc]; i < end; ++i) {
+            if (text[i] == separator) {
+                continue;
+            }
+            // 字段末尾不足三个字符时用分隔符补齐
+            const ushort c1 = i + 1 < end ? text[i + 1] : separator;
+            const ushort c2 = (c1 != separator && i + 2 < end) ? text[i + 2] : separator;
+            const quint64 key = trigramKey(text[i], c1, c2);
+
+            auto it = ids.constFind(key);
+            if (it == ids.constEnd()) {
+                it = ids.insert(key, static_cast<quint32>(idKeys.size()));
+                idKeys.push_back(key);
+                idCounts.push_back(0);
+            }
+            scratch.push_back(it.value());
+        }
+
+        std::sort(scratch.begin(), scratch.end());
+        scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+        docStarts[doc] = static_cast<quint32>(docIds.size());
+        for (const quint32 id : scratch) {
+            ++idCounts[id];
+        }
+        docIds.insert(docIds.end(), scratch.begin(), scratch.end());
+    }
+    docStarts[count] = static_cast<quint32>(docIds.size());
+    ids.clear();
+
+    // 片段按键排序，使短词可以按前缀取出一段连续的键
+    std::vector<quint32> order(idKeys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&idKeys](quint32 a, quint32 b) {
+        return idKeys[a] < idKeys[b];
+    });
+    std::vector<quint32> rank(idKeys.size());
+    m_keys.resize(idKeys.size());
+    m_offsets.resize(idKeys.size() + 1);
+    quint32 offset = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        rank[order[i]] = static_cast<quint32>(i);
+        m_keys[i] = idKeys[order[i]];
+        m_offsets[i] = offset;
+        offset += idCounts[order[i]];
+    }
+    m_offsets[order.size()] = offset;
+
+    // 第二遍：按文档号顺序填入，每个倒排表自然升序
+    m_postings.resize(offset);
+    std::vector<quint32> cursor(m_offsets.begin(), m_offsets.end() - 1);
+    for (int doc = 0; doc < count; ++doc) {
+        for (quint32 i = docStarts[doc]; i < docStarts[doc + 1]; ++i) {
+            m_postings[cursor[rank[docIds[i]]]++] = static_cast<quint32>(doc);
+        }
+    }
+}
+
+void LibrarySearch::clear()
+{
+    m_keys = std::vector<quint64>();
+    m_offsets = std::vector<quint32>();
+    m_postings = std::vector<quint32>();
+    m_text.clear();
+    m_textOffsets = std::vector<quint32>();
+    m_rows = std::vector<int>();
+    m_lastQuery.clear();
+    m_lastDocs = std::vector<quint32>();
+}
+
+int LibrarySearch::count() const
+{
+    return static_cast<int>(m_rows.size());
+}
+
+std::vector<int> LibrarySearch::search(const QString &query)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    const QString folded = query.toCaseFolded().simplified();
+    std::vector<quint32> docs;
+
+    if (folded.isEmpty()) {
+        docs.resize(m_rows.size());
+        std::iota(docs.begin(), docs.end(), 0);
+    } else {
+        QStringList terms = folded.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+
+        if (!m_lastQuery.isEmpty() && folded.startsWith(m_lastQuery) && m_lastDocs.size() <= kRefineLimit) {
+            // 继续输入只会缩小结果，在上次结果中筛选
+            for (const quint32 doc : m_lastDocs) {
+                if (containsAll(doc, terms)) {
+                    docs.push_back(doc);
+                }
+            }
+        } else {
+            // 先处理长词，其倒排表交集最小，短词随后直接在候选中用原文筛选
+            std::sort(terms.begin(), terms.end(), [](const QString &a, const QString &b) {
+                return a.size() > b.size();
+            });
+            bool limited = false;
+            for (const QString &term : terms) {
+                matchTerm(term, &docs, &limited);
+                if (limited && docs.empty()) {
+                    break;
+                }
+            }
+
+            // 片段都出现不代表整个词出现，长于3的词用原文确认
+            QStringList longTerms;
+            for (const QString &term : terms) {
+                if (term.size() > 3) {
+                    longTerms.append(term);
+                }
+            }
+            if (!longTerms.isEmpty()) {
+                size_t kept = 0;
+                for (const quint32 doc : docs) {
+                    if (containsAll(doc, longTerms)) {
+                        docs[kept++] = doc;
+                    }
+                }
+                docs.resize(kept);
+            }
+        }
+    }
+
+    m_lastQuery = folded;
+    m_lastDocs = docs;
+
+    std::vector<int> rows;
+    rows.reserve(docs.size());
+    for (const quint32 doc : docs) {
+        rows.push_back(m_rows[doc]);
+    }
+    m_lastSearchMs = clock.nsecsElapsed() / 1e6;
+    return rows;
+}
+
+double LibrarySearch::lastSearchMilliseconds() const
+{
+    return m_lastSearchMs;
+}
+
+qint64 LibrarySearch::memoryUsage() const
+{
+    return static_cast<qint64>(m_keys.capacity() * sizeof(quint64)
+                               + (m_offsets.capacity() + m_postings.capacity()
+                                  + m_textOffsets.capacity() + m_lastDocs.capacity()) * sizeof(quint32)
+                               + m_rows.capacity() * sizeof(int))
+           + m_text.capacity() * static_cast<qint64>(sizeof(QChar));
+}
+
+void LibrarySearch::matchTerm(const QString &term, std::vector<quint32> *candidates, bool *limited) const
+{
+    const ushort *chars = reinterpret_cast<const ushort *>(term.constData());
+
+    if (term.size() >= 3) {
+        // 取全部片段的倒排表，从最短的开始求交集
+        std::vector<std::pair<quint32, quint32>> lists;
+        for (int i = 0; i + 2 < term.size(); ++i) {
+            quint32 begin;
+            quint32 end;
+            if (!postings(trigramKey(chars[i], chars[i + 1], chars[i + 2]), &begin, &end)) {
+                candidates->clear();
+                *limited = true;
+                return;
+            }
+            lists.emplace_back(begin, end);
+        }
+        std::sort(lists.begin(), lists.end(), [](const std::pair<quint32, quint32> &a,
+                                                 const std::pair<quint32, quint32> &b) {
+            return a.second - a.first < b.second - b.first;
+        });
+
+        size_t first = 0;
+        if (!*limited) {
+            candidates->assign(m_postings.begin() + lists[0].first, m_postings.begin() + lists[0].second);
+            *limited = true;
+            first = 1;
+        }
+        for (size_t i = first; i < lists.size() && !candidates->empty(); ++i) {
+            intersect(candidates, m_postings.data() + lists[i].first, m_postings.data() + lists[i].second);
+        }
+        return;
+    }
+
+    if (*limited) {
+        // 候选已经很少，直接用原文筛选
+        const QStringList terms(term);
+        size_t kept = 0;
+        for (const quint32 doc : *candidates) {
+            if (containsAll(doc, terms)) {
+                (*candidates)[kept++] = doc;
+            }
+        }
+        candidates->resize(kept);
+        return;
+    }
+
+    // 一两个字符的词：以它开头的片段在键上连续，合并这一段倒排表
+    const quint64 low = term.size() == 2 ? trigramKey(chars[0], chars[1], 0) : trigramKey(chars[0], 0, 0);
+    const quint64 high = term.size() == 2 ? low | 0xFFFF : low | 0xFFFFFFFF;
+    const auto first = std::lower_bound(m_keys.begin(), m_keys.end(), low);
+    const auto last = std::upper_bound(first, m_keys.end(), high);
+
+    std::vector<quint64> bits((m_rows.size() + 63) / 64, 0);
+    const quint32 begin = m_offsets[first - m_keys.begin()];
+    const quint32 end = m_offsets[last - m_keys.begin()];
+    for (quint32 i = begin; i < end; ++i) {
+        bits[m_postings[i] >> 6] |= quint64(1) << (m_postings[i] & 63);
+    }
+
+    candidates->clear();
+    for (size_t word = 0; word < bits.size(); ++word) {
+        quint64 value = bits[word];
+        while (value) {
+            candidates->push_back(static_cast<quint32>(word * 64 + qCountTrailingZeroBits(value)));
+            value &= value - 1;
+        }
+    }
+    *limited = true;
+}
+
+bool LibrarySearch::containsAll(quint32 doc, const QStringList &terms) const
+{
+    const QStringView text(m_text.constData() + m_textOffsets[doc], m_textOffsets[doc + 1] - m_textOffsets[doc]);
+    for (const QString &term : terms) {
+        if (!text.contains(term)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibrarySearch::postings(quint64 key, quint32 *begin, quint32 *end) const
+{
+    const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+    if (it == m_keys.end() || *it != key) {
+        return false;
+    }
+    const size_t index = it - m_keys.begin();
+    *begin = m_offsets[index];
+    *end = m_offsets[index + 1];
+    return true;
+}
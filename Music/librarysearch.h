@@ -0,0 +1,108 @@
+#ifndef LIBRARYSEARCH_H
+#define LIBRARYSEARCH_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class LibraryIndex;
+
+/**
+ * @brief 媒体库的内存倒排索引，支持边输入边搜索
+ *
+ * 对每条记录的标题、艺术家、专辑、文件名和所在目录名做大小写折叠，
+ * 按三字符片段（trigram）建立倒排表：片段 -> 包含它的文档号（升序）。
+ * 查询按空白拆成若干词，每个词都须出现在某个字段中：
+ * - 长度不小于3的词取其全部片段的倒排表求交集，长于3的再用原文确认
+ * - 长度为1或2的词取以它开头的一段片段（键连续）的倒排表求并集
+ * 新查询是上一次查询的延续（继续输入）且上次结果不多时，直接在上次结果中筛选。
+ * 文档号按文件路径排序分配，结果天然按路径有序，不需要再排序。
+ * 建立索引可在任意线程进行；建好后只读，查询只能在一个线程中进行（保存了上次的结果）。
+ */
+class LibrarySearch
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    LibrarySearch();
+
+    /**
+     * @brief 从媒体库索引建立倒排索引（20万条约需数百毫秒，应在后台线程调用）
+     * @param index 已打开的媒体库索引
+     */
+    void build(const LibraryIndex &index);
+
+    /**
+     * @brief 清空
+     */
+    void clear();
+
+    /**
+     * @brief 获取文档数
+     * @return 文档数（等于建立时索引的记录数）
+     */
+    int count() const;
+
+    /**
+     * @brief 搜索
+     * @param query 查询文本，为空时返回全部记录
+     * @return 匹配记录在媒体库索引中的序号，按文件路径排序
+     */
+    std::vector<int> search(const QString &query);
+
+    /**
+     * @brief 获取上一次搜索的耗时
+     * @return 毫秒数
+     */
+    double lastSearchMilliseconds() const;
+
+    /**
+     * @brief 获取倒排索引和折叠后文本占用的内存
+     * @return 字节数
+     */
+    qint64 memoryUsage() const;
+
+private:
+    /**
+     * @brief 求一个词的候选文档（长词为片段交集，短词为片段并集）
+     * @param term 已折叠的词
+     * @param candidates 输入已有候选（为空表示尚未限定），输出与本词的交集
+     * @param limited 候选是否已被限定
+     */
+    void matchTerm(const QString &term, std::vector<quint32> *candidates, bool *limited) const;
+
+    /**
+     * @brief 用原文确认文档包含全部词
+     * @param doc 文档号
+     * @param terms 已折叠的词
+     * @return 是否包含
+     */
+    bool containsAll(quint32 doc, const QStringList &terms) const;
+
+    /**
+     * @brief 查找片段的倒排表
+     * @param key 片段
+     * @param begin 输出起始位置
+     * @param end 输出结束位置
+     * @return 片段不存在时返回false
+     */
+    bool postings(quint64 key, quint32 *begin, quint32 *end) const;
+
+    // Inverted index: sorted trigram keys, CSR offsets into the posting array
+    std::vector<quint64> m_keys;
+    std::vector<quint32> m_offsets;
+    std::vector<quint32> m_postings;
+
+    // Per-document folded text (fields joined by '\n') and index row
+    QString m_text;
+    std::vector<quint32> m_textOffsets;
+    std::vector<int> m_rows;
+
+    // State of the previous query, reused while the user keeps typing
+    QString m_lastQuery;
+    std::vector<quint32> m_lastDocs;
+    double m_lastSearchMs;
+};
+
+#endif // LIBRARYSEARCH_H
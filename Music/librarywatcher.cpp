@@ -0,0 +1,452 @@
+#include "librarywatcher.h"
+#include "libraryindex.h"
+#include "libraryscanner.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+// 最后一个事件后静默这么久才处理，连续拷贝一批文件时合并成一次写索引
+const int kDefaultDebounceMs = 2000;
+
+// 事件持续不断时最迟这么久也要处理一次
+const qint64 kMaxPendingMs = 15000;
+
+#if defined(__linux__)
+// 只关心写完关闭的文件，不跟踪每次写入（IN_MODIFY）；IN_ATTRIB覆盖touch等只改时间的情况
+const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                            | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+#endif
+
+/**
+ * @brief 检查路径是否位于某个目录之下
+ */
+bool isUnder(const QString &filePath, const QStringList &dirPaths)
+{
+    for (const QString &dirPath : dirPaths) {
+        if (filePath.startsWith(dirPath) && filePath.size() > dirPath.size()
+            && filePath.at(dirPath.size()) == QLatin1Char('/')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 把一批变化合并进索引文件（在后台线程中运行）
+ * @param updated 输出新增或重新探测的文件数
+ * @param removed 输出移除的文件数
+ */
+bool applyChanges(const QString &indexPath, const QSet<QString> &changed, const QSet<QString> &removed,
+                  const QStringList &removedDirs, int *updated, int *removedCount, QString *errorString)
+{
+    *updated = 0;
+    *removedCount = 0;
+
+    // 整个索引读出再写回；与重新探测相比，20万条记录的读写只是零头
+    LibraryIndex index;
+    std::vector<LibraryRecord> records;
+    if (QFile::exists(indexPath) && !index.open(indexPath)) {
+        *errorString = index.errorString();
+        return false;
+    }
+    QSet<QString> replaced;
+    records.reserve(index.count() + changed.size());
+    for (int i = 0; i < index.count(); ++i) {
+        const QString filePath = index.filePath(i);
+        if (changed.contains(filePath)) {
+            replaced.insert(filePath);
+            continue;
+        }
+        if (removed.contains(filePath) || isUnder(filePath, removedDirs)) {
+            ++*removedCount;
+            continue;
+        }
+        records.push_back(index.record(i));
+    }
+
+    for (const QString &filePath : changed) {
+        LibraryFileKey key;
+        if (!LibraryFileKey::fromFile(filePath, &key)) {
+            // 事件之后文件又被删掉了，原记录（如有）已在上面去掉
+            if (replaced.contains(filePath)) {
+                ++*removedCount;
+            }
+            continue;
+        }
+
+        // 改名或移动过来的文件身份不变，沿用原记录
+        const int existing = index.find(key);
+        if (existing >= 0 && index.key(existing) == key) {
+            LibraryRecord record = index.record(existing);
+            record.filePath = filePath;
+            records.push_back(record);
+            ++*updated;
+            continue;
+        }
+
+        LibraryRecord record;
+        if (LibraryScanner::probeFile(filePath, key, &record)) {
+            records.push_back(record);
+            ++*updated;
+        }
+    }
+
+    index.close();
+    return LibraryIndex::write(indexPath, std::move(records), errorString);
+}
+
+} // namespace
+
+LibraryWatcher::LibraryWatcher(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_notifier(nullptr)
+    , m_flushing(false)
+    , m_generation(0)
+{
+    setSuffixes(LibraryScanner::defaultSuffixes());
+
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(kDefaultDebounceMs);
+    connect(&m_debounce, &QTimer::timeout, this, &LibraryWatcher::flush);
+
+    // 写索引必须串行，一个线程即可
+    m_pool.setMaxThreadCount(1);
+    m_pool.setObjectName("qvp-watch");
+}
+
+LibraryWatcher::~LibraryWatcher()
+{
+    stop();
+    m_pool.waitForDone();
+}
+
+void LibraryWatcher::setDebounceInterval(int milliseconds)
+{
+    m_debounce.setInterval(qMax(0, milliseconds));
+}
+
+void LibraryWatcher::setSuffixes(const QStringList &suffixes)
+{
+    m_suffixes.clear();
+    for (const QString &suffix : suffixes) {
+        m_suffixes.insert(suffix.toLower());
+    }
+}
+
+#if defined(__linux__)
+
+bool LibraryWatcher::start(const QStringList &roots, const QString &indexPath)
+{
+    stop();
+    m_errorString.clear();
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        m_errorString = QString("无法创建inotify实例: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    m_indexPath = indexPath;
+
+    for (const QString &root : roots) {
+        watchTree(QDir::cleanPath(QFileInfo(root).absoluteFilePath()), false);
+    }
+    if (m_watches.isEmpty()) {
+        if (m_errorString.isEmpty()) {
+            m_errorString = "没有可监视的目录";
+        }
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &LibraryWatcher::readEvents);
+    return m_errorString.isEmpty();
+}
+
+void LibraryWatcher::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_fd >= 0) {
+        // 关闭描述符即移除全部监视
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_watches.clear();
+    m_watchedDirs.clear();
+    m_changed.clear();
+    m_removed.clear();
+    m_removedDirs.clear();
+    m_debounce.stop();
+    finishPendingBatch();
+}
+
+void LibraryWatcher::watchTree(const QString &dirPath, bool collectFiles)
+{
+    if (m_fd < 0 || m_watchedDirs.contains(dirPath)) {
+        return;
+    }
+
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(dirPath).constData(), kWatchMask);
+    if (wd < 0) {
+        // 监视数超过fs.inotify.max_user_watches是持续的状态，重新扫描也不会改变，
+        // 只记下原因：这个目录之下的变化不再自动更新，已加的监视照常工作
+        if (errno == ENOSPC && m_errorString.isEmpty()) {
+            m_errorString = "inotify监视数已达上限（fs.inotify.max_user_watches），部分目录不会自动更新";
+        }
+        return;
+    }
+    m_watches.insert(wd, dirPath);
+    m_watchedDirs.insert(dirPath, wd);
+
+    // 先加监视再列目录，列目录期间新建的文件不会漏掉（最多重复记一次）
+    const QFileInfoList entries = QDir(dirPath).entryInfoList(
+        QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    for (const QFileInfo &entry : entries) {
+        if (entry.isDir()) {
+            watchTree(entry.absoluteFilePath(), collectFiles);
+        } else if (collectFiles && isMediaFile(entry.fileName())) {
+            m_changed.insert(entry.absoluteFilePath());
+        }
+    }
+}
+
+void LibraryWatcher::unwatchTree(const QString &dirPath)
+{
+    const QString prefix = dirPath + QLatin1Char('/');
+    for (auto it = m_watchedDirs.begin(); it != m_watchedDirs.end();) {
+        if (it.key() == dirPath || it.key().startsWith(prefix)) {
+            inotify_rm_watch(m_fd, it.value());
+            m_watches.remove(it.value());
+            it = m_watchedDirs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // 该目录下尚未处理的新文件也一并作废
+    for (auto it = m_changed.begin(); it != m_changed.end();) {
+        if (it->startsWith(prefix)) {
+            it = m_changed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!m_removedDirs.contains(dirPath)) {
+        m_removedDirs.append(dirPath);
+    }
+}
+
+void LibraryWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool dirty = false;
+
+    for (;;) {
+        const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                emit rescanRequired();
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // 目录被删除或监视被移除，内核已回收该描述符
+                const QString dirPath = m_watches.take(event->wd);
+                if (!dirPath.isEmpty() && m_watchedDirs.value(dirPath, -1) == event->wd) {
+                    m_watchedDirs.remove(dirPath);
+                }
+                continue;
+            }
+
+            const auto dir = m_watches.constFind(event->wd);
+            if (dir == m_watches.constEnd()) {
+                continue;
+            }
+            if (event->len == 0) {
+                // 目录自身被删除；根目录没有上级目录的IN_DELETE，只能靠这个事件发现
+                if (event->mask & IN_DELETE_SELF) {
+                    unwatchTree(dir.value());
+                    dirty = true;
+                }
+                continue;
+            }
+            const QString filePath = dir.value() + QLatin1Char('/') + QFile::decodeName(event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // 同一批中先删后建的目录：旧记录按删除处理，新文件重新记入
+                    watchTree(filePath, true);
+                    dirty = true;
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    unwatchTree(filePath);
+                    dirty = true;
+                }
+                continue;
+            }
+
+            if (!isMediaFile(filePath)) {
+                continue;
+            }
+            if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                m_changed.remove(filePath);
+                m_removed.insert(filePath);
+                dirty = true;
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB | IN_CREATE)) {
+                // 新建后还没写完的文件探测会失败，等IN_CLOSE_WRITE再记一次即可
+                m_removed.remove(filePath);
+                m_changed.insert(filePath);
+                dirty = true;
+            }
+        }
+    }
+
+    if (dirty) {
+        scheduleFlush();
+    }
+}
+
+#else
+
+bool LibraryWatcher::start(const QStringList &roots, const QString &indexPath)
+{
+    Q_UNUSED(roots);
+    Q_UNUSED(indexPath);
+    m_errorString = "当前平台不支持增量监视，请定期完整扫描";
+    return false;
+}
+
+void LibraryWatcher::stop()
+{
+    m_changed.clear();
+    m_removed.clear();
+    m_removedDirs.clear();
+    m_debounce.stop();
+    finishPendingBatch();
+}
+
+void LibraryWatcher::watchTree(const QString &dirPath, bool collectFiles)
+{
+    Q_UNUSED(dirPath);
+    Q_UNUSED(collectFiles);
+}
+
+void LibraryWatcher::unwatchTree(const QString &dirPath)
+{
+    Q_UNUSED(dirPath);
+}
+
+void LibraryWatcher::readEvents()
+{
+}
+
+#endif
+
+bool LibraryWatcher::isWatching() const
+{
+    return m_fd >= 0;
+}
+
+int LibraryWatcher::watchCount() const
+{
+    return m_watches.size();
+}
+
+QString LibraryWatcher::errorString() const
+{
+    return m_errorString;
+}
+
+bool LibraryWatcher::isMediaFile(const QString &fileName) const
+{
+    return m_suffixes.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+void LibraryWatcher::scheduleFlush()
+{
+    if (!m_pendingSince.isValid()) {
+        m_pendingSince.start();
+    }
+
+    // 上一批还在写时只积累，写完后再安排
+    if (m_flushing) {
+        return;
+    }
+    if (m_pendingSince.elapsed() >= kMaxPendingMs) {
+        flush();
+    } else {
+        m_debounce.start();
+    }
+}
+
+void LibraryWatcher::finishPendingBatch()
+{
+    // 调用者随后可能重写索引（如完整扫描），正在写的一批必须先写完，不能在之后覆盖新索引；
+    // 它排队的完成通知属于上一次监视，按代数丢弃
+    m_pool.waitForDone();
+    m_flushing = false;
+    ++m_generation;
+}
+
+void LibraryWatcher::flush()
+{
+    m_debounce.stop();
+    if (m_flushing || m_indexPath.isEmpty()
+        || (m_changed.isEmpty() && m_removed.isEmpty() && m_removedDirs.isEmpty())) {
+        return;
+    }
+
+    const QString indexPath = m_indexPath;
+    const QSet<QString> changed = m_changed;
+    const QSet<QString> removed = m_removed;
+    const QStringList removedDirs = m_removedDirs;
+    m_changed.clear();
+    m_removed.clear();
+    m_removedDirs.clear();
+    m_pendingSince.invalidate();
+    m_flushing = true;
+
+    const quint64 generation = m_generation;
+    m_pool.start([this, generation, indexPath, changed, removed, removedDirs]() {
+        int updated = 0;
+        int removedCount = 0;
+        QString errorString;
+        const bool ok = applyChanges(indexPath, changed, removed, removedDirs,
+                                     &updated, &removedCount, &errorString);
+
+        QMetaObject::invokeMethod(this, [this, generation, ok, updated, removedCount, errorString]() {
+            if (generation != m_generation) {
+                return;
+            }
+            m_flushing = false;
+            if (ok) {
+                emit indexUpdated(updated, removedCount);
+            } else {
+                // 写索引失败，这批变化已经丢失
+                m_errorString = errorString;
+                emit rescanRequired();
+            }
+            if (!m_changed.isEmpty() || !m_removed.isEmpty() || !m_removedDirs.isEmpty()) {
+                scheduleFlush();
+            }
+        }, Qt::QueuedConnection);
+    });
+}
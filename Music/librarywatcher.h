@@ -0,0 +1,167 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+class QSocketNotifier;
+
+/**
+ * @brief 媒体库增量更新：用inotify监视目录，只重新探测变化的文件（仅Linux）
+ *
+ * 对扫描根目录下的每个目录加一个inotify监视（文件本身不占监视数），
+ * 收集新建、写完关闭、改名移入移出、删除等事件。事件先合并，静默一段时间（或累积过久）后
+ * 在后台线程批量处理：读出现有索引，去掉已删除的路径，对变化的文件比较身份后重新探测，
+ * 再整体写回索引。改名或移动的文件inode不变，沿用原记录，只更新路径。
+ * 内核事件队列溢出时无法知道丢了哪些变化，发出rescanRequired，由调用者安排一次完整扫描；
+ * 监视数达到上限是持续的状态，只通过errorString报告，超出的目录不再自动更新。
+ * 只能在创建它的线程中调用。
+ */
+class LibraryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit LibraryWatcher(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（等待正在进行的批量更新写完）
+     */
+    ~LibraryWatcher() override;
+
+    /**
+     * @brief 设置合并事件的静默时间
+     * @param milliseconds 最后一个事件之后等待的毫秒数
+     */
+    void setDebounceInterval(int milliseconds);
+
+    /**
+     * @brief 设置要收录的文件扩展名（小写，不含点）
+     * @param suffixes 扩展名
+     */
+    void setSuffixes(const QStringList &suffixes);
+
+    /**
+     * @brief 开始监视（遍历根目录为每个子目录加监视，目录很多时需要一些时间）
+     * @param roots 扫描根目录
+     * @param indexPath 要维护的索引文件（应已由完整扫描生成）
+     * @return 是否全部目录都已监视，原因可通过errorString获取；
+     *         监视数达到上限时返回false，但已加的监视保留并继续工作（isWatching为true）
+     */
+    bool start(const QStringList &roots, const QString &indexPath);
+
+    /**
+     * @brief 停止监视，尚未写入的变化被丢弃
+     *
+     * 正在后台写入索引的一批会先写完再返回，之后可以安全地重写索引文件。
+     */
+    void stop();
+
+    /**
+     * @brief 检查是否正在监视
+     * @return 是否正在监视
+     */
+    bool isWatching() const;
+
+    /**
+     * @brief 获取监视的目录数
+     * @return 目录数
+     */
+    int watchCount() const;
+
+    /**
+     * @brief 立即处理已收集的变化（不等静默时间）
+     */
+    void flush();
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+signals:
+    /**
+     * @brief 一批变化已写入索引
+     * @param updated 新增或重新探测的文件数
+     * @param removed 移除的文件数
+     */
+    void indexUpdated(int updated, int removed);
+
+    /**
+     * @brief 有变化已经丢失（事件队列溢出、批量写入索引失败），需要完整扫描
+     *
+     * 只在事件处理和批量写入完成时发出，不会在start中发出。
+     */
+    void rescanRequired();
+
+private slots:
+    /**
+     * @brief 读取并处理inotify事件
+     */
+    void readEvents();
+
+private:
+    /**
+     * @brief 为目录及其全部子目录加监视
+     * @param dirPath 目录路径
+     * @param collectFiles 为true时把其中的媒体文件记为变化（目录新建或移入时）
+     */
+    void watchTree(const QString &dirPath, bool collectFiles);
+
+    /**
+     * @brief 移除目录及其全部子目录的监视，并把其下的文件记为删除
+     * @param dirPath 目录路径
+     */
+    void unwatchTree(const QString &dirPath);
+
+    /**
+     * @brief 检查文件名是否为收录的媒体文件
+     * @param fileName 文件名或路径
+     * @return 是否收录
+     */
+    bool isMediaFile(const QString &fileName) const;
+
+    /**
+     * @brief 有新变化时启动（或推迟）批量处理
+     */
+    void scheduleFlush();
+
+    /**
+     * @brief 等待正在写入的一批完成，并作废其尚未送达的完成通知
+     */
+    void finishPendingBatch();
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_watches;
+    QHash<QString, int> m_watchedDirs;
+    QSet<QString> m_suffixes;
+    QString m_indexPath;
+
+    // Pending changes, merged until the debounce timer fires
+    QSet<QString> m_changed;
+    QSet<QString> m_removed;
+    QStringList m_removedDirs;
+    QTimer m_debounce;
+    QElapsedTimer m_pendingSince;
+
+    // Batches are applied one at a time on a background thread
+    QThreadPool m_pool;
+    bool m_flushing;
+    quint64 m_generation;
+
+    QString m_errorString;
+};
+
+#endif // LIBRARYWATCHER_H
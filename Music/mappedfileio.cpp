@@ -0,0 +1,221 @@
+#include "mappedfileio.h"
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+
+// 直通模式下AVIO缓冲区只服务解复用器读文件头等小块读取，数据包内容不经过它
+const int kContextBufferSize = 32 * 1024;
+
+// 播放位置前方保持WILLNEED提示的范围；读到窗口后半段时提示下一段
+const qint64 kAdviseWindow = 16 * 1024 * 1024;
+
+} // namespace
+
+MappedFileIO::MappedFileIO()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_position(0)
+    , m_advisedEnd(0)
+    , m_context(nullptr)
+    , m_bytesDelivered(0)
+    , m_seeks(0)
+    , m_mappedBytes(0)
+{
+}
+
+MappedFileIO::~MappedFileIO()
+{
+    close();
+}
+
+bool MappedFileIO::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开文件：%1").arg(filePath);
+        return false;
+    }
+
+    // 空文件无法映射；超出预算的文件映射可能耗尽地址空间
+    const qint64 size = m_file.size();
+    if (size <= 0 || size > addressSpaceBudget()) {
+        m_errorString = QString("文件大小超出映射范围：%1").arg(filePath);
+        m_file.close();
+        return false;
+    }
+
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        m_errorString = QString("无法映射文件：%1").arg(filePath);
+        m_file.close();
+        return false;
+    }
+    m_size = size;
+
+    unsigned char *contextBuffer = static_cast<unsigned char *>(av_malloc(kContextBufferSize));
+    m_context = avio_alloc_context(contextBuffer, kContextBufferSize, 0, this,
+                                   &MappedFileIO::readPacket, nullptr, &MappedFileIO::seekPacket);
+    if (!m_context) {
+        av_free(contextBuffer);
+        m_errorString = "内存不足";
+        close();
+        return false;
+    }
+
+    // 大块读取直接拷进调用者的缓冲区；跳转只移动位置，不必在AVIO缓冲区内就地处理
+    m_context->direct = 1;
+
+    m_position = 0;
+    m_advisedEnd = 0;
+    m_bytesDelivered = 0;
+    m_seeks = 0;
+    m_mappedBytes = size;
+
+    advise(0, true);
+    advise(0, false);
+    return true;
+}
+
+void MappedFileIO::close()
+{
+    if (m_context) {
+        av_freep(&m_context->buffer);
+        avio_context_free(&m_context);
+    }
+
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_mappedBytes = 0;
+}
+
+bool MappedFileIO::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+AVIOContext *MappedFileIO::context() const
+{
+    return m_context;
+}
+
+MappedFileIO::Stats MappedFileIO::stats() const
+{
+    Stats stats;
+    stats.bytesDelivered = m_bytesDelivered;
+    stats.seeks = m_seeks;
+    stats.mappedBytes = m_mappedBytes;
+    return stats;
+}
+
+QString MappedFileIO::errorString() const
+{
+    return m_errorString;
+}
+
+qint64 MappedFileIO::addressSpaceBudget()
+{
+    // 64位进程留出足够余量给解码器和帧缓存；32位进程的地址空间只有数GB
+    return sizeof(void *) >= 8 ? 256LL * 1024 * 1024 * 1024 : 512LL * 1024 * 1024;
+}
+
+int MappedFileIO::readPacket(void *opaque, uint8_t *buffer, int size)
+{
+    return static_cast<MappedFileIO *>(opaque)->read(buffer, size);
+}
+
+int64_t MappedFileIO::seekPacket(void *opaque, int64_t offset, int whence)
+{
+    return static_cast<MappedFileIO *>(opaque)->seek(offset, whence);
+}
+
+int MappedFileIO::read(uint8_t *buffer, int size)
+{
+    if (m_position >= m_size) {
+        return AVERROR_EOF;
+    }
+
+    const int count = static_cast<int>(qMin<qint64>(size, m_size - m_position));
+
+    // 提前提示下一段，缺页时内核已在读取
+    if (m_position + count > m_advisedEnd - kAdviseWindow / 2) {
+        advise(m_position, false);
+    }
+
+    std::memcpy(buffer, m_data + m_position, count);
+    m_position += count;
+    m_bytesDelivered += count;
+    return count;
+}
+
+int64_t MappedFileIO::seek(int64_t offset, int whence)
+{
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) {
+        return m_size;
+    }
+
+    qint64 target;
+    switch (whence) {
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = m_position + offset;
+        break;
+    case SEEK_END:
+        target = m_size + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+
+    // 解复用器的小幅跳转仍在已提示的窗口内，只有远距离跳转才重新提示
+    if (target < m_position - kAdviseWindow || target > m_advisedEnd) {
+        ++m_seeks;
+        advise(target, false);
+    }
+    m_position = target;
+    return target;
+}
+
+void MappedFileIO::advise(qint64 offset, bool sequential)
+{
+#if defined(__linux__)
+    if (sequential) {
+        madvise(m_data, static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+        return;
+    }
+
+    // madvise要求起始地址按页对齐；映射从文件开头开始，页对齐的偏移即页对齐的地址
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    const qint64 start = qMin(offset, m_size) / pageSize * pageSize;
+    const qint64 end = qMin(offset + kAdviseWindow, m_size);
+    if (end > start) {
+        madvise(m_data + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+    }
+    m_advisedEnd = end;
+#else
+    Q_UNUSED(sequential);
+    m_advisedEnd = qMin(offset + kAdviseWindow, m_size);
+#endif
+}
@@ -0,0 +1,139 @@
+#ifndef MAPPEDFILEIO_H
+#define MAPPEDFILEIO_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+
+extern "C" {
+    struct AVIOContext;
+}
+
+/**
+ * @brief 内存映射的本地文件输入层
+ *
+ * 把整个文件映射进地址空间，AVIO回调直接从映射区取数据：读取和跳转都不再进入内核，
+ * 本地SSD上探测文件头和频繁跳转时省去大量read/lseek系统调用。
+ * 上下文使用直通模式，数据包内容从映射区一次拷贝到数据包缓冲区，不再经过AVIO自身的缓冲区。
+ * 页面由缺页异常按需读入，因此打开时提示内核顺序读取，并在播放位置前方保持一段WILLNEED提示（仅Linux有效）。
+ * 文件超出地址空间预算或映射失败时open返回false，调用者应退回预读层。
+ * 慢速U盘或网络共享上缺页会直接阻塞解码线程，这类存储应使用ReadAheadIO。
+ * AVIO回调只在解码线程中调用；统计可在任意线程读取。
+ */
+class MappedFileIO
+{
+public:
+    /**
+     * @brief 输入统计（seeks只计超出预读提示窗口的跳转）
+     */
+    struct Stats {
+        quint64 bytesDelivered;
+        quint64 seeks;
+        qint64 mappedBytes;
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    MappedFileIO();
+
+    /**
+     * @brief 析构函数
+     */
+    ~MappedFileIO();
+
+    MappedFileIO(const MappedFileIO &) = delete;
+    MappedFileIO &operator=(const MappedFileIO &) = delete;
+
+    /**
+     * @brief 映射文件并创建AVIOContext
+     * @param filePath 本地文件路径
+     * @return 是否成功，失败原因（超出预算、映射失败等）可通过errorString获取
+     */
+    bool open(const QString &filePath);
+
+    /**
+     * @brief 释放AVIOContext并解除映射
+     */
+    void close();
+
+    /**
+     * @brief 检查文件是否已映射
+     * @return 是否已映射
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取供avformat_open_input使用的AVIOContext
+     * @return 上下文，未打开时为nullptr
+     */
+    AVIOContext *context() const;
+
+    /**
+     * @brief 获取统计快照
+     * @return 统计
+     */
+    Stats stats() const;
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 获取可映射的最大文件大小（64位进程远大于32位进程）
+     * @return 字节数
+     */
+    static qint64 addressSpaceBudget();
+
+private:
+    /**
+     * @brief AVIO读回调
+     */
+    static int readPacket(void *opaque, uint8_t *buffer, int size);
+
+    /**
+     * @brief AVIO跳转回调
+     */
+    static int64_t seekPacket(void *opaque, int64_t offset, int whence);
+
+    /**
+     * @brief 从映射区拷贝数据，读取位置接近预读提示窗口末尾时提示下一段
+     * @param buffer 输出缓冲区
+     * @param size 最多读取的字节数
+     * @return 读取的字节数，或AVERROR_EOF
+     */
+    int read(uint8_t *buffer, int size);
+
+    /**
+     * @brief 移动读取位置，远距离跳转时提示内核预读新位置
+     * @param offset 偏移
+     * @param whence SEEK_SET / SEEK_CUR / SEEK_END / AVSEEK_SIZE
+     * @return 新位置或文件大小，失败时为负数
+     */
+    int64_t seek(int64_t offset, int whence);
+
+    /**
+     * @brief 提示内核读取（仅Linux有效）
+     * @param offset 起始偏移
+     * @param sequential 为true时提示整个映射按顺序访问，否则提示即将访问从offset开始的一个窗口
+     */
+    void advise(qint64 offset, bool sequential);
+
+    QFile m_file;
+    uchar *m_data;
+    qint64 m_size;
+    qint64 m_position;
+    qint64 m_advisedEnd;
+    AVIOContext *m_context;
+
+    // Counters
+    std::atomic<quint64> m_bytesDelivered;
+    std::atomic<quint64> m_seeks;
+    std::atomic<qint64> m_mappedBytes;
+
+    QString m_errorString;
+};
+
+#endif // MAPPEDFILEIO_H
@@ -0,0 +1,371 @@
+#include "mediadecoder.h"
+#include <QByteArray>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+MediaDecoder::MediaDecoder()
+    : m_formatCtx(nullptr)
+    , m_videoCodecCtx(nullptr)
+    , m_videoStream(nullptr)
+    , m_videoStreamIndex(-1)
+    , m_decoderThreadCount(1)
+    , m_packetCacheBytes(0)
+    , m_packetCacheSeconds(0.0)
+    , m_readAheadSize(0)
+    , m_ioUringEnabled(false)
+    , m_memoryMapEnabled(false)
+{
+}
+
+MediaDecoder::~MediaDecoder()
+{
+    close();
+}
+
+bool MediaDecoder::open(const QString &url, const QString &formatName)
+{
+    close();
+    m_errorString.clear();
+
+    // 指定输入格式时不做探测（例如lavfi滤镜图）
+    const AVInputFormat *inputFormat = nullptr;
+    if (!formatName.isEmpty()) {
+        inputFormat = av_find_input_format(formatName.toUtf8().constData());
+        if (!inputFormat) {
+            return fail("不支持的输入格式");
+        }
+    }
+
+    // 本地文件经内存映射或预读层读取；URL和设备输入仍使用FFmpeg自带的协议
+    AVIOContext *customIO = nullptr;
+    if (!inputFormat && ReadAheadIO::isLocalFile(url)) {
+        // 文件超出映射预算或映射失败时退回预读层
+        if (m_memoryMapEnabled && m_mappedFile.open(url)) {
+            customIO = m_mappedFile.context();
+        } else if (m_readAheadSize > 0) {
+            if (!m_readAhead.open(url, m_readAheadSize, m_ioUringEnabled)) {
+                return fail(m_readAhead.errorString());
+            }
+            customIO = m_readAhead.context();
+        }
+    }
+    if (customIO) {
+        m_formatCtx = avformat_alloc_context();
+        if (!m_formatCtx) {
+            return fail("内存不足");
+        }
+        m_formatCtx->pb = customIO;
+        m_formatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    // 路径的UTF-8数据必须在avformat_open_input返回前保持有效
+    const QByteArray path = url.toUtf8();
+    if (avformat_open_input(&m_formatCtx, path.constData(),
+                            const_cast<AVInputFormat *>(inputFormat), nullptr) != 0) {
+        return fail("无法打开视频文件");
+    }
+
+    // 获取流信息
+    if (avformat_find_stream_info(m_formatCtx, nullptr) < 0) {
+        return fail("无法获取流信息");
+    }
+
+    // 查找视频流
+    m_videoStreamIndex = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (m_videoStreamIndex < 0) {
+        return fail("未找到视频流");
+    }
+    m_videoStream = m_formatCtx->streams[m_videoStreamIndex];
+
+    // 缓存窗口换算为视频流的时间基；内嵌封面只有开头一个（常有几MB的）包，
+    // 缓存它只会让跳回开头"命中"缓存而不移动解复用器，音频包的读取位置停在原处，因此不启用
+    if (isAttachedPicture()) {
+        m_packetCache.setLimits(0, 0);
+    } else {
+        m_packetCache.setLimits(m_packetCacheBytes,
+                                static_cast<qint64>(m_packetCacheSeconds / av_q2d(m_videoStream->time_base)));
+    }
+
+    // 查找视频解码器
+    const AVCodec *videoCodec = avcodec_find_decoder(m_videoStream->codecpar->codec_id);
+    if (!videoCodec) {
+        return fail("未找到合适的解码器");
+    }
+
+    // 创建解码器上下文
+    m_videoCodecCtx = avcodec_alloc_context3(videoCodec);
+    if (!m_videoCodecCtx) {
+        return fail("无法创建解码器上下文");
+    }
+
+    // 从流复制解码器参数
+    if (avcodec_parameters_to_context(m_videoCodecCtx, m_videoStream->codecpar) < 0) {
+        return fail("无法复制解码器参数");
+    }
+
+    // 打开解码器
+    m_videoCodecCtx->thread_count = m_decoderThreadCount;
+    if (avcodec_open2(m_videoCodecCtx, videoCodec, nullptr) < 0) {
+        return fail("无法打开解码器");
+    }
+
+    return true;
+}
+
+void MediaDecoder::close()
+{
+    if (m_videoCodecCtx) {
+        avcodec_free_context(&m_videoCodecCtx);
+        m_videoCodecCtx = nullptr;
+    }
+
+    if (m_formatCtx) {
+        avformat_close_input(&m_formatCtx);
+        m_formatCtx = nullptr;
+    }
+
+    // 自定义AVIO不随avformat_close_input释放，须在其之后关闭
+    m_readAhead.close();
+    m_mappedFile.close();
+
+    m_packetCache.clear();
+    m_videoStream = nullptr;
+    m_videoStreamIndex = -1;
+}
+
+bool MediaDecoder::isOpen() const
+{
+    return m_videoCodecCtx != nullptr;
+}
+
+QString MediaDecoder::errorString() const
+{
+    return m_errorString;
+}
+
+void MediaDecoder::setDecoderThreadCount(int count)
+{
+    m_decoderThreadCount = count < 0 ? 1 : count;
+}
+
+void MediaDecoder::setPacketCacheLimits(qint64 maxBytes, double behindSeconds)
+{
+    m_packetCacheBytes = maxBytes < 0 ? 0 : maxBytes;
+    m_packetCacheSeconds = behindSeconds < 0.0 ? 0.0 : behindSeconds;
+}
+
+const PacketCache &MediaDecoder::packetCache() const
+{
+    return m_packetCache;
+}
+
+void MediaDecoder::setReadAheadSize(qint64 bytes)
+{
+    m_readAheadSize = bytes < 0 ? 0 : bytes;
+}
+
+void MediaDecoder::setIoUringEnabled(bool enabled)
+{
+    m_ioUringEnabled = enabled;
+}
+
+const ReadAheadIO &MediaDecoder::readAhead() const
+{
+    return m_readAhead;
+}
+
+void MediaDecoder::setMemoryMapEnabled(bool enabled)
+{
+    m_memoryMapEnabled = enabled;
+}
+
+const MappedFileIO &MediaDecoder::mappedFile() const
+{
+    return m_mappedFile;
+}
+
+QString MediaDecoder::inputBackend() const
+{
+    if (m_mappedFile.isOpen()) {
+        return "mmap";
+    }
+    if (m_readAhead.context()) {
+        return m_readAhead.isUsingUring() ? "io_uring" : "readahead";
+    }
+    return "file";
+}
+
+int MediaDecoder::readPacket(AVPacket *packet)
+{
+    if (!m_formatCtx) {
+        return AVERROR(EINVAL);
+    }
+
+    // 缓存命中的跳转之后先回放缓存，回放完再接着从解复用器读取，包序列保持连续
+    if (m_packetCache.hasNext()) {
+        return m_packetCache.next(packet) ? 0 : AVERROR(ENOMEM);
+    }
+
+    const int ret = av_read_frame(m_formatCtx, packet);
+    if (ret >= 0 && packet->stream_index == m_videoStreamIndex) {
+        m_packetCache.append(packet);
+    }
+    return ret;
+}
+
+bool MediaDecoder::isVideoPacket(const AVPacket *packet) const
+{
+    return packet->stream_index == m_videoStreamIndex;
+}
+
+int MediaDecoder::sendPacket(const AVPacket *packet)
+{
+    if (!m_videoCodecCtx) {
+        return AVERROR(EINVAL);
+    }
+    return avcodec_send_packet(m_videoCodecCtx, packet);
+}
+
+int MediaDecoder::receiveFrame(AVFrame *frame)
+{
+    if (!m_videoCodecCtx) {
+        return AVERROR(EINVAL);
+    }
+    return avcodec_receive_frame(m_videoCodecCtx, frame);
+}
+
+bool MediaDecoder::seek(double position)
+{
+    if (!m_formatCtx) {
+        return false;
+    }
+
+    // 目标在包缓存范围内时只移动缓存的读取游标，不访问文件
+    if (m_packetCache.isEnabled()) {
+        if (m_packetCache.seek(timestampFor(position))) {
+            avcodec_flush_buffers(m_videoCodecCtx);
+            return true;
+        }
+    }
+
+    // 以AV_TIME_BASE为单位按默认流跳转，向前对齐到关键帧；位置从0开始，需加回输入的起始时间
+    int64_t targetTimestamp = static_cast<int64_t>(position * AV_TIME_BASE);
+    if (m_formatCtx->start_time != AV_NOPTS_VALUE) {
+        targetTimestamp += m_formatCtx->start_time;
+    }
+    if (av_seek_frame(m_formatCtx, -1, targetTimestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+    }
+
+    // 解复用器的位置已变，缓存的包序列不再与之连续
+    m_packetCache.clear();
+
+    // 刷新解码器缓冲区
+    avcodec_flush_buffers(m_videoCodecCtx);
+    return true;
+}
+
+bool MediaDecoder::framePosition(const AVFrame *frame, double *position) const
+{
+    const int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE
+            ? frame->best_effort_timestamp : frame->pts;
+    if (!m_videoStream || pts == AV_NOPTS_VALUE) {
+        return false;
+    }
+
+    // 扣除流的起始时间，使进度从0开始
+    int64_t start = m_videoStream->start_time;
+    if (start == AV_NOPTS_VALUE) {
+        start = 0;
+    }
+    *position = (pts - start) * av_q2d(m_videoStream->time_base);
+    return true;
+}
+
+bool MediaDecoder::packetPosition(const AVPacket *packet, double *position) const
+{
+    if (!m_formatCtx || packet->stream_index < 0
+            || packet->stream_index >= static_cast<int>(m_formatCtx->nb_streams)) {
+        return false;
+    }
+    const int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    if (pts == AV_NOPTS_VALUE) {
+        return false;
+    }
+
+    // 与framePosition相同，扣除所属流的起始时间
+    const AVStream *stream = m_formatCtx->streams[packet->stream_index];
+    int64_t start = stream->start_time;
+    if (start == AV_NOPTS_VALUE) {
+        start = 0;
+    }
+    *position = (pts - start) * av_q2d(stream->time_base);
+    return true;
+}
+
+qint64 MediaDecoder::timestampFor(double position) const
+{
+    if (!m_videoStream) {
+        return 0;
+    }
+
+    int64_t timestamp = static_cast<int64_t>(position / av_q2d(m_videoStream->time_base));
+    if (m_videoStream->start_time != AV_NOPTS_VALUE) {
+        timestamp += m_videoStream->start_time;
+    }
+    return timestamp;
+}
+
+double MediaDecoder::duration() const
+{
+    if (!m_formatCtx || m_formatCtx->duration == AV_NOPTS_VALUE) {
+        return 0.0;
+    }
+    return m_formatCtx->duration / (double)AV_TIME_BASE;
+}
+
+int MediaDecoder::width() const
+{
+    return m_videoCodecCtx ? m_videoCodecCtx->width : 0;
+}
+
+int MediaDecoder::height() const
+{
+    return m_videoCodecCtx ? m_videoCodecCtx->height : 0;
+}
+
+AVPixelFormat MediaDecoder::pixelFormat() const
+{
+    return m_videoCodecCtx ? m_videoCodecCtx->pix_fmt : AV_PIX_FMT_NONE;
+}
+
+AVRational MediaDecoder::frameRate() const
+{
+    if (!m_videoStream) {
+        return AVRational{ 0, 1 };
+    }
+    return m_videoStream->avg_frame_rate;
+}
+
+bool MediaDecoder::isAttachedPicture() const
+{
+    return m_videoStream && (m_videoStream->disposition & AV_DISPOSITION_ATTACHED_PIC);
+}
+
+QString MediaDecoder::codecName() const
+{
+    if (!m_videoCodecCtx || !m_videoCodecCtx->codec) {
+        return QString();
+    }
+    return QString::fromUtf8(m_videoCodecCtx->codec->name);
+}
+
+bool MediaDecoder::fail(const QString &message)
+{
+    m_errorString = message;
+    close();
+    return false;
+}
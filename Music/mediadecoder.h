@@ -0,0 +1,259 @@
+#ifndef MEDIADECODER_H
+#define MEDIADECODER_H
+
+#include <QString>
+#include "mappedfileio.h"
+#include "packetcache.h"
+#include "readaheadio.h"
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+    struct AVFormatContext;
+    struct AVCodecContext;
+    struct AVStream;
+    struct AVFrame;
+    struct AVPacket;
+}
+
+/**
+ * @brief 视频解复用与解码器
+ *
+ * 封装输入打开、视频流选择、读包、解码和跳转，不依赖界面和信号槽，
+ * 既供FFmpegWrapper播放使用，也可被无界面的基准测试等工具直接驱动。
+ * 不做线程同步，调用者负责保证同一时刻只有一个线程访问。
+ */
+class MediaDecoder
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    MediaDecoder();
+
+    /**
+     * @brief 析构函数
+     */
+    ~MediaDecoder();
+
+    MediaDecoder(const MediaDecoder &) = delete;
+    MediaDecoder &operator=(const MediaDecoder &) = delete;
+
+    /**
+     * @brief 打开输入并准备视频解码器
+     * @param url 文件路径或URL
+     * @param formatName 强制使用的输入格式（如"lavfi"），为空时自动探测
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool open(const QString &url, const QString &formatName = QString());
+
+    /**
+     * @brief 关闭输入并释放解码器
+     */
+    void close();
+
+    /**
+     * @brief 检查是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取最近一次失败的原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 设置解码线程数（下次open时生效）
+     * @param count 线程数，0表示由FFmpeg按CPU核心数自动选择
+     */
+    void setDecoderThreadCount(int count);
+
+    /**
+     * @brief 设置视频包缓存的上限（下次open时生效），缓存范围内的跳转不再访问文件
+     * @param maxBytes 缓存的总字节数上限，0表示禁用缓存
+     * @param behindSeconds 播放位置之后保留的时长（秒）
+     */
+    void setPacketCacheLimits(qint64 maxBytes, double behindSeconds);
+
+    /**
+     * @brief 获取视频包缓存（用于读取命中统计）
+     * @return 缓存对象
+     */
+    const PacketCache &packetCache() const;
+
+    /**
+     * @brief 设置本地文件预读缓冲区的大小（下次open时生效）
+     * @param bytes 字节数，0表示使用FFmpeg默认的file协议
+     */
+    void setReadAheadSize(qint64 bytes);
+
+    /**
+     * @brief 设置预读层是否优先使用io_uring（仅Linux，内核不支持时仍使用预读线程；下次open时生效）
+     * @param enabled 是否启用
+     */
+    void setIoUringEnabled(bool enabled);
+
+    /**
+     * @brief 获取预读输入层（用于读取吞吐量和停顿统计，统计可在任意线程读取）
+     * @return 输入层
+     */
+    const ReadAheadIO &readAhead() const;
+
+    /**
+     * @brief 设置本地文件是否优先以内存映射读取（下次open时生效）
+     *
+     * 适合本地SSD：读取和跳转不再产生系统调用。文件超出映射预算时仍按setReadAheadSize的设置读取。
+     * @param enabled 是否启用
+     */
+    void setMemoryMapEnabled(bool enabled);
+
+    /**
+     * @brief 获取内存映射输入层（用于读取统计，统计可在任意线程读取）
+     * @return 输入层
+     */
+    const MappedFileIO &mappedFile() const;
+
+    /**
+     * @brief 获取当前输入使用的读取方式
+     * @return "mmap"、"io_uring"、"readahead"或"file"（FFmpeg自带的协议）
+     */
+    QString inputBackend() const;
+
+    /**
+     * @brief 读取下一个数据包（任意流；从缓存回放时只有视频包）
+     * @param packet 输出数据包，调用者负责av_packet_unref
+     * @return av_read_frame的返回值，负数表示结束或出错
+     */
+    int readPacket(AVPacket *packet);
+
+    /**
+     * @brief 检查数据包是否属于视频流
+     * @param packet 数据包
+     * @return 是否为视频包
+     */
+    bool isVideoPacket(const AVPacket *packet) const;
+
+    /**
+     * @brief 向解码器送入数据包
+     * @param packet 视频数据包，nullptr表示冲刷解码器
+     * @return avcodec_send_packet的返回值
+     */
+    int sendPacket(const AVPacket *packet);
+
+    /**
+     * @brief 从解码器取出一帧
+     * @param frame 输出帧
+     * @return avcodec_receive_frame的返回值（AVERROR(EAGAIN)表示需要更多数据包）
+     */
+    int receiveFrame(AVFrame *frame);
+
+    /**
+     * @brief 跳转到指定位置（向前对齐到关键帧）并清空解码器缓冲，目标在包缓存范围内时不访问文件
+     * @param position 目标位置（秒）
+     * @return 是否成功
+     */
+    bool seek(double position);
+
+    /**
+     * @brief 把帧的时间戳换算为秒
+     * @param frame 解码后的帧
+     * @param position 输出位置（秒）
+     * @return 帧没有有效时间戳时返回false
+     */
+    bool framePosition(const AVFrame *frame, double *position) const;
+
+    /**
+     * @brief 把数据包的时间戳换算为秒（按数据包所属的流，可用于音频包）
+     * @param packet 数据包
+     * @param position 输出位置（秒）
+     * @return 数据包没有有效时间戳时返回false
+     */
+    bool packetPosition(const AVPacket *packet, double *position) const;
+
+    /**
+     * @brief 把位置换算为视频流的时间戳（framePosition的逆运算）
+     * @param position 位置（秒）
+     * @return 时间戳（流时间基），未打开时为0
+     */
+    qint64 timestampFor(double position) const;
+
+    /**
+     * @brief 获取输入时长
+     * @return 时长（秒），未知时为0
+     */
+    double duration() const;
+
+    /**
+     * @brief 获取视频宽度
+     * @return 宽度（像素）
+     */
+    int width() const;
+
+    /**
+     * @brief 获取视频高度
+     * @return 高度（像素）
+     */
+    int height() const;
+
+    /**
+     * @brief 获取解码输出的像素格式
+     * @return 像素格式
+     */
+    AVPixelFormat pixelFormat() const;
+
+    /**
+     * @brief 获取视频流的平均帧率
+     * @return 帧率，未知时为{0, 1}
+     */
+    AVRational frameRate() const;
+
+    /**
+     * @brief 检查视频流是否只是内嵌封面（音乐文件的AV_DISPOSITION_ATTACHED_PIC流，整个文件只有一帧）
+     * @return 是否为内嵌封面
+     */
+    bool isAttachedPicture() const;
+
+    /**
+     * @brief 获取解码器名称
+     * @return 名称
+     */
+    QString codecName() const;
+
+private:
+    /**
+     * @brief 记录错误并释放已分配的资源
+     * @param message 错误信息
+     * @return 始终返回false，便于直接return
+     */
+    bool fail(const QString &message);
+
+    // FFmpeg core components
+    AVFormatContext *m_formatCtx;
+    AVCodecContext *m_videoCodecCtx;
+    AVStream *m_videoStream;
+    int m_videoStreamIndex;
+
+    // Decoder settings
+    int m_decoderThreadCount;
+    qint64 m_packetCacheBytes;
+    double m_packetCacheSeconds;
+
+    qint64 m_readAheadSize;
+    bool m_ioUringEnabled;
+    bool m_memoryMapEnabled;
+
+    // Demuxed video packets kept for seeks without I/O
+    PacketCache m_packetCache;
+
+    // Custom AVIO with a read-ahead thread for local files
+    ReadAheadIO m_readAhead;
+
+    // Custom AVIO serving reads straight from a mapping of the whole file
+    MappedFileIO m_mappedFile;
+
+    QString m_errorString;
+};
+
+#endif // MEDIADECODER_H
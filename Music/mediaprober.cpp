@@ -0,0 +1,137 @@
+#include "mediaprober.h"
+#include <QFile>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+}
+
+namespace {
+
+// 非Linux平台预热时单次读取的大小
+const qint64 kWarmUpChunk = 1024 * 1024;
+
+/**
+ * @brief 读取标签，容器级没有时依次查找各流（Ogg等格式把标签放在流上）
+ * @param formatCtx 格式上下文
+ * @param key 标签名（不区分大小写）
+ * @return 标签值，没有时为空
+ */
+QString tagValue(const AVFormatContext *formatCtx, const char *key)
+{
+    const AVDictionaryEntry *entry = av_dict_get(formatCtx->metadata, key, nullptr, 0);
+    for (unsigned i = 0; !entry && i < formatCtx->nb_streams; ++i) {
+        entry = av_dict_get(formatCtx->streams[i]->metadata, key, nullptr, 0);
+    }
+    return entry ? QString::fromUtf8(entry->value) : QString();
+}
+
+} // namespace
+
+MediaProber::MediaProber()
+    : m_streamInfoEnabled(false)
+    , m_coverArtEnabled(true)
+{
+}
+
+void MediaProber::setStreamInfoEnabled(bool enabled)
+{
+    m_streamInfoEnabled = enabled;
+}
+
+void MediaProber::setCoverArtEnabled(bool enabled)
+{
+    m_coverArtEnabled = enabled;
+}
+
+bool MediaProber::probe(const QString &filePath, MediaInfo *info)
+{
+    m_errorString.clear();
+    *info = MediaInfo();
+    info->filePath = filePath;
+
+    // 路径的UTF-8数据必须在avformat_open_input返回前保持有效
+    AVFormatContext *formatCtx = nullptr;
+    const QByteArray path = filePath.toUtf8();
+    if (avformat_open_input(&formatCtx, path.constData(), nullptr, nullptr) != 0) {
+        m_errorString = QString("无法打开文件：%1").arg(filePath);
+        return false;
+    }
+
+    if (m_streamInfoEnabled && avformat_find_stream_info(formatCtx, nullptr) < 0) {
+        avformat_close_input(&formatCtx);
+        m_errorString = QString("无法获取流信息：%1").arg(filePath);
+        return false;
+    }
+
+    info->formatName = QString::fromUtf8(formatCtx->iformat->name);
+    info->duration = formatCtx->duration != AV_NOPTS_VALUE
+            ? formatCtx->duration / static_cast<double>(AV_TIME_BASE) : 0.0;
+    info->bitRate = formatCtx->bit_rate;
+    info->streamCount = static_cast<int>(formatCtx->nb_streams);
+
+    // 各取第一个视频流和音频流；封面以视频流的形式出现，不算作视频
+    for (unsigned i = 0; i < formatCtx->nb_streams; ++i) {
+        const AVStream *stream = formatCtx->streams[i];
+        const AVCodecParameters *codecpar = stream->codecpar;
+        if (stream->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+            info->hasCoverArt = info->hasCoverArt || stream->attached_pic.size > 0;
+            if (m_coverArtEnabled && info->coverArt.isEmpty() && stream->attached_pic.size > 0) {
+                info->coverArt = QByteArray(reinterpret_cast<const char *>(stream->attached_pic.data),
+                                            stream->attached_pic.size);
+            }
+            continue;
+        }
+        if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && info->videoCodec.isEmpty()) {
+            info->videoCodec = QString::fromUtf8(avcodec_get_name(codecpar->codec_id));
+            info->width = codecpar->width;
+            info->height = codecpar->height;
+        } else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO && info->audioCodec.isEmpty()) {
+            info->audioCodec = QString::fromUtf8(avcodec_get_name(codecpar->codec_id));
+            info->sampleRate = codecpar->sample_rate;
+            info->channels = codecpar->channels;
+        }
+    }
+
+    info->title = tagValue(formatCtx, "title");
+    info->artist = tagValue(formatCtx, "artist");
+    if (info->artist.isEmpty()) {
+        info->artist = tagValue(formatCtx, "album_artist");
+    }
+    info->album = tagValue(formatCtx, "album");
+
+    avformat_close_input(&formatCtx);
+    return true;
+}
+
+QString MediaProber::errorString() const
+{
+    return m_errorString;
+}
+
+void MediaProber::warmUp(const QString &filePath, qint64 bytes)
+{
+    QFile file(filePath);
+    if (bytes <= 0 || !file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return;
+    }
+
+#if defined(__linux__)
+    // 内核在后台读入页缓存，文件关闭后缓存仍然有效
+    posix_fadvise(file.handle(), 0, bytes, POSIX_FADV_WILLNEED);
+#else
+    QByteArray buffer(static_cast<int>(kWarmUpChunk), Qt::Uninitialized);
+    for (qint64 done = 0; done < bytes;) {
+        const qint64 count = file.read(buffer.data(), qMin(kWarmUpChunk, bytes - done));
+        if (count <= 0) {
+            break;
+        }
+        done += count;
+    }
+#endif
+}
@@ -0,0 +1,111 @@
+#ifndef MEDIAPROBER_H
+#define MEDIAPROBER_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief 探测得到的媒体信息
+ */
+struct MediaInfo {
+    QString filePath;
+    QString formatName;
+    double duration;
+    qint64 bitRate;
+
+    // Streams
+    int streamCount;
+    QString videoCodec;
+    int width;
+    int height;
+    QString audioCodec;
+    int sampleRate;
+    int channels;
+
+    // Tags
+    QString title;
+    QString artist;
+    QString album;
+
+    /**
+     * @brief 是否有内嵌封面（不论是否提取了封面数据）
+     */
+    bool hasCoverArt;
+
+    /**
+     * @brief 内嵌封面的原始编码数据（JPEG/PNG等），没有封面或未启用提取时为空
+     */
+    QByteArray coverArt;
+
+    MediaInfo()
+        : duration(0.0)
+        , bitRate(0)
+        , streamCount(0)
+        , width(0)
+        , height(0)
+        , sampleRate(0)
+        , channels(0)
+        , hasCoverArt(false)
+    {
+    }
+};
+
+/**
+ * @brief 媒体文件探测器
+ *
+ * 只打开容器读取文件头，不打开解码器：取得时长、各流的编码和尺寸、标题/艺术家/专辑标签，
+ * 以及内嵌封面（AV_DISPOSITION_ATTACHED_PIC流随文件头一起读出的那个数据包）。
+ * 默认不调用avformat_find_stream_info，它需要读取并解码若干数据包，
+ * 对大批量探测来说是主要耗时；裸流等文件头不含时长的格式可按需开启。
+ * 每次probe独立打开和关闭文件，同一对象不能被多个线程同时使用，不同对象可以并行。
+ */
+class MediaProber
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    MediaProber();
+
+    /**
+     * @brief 设置是否读取数据包补全流信息（更准确，但明显更慢）
+     * @param enabled 是否启用
+     */
+    void setStreamInfoEnabled(bool enabled);
+
+    /**
+     * @brief 设置是否提取内嵌封面
+     * @param enabled 是否启用
+     */
+    void setCoverArtEnabled(bool enabled);
+
+    /**
+     * @brief 探测文件
+     * @param filePath 文件路径或URL
+     * @param info 输出媒体信息
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool probe(const QString &filePath, MediaInfo *info);
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 提前把文件开头读入系统页缓存，之后打开和起播时不再等待磁盘
+     *
+     * Linux上只提示内核异步预读（posix_fadvise），立即返回；其他平台同步读取并丢弃数据。
+     * @param filePath 本地文件路径
+     * @param bytes 预读的字节数
+     */
+    static void warmUp(const QString &filePath, qint64 bytes);
+
+private:
+    bool m_streamInfoEnabled;
+    bool m_coverArtEnabled;
+    QString m_errorString;
+};
+
+#endif // MEDIAPROBER_H
@@ -0,0 +1,181 @@
+#include "packetcache.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+PacketCache::PacketCache()
+    : m_cursor(0)
+    , m_bytes(0)
+    , m_lastTimestamp(AV_NOPTS_VALUE)
+    , m_maxBytes(0)
+    , m_behindDuration(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+PacketCache::~PacketCache()
+{
+    clear();
+}
+
+void PacketCache::setLimits(qint64 maxBytes, qint64 behindDuration)
+{
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    m_behindDuration = qMax<qint64>(0, behindDuration);
+    clear();
+}
+
+bool PacketCache::isEnabled() const
+{
+    return m_maxBytes > 0;
+}
+
+void PacketCache::clear()
+{
+    for (AVPacket *packet : m_packets) {
+        av_packet_free(&packet);
+    }
+    m_packets.clear();
+    m_cursor = 0;
+    m_bytes = 0;
+    m_lastTimestamp = AV_NOPTS_VALUE;
+}
+
+bool PacketCache::hasNext() const
+{
+    return m_cursor < m_packets.size();
+}
+
+bool PacketCache::next(AVPacket *packet)
+{
+    if (!hasNext()) {
+        return false;
+    }
+    if (av_packet_ref(packet, m_packets[m_cursor]) < 0) {
+        return false;
+    }
+    ++m_cursor;
+    return true;
+}
+
+void PacketCache::append(const AVPacket *packet)
+{
+    // 回放途中追加会破坏包序列的连续性
+    if (!isEnabled() || hasNext()) {
+        return;
+    }
+
+    // 缓存必须从关键帧开始，否则命中后无法直接解码
+    if (m_packets.empty() && !(packet->flags & AV_PKT_FLAG_KEY)) {
+        return;
+    }
+
+    // 引用计数的包只增加引用，不拷贝数据
+    AVPacket *copy = av_packet_clone(packet);
+    if (!copy) {
+        clear();
+        return;
+    }
+    m_packets.push_back(copy);
+    m_cursor = m_packets.size();
+    m_bytes += copy->size;
+
+    const qint64 timestamp = timestampOf(copy);
+    if (timestamp != AV_NOPTS_VALUE
+            && (m_lastTimestamp == AV_NOPTS_VALUE || timestamp > m_lastTimestamp)) {
+        m_lastTimestamp = timestamp;
+    }
+
+    evict();
+}
+
+bool PacketCache::seek(qint64 timestamp)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    // 超出已缓存的末尾时，从最后的关键帧解码过去可能比直接跳转更慢
+    if (m_packets.empty() || m_lastTimestamp == AV_NOPTS_VALUE || timestamp > m_lastTimestamp) {
+        ++m_misses;
+        return false;
+    }
+
+    // 从后向前找不晚于目标的最后一个关键帧
+    for (size_t i = m_packets.size(); i-- > 0;) {
+        const AVPacket *packet = m_packets[i];
+        if (!(packet->flags & AV_PKT_FLAG_KEY)) {
+            continue;
+        }
+        const qint64 keyTimestamp = timestampOf(packet);
+        if (keyTimestamp != AV_NOPTS_VALUE && keyTimestamp <= timestamp) {
+            m_cursor = i;
+            ++m_hits;
+            return true;
+        }
+    }
+
+    ++m_misses;
+    return false;
+}
+
+int PacketCache::packetCount() const
+{
+    return static_cast<int>(m_packets.size());
+}
+
+qint64 PacketCache::byteSize() const
+{
+    return m_bytes;
+}
+
+quint64 PacketCache::hitCount() const
+{
+    return m_hits;
+}
+
+quint64 PacketCache::missCount() const
+{
+    return m_misses;
+}
+
+void PacketCache::evict()
+{
+    // 播放位置取最近交出的包，时长窗口以此为界向后计算
+    const qint64 playhead = m_cursor > 0 ? timestampOf(m_packets[m_cursor - 1]) : AV_NOPTS_VALUE;
+
+    for (;;) {
+        // 第二个关键帧之前的包构成最早的GOP；游标在该GOP内时不能淘汰
+        size_t end = 1;
+        while (end < m_packets.size() && !(m_packets[end]->flags & AV_PKT_FLAG_KEY)) {
+            ++end;
+        }
+        if (end >= m_packets.size() || end > m_cursor) {
+            return;
+        }
+
+        // 下一个GOP的关键帧仍早于时长窗口的起点时，最早的GOP已完全落在窗口之外
+        bool outside = m_bytes > m_maxBytes;
+        if (!outside && playhead != AV_NOPTS_VALUE) {
+            const qint64 nextKey = timestampOf(m_packets[end]);
+            outside = nextKey != AV_NOPTS_VALUE && nextKey <= playhead - m_behindDuration;
+        }
+        if (!outside) {
+            return;
+        }
+
+        for (size_t i = 0; i < end; ++i) {
+            m_bytes -= m_packets.front()->size;
+            av_packet_free(&m_packets.front());
+            m_packets.pop_front();
+        }
+        m_cursor -= end;
+    }
+}
+
+qint64 PacketCache::timestampOf(const AVPacket *packet)
+{
+    return packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+}
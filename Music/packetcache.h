@@ -0,0 +1,133 @@
+#ifndef PACKETCACHE_H
+#define PACKETCACHE_H
+
+#include <QtGlobal>
+#include <deque>
+
+extern "C" {
+    struct AVPacket;
+}
+
+/**
+ * @brief 已解复用视频包的内存缓存
+ *
+ * 按读取顺序保存从解复用器读出的一段连续视频包（共享FFmpeg的引用计数缓冲区，不拷贝数据），
+ * 播放位置之后的包为“前方”，之前的包为“后方”。缓存范围内的跳转只移动读取游标，
+ * 不再访问文件，也不需要重新探测，适合在网络共享等慢速存储上来回跳转和循环播放。
+ * 后方按时长和总字节数限制，超出时以GOP为单位从最早的关键帧开始淘汰，
+ * 保证缓存始终从关键帧开始，任意命中的跳转都能直接解码。
+ * 解复用器发生真正的跳转后，缓存必须clear，否则包序列不再连续。
+ * 不做线程同步，由MediaDecoder在同一线程中使用。
+ */
+class PacketCache
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    PacketCache();
+
+    /**
+     * @brief 析构函数
+     */
+    ~PacketCache();
+
+    PacketCache(const PacketCache &) = delete;
+    PacketCache &operator=(const PacketCache &) = delete;
+
+    /**
+     * @brief 设置缓存上限
+     * @param maxBytes 缓存的总字节数上限，0表示禁用缓存
+     * @param behindDuration 播放位置之后保留的时长（与append的时间戳同一时间基）
+     */
+    void setLimits(qint64 maxBytes, qint64 behindDuration);
+
+    /**
+     * @brief 检查缓存是否启用
+     * @return 是否启用
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief 清空缓存（解复用器跳转后调用）
+     */
+    void clear();
+
+    /**
+     * @brief 检查读取游标之后是否还有缓存的包
+     * @return 是否正在回放缓存
+     */
+    bool hasNext() const;
+
+    /**
+     * @brief 取出游标处的包并前移游标
+     * @param packet 输出数据包（新增一个引用），调用者负责av_packet_unref
+     * @return 是否成功
+     */
+    bool next(AVPacket *packet);
+
+    /**
+     * @brief 追加刚从解复用器读出的视频包（只能在游标位于末尾时调用）
+     * @param packet 数据包，缓存持有其引用，调用者仍需自行unref
+     */
+    void append(const AVPacket *packet);
+
+    /**
+     * @brief 把游标移到不晚于目标时间戳的最后一个关键帧
+     * @param timestamp 目标时间戳（流时间基）
+     * @return 目标不在缓存范围内时返回false，游标不变
+     */
+    bool seek(qint64 timestamp);
+
+    /**
+     * @brief 获取缓存的包数
+     * @return 包数
+     */
+    int packetCount() const;
+
+    /**
+     * @brief 获取缓存的总字节数
+     * @return 字节数
+     */
+    qint64 byteSize() const;
+
+    /**
+     * @brief 获取由缓存完成的跳转次数
+     * @return 次数
+     */
+    quint64 hitCount() const;
+
+    /**
+     * @brief 获取未命中缓存、需要访问文件的跳转次数
+     * @return 次数
+     */
+    quint64 missCount() const;
+
+private:
+    /**
+     * @brief 按上限从最早的GOP开始淘汰，游标所在的GOP及之后的包不会被淘汰
+     */
+    void evict();
+
+    /**
+     * @brief 获取包用于排序和查找的时间戳（优先pts，缺失时用dts）
+     * @param packet 数据包
+     * @return 时间戳，均缺失时为AV_NOPTS_VALUE
+     */
+    static qint64 timestampOf(const AVPacket *packet);
+
+    std::deque<AVPacket *> m_packets;
+    size_t m_cursor;
+    qint64 m_bytes;
+    qint64 m_lastTimestamp;
+
+    // Limits
+    qint64 m_maxBytes;
+    qint64 m_behindDuration;
+
+    // Counters
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+#endif // PACKETCACHE_H
@@ -0,0 +1,416 @@
+#include "pipelinestats.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// 每个2的幂区间再分为4个子区间，相对误差不超过12.5%
+const int kSubBucketBits = 2;
+const int kSubBuckets = 1 << kSubBucketBits;
+// 最高区间约为2^40纳秒（约18分钟），更大的值计入最后一个桶
+const int kMaxExponent = 40;
+const int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+/**
+ * @brief 计算耗时所在的直方图桶
+ * @param nanoseconds 耗时（纳秒）
+ * @return 桶下标
+ */
+int bucketIndex(quint64 nanoseconds)
+{
+    if (nanoseconds < static_cast<quint64>(kSubBuckets)) {
+        return static_cast<int>(nanoseconds);
+    }
+
+    int exponent = 63;
+    while (!(nanoseconds >> exponent)) {
+        --exponent;
+    }
+    const int mantissa = static_cast<int>((nanoseconds >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    const int index = (exponent - kSubBucketBits + 1) * kSubBuckets + mantissa;
+    return std::min(index, kBucketCount - 1);
+}
+
+/**
+ * @brief 获取桶的代表值（区间中点）
+ * @param index 桶下标
+ * @return 耗时（纳秒）
+ */
+double bucketValue(int index)
+{
+    if (index < kSubBuckets) {
+        return index;
+    }
+
+    const int exponent = index / kSubBuckets + kSubBucketBits - 1;
+    const int mantissa = index % kSubBuckets;
+    const double width = std::ldexp(1.0, exponent - kSubBucketBits);
+    return (kSubBuckets + mantissa) * width + width / 2.0;
+}
+
+/**
+ * @brief 原子变量的单写者累加（只有所属线程写入，无需读-改-写指令）
+ */
+inline void addRelaxed(std::atomic<quint64> &value, quint64 delta)
+{
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 原子计数器更新最大值
+ */
+inline void updateMax(std::atomic<qint64> &value, qint64 candidate)
+{
+    qint64 current = value.load(std::memory_order_relaxed);
+    while (candidate > current
+           && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+    }
+}
+
+// 用于区分PipelineStats实例，避免不同实例复用同一地址时误用旧的线程缓存
+std::atomic<quint64> s_nextInstanceId(1);
+
+} // namespace
+
+/**
+ * @brief 单个线程的直方图，只有所属线程写入，合并线程只读
+ */
+struct PipelineStats::ThreadHistograms {
+    std::atomic<quint64> buckets[kStageCount][kBucketCount];
+    std::atomic<quint64> totalNanoseconds[kStageCount];
+    std::atomic<quint64> maxNanoseconds[kStageCount];
+    bool inUse;
+
+    ThreadHistograms()
+        : inUse(true)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (int stage = 0; stage < kStageCount; ++stage) {
+            for (int i = 0; i < kBucketCount; ++i) {
+                buckets[stage][i].store(0, std::memory_order_relaxed);
+            }
+            totalNanoseconds[stage].store(0, std::memory_order_relaxed);
+            maxNanoseconds[stage].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief 已登记的线程直方图，线程退出后其直方图留给后来的线程复用
+ */
+struct PipelineStats::Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadHistograms>> histograms;
+    quint64 instanceId;
+};
+
+namespace {
+
+/**
+ * @brief 线程本地缓存：当前线程最近使用的统计对象及其直方图
+ *
+ * 持有Registry的共享引用，线程退出时即使统计对象已销毁也能安全归还直方图。
+ */
+struct ThreadSlot {
+    std::shared_ptr<void> registry;
+    quint64 instanceId = 0;
+    void *histograms = nullptr;
+    void (*release)(void *registry, void *histograms) = nullptr;
+
+    ~ThreadSlot()
+    {
+        if (release) {
+            release(registry.get(), histograms);
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+} // namespace
+
+PipelineStats::ScopedTimer::ScopedTimer(PipelineStats &stats, Stage stage)
+    : m_stats(stats)
+    , m_stage(stage)
+    , m_start(Clock::now())
+{
+}
+
+PipelineStats::ScopedTimer::~ScopedTimer()
+{
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+    m_stats.record(m_stage, elapsed.count());
+}
+
+PipelineStats::PipelineStats()
+    : m_registry(std::make_shared<Registry>())
+    , m_framesDecoded(0)
+    , m_framesPresented(0)
+    , m_framesDropped(0)
+    , m_framesLate(0)
+    , m_decodeErrors(0)
+    , m_openedAt(0)
+    , m_firstPresentedAt(0)
+    , m_queueHead(0)
+    , m_queueTail(0)
+    , m_maxQueueDepth(0)
+    , m_lateThreshold(0)
+{
+    m_registry->instanceId = s_nextInstanceId.fetch_add(1);
+    for (std::atomic<qint64> &queuedAt : m_queuedAt) {
+        queuedAt.store(0, std::memory_order_relaxed);
+    }
+}
+
+PipelineStats::~PipelineStats()
+{
+}
+
+void PipelineStats::record(Stage stage, qint64 nanoseconds)
+{
+    ThreadHistograms *local = localHistograms();
+    const int index = static_cast<int>(stage);
+    const quint64 value = nanoseconds > 0 ? static_cast<quint64>(nanoseconds) : 0;
+
+    addRelaxed(local->buckets[index][bucketIndex(value)], 1);
+    addRelaxed(local->totalNanoseconds[index], value);
+    if (value > local->maxNanoseconds[index].load(std::memory_order_relaxed)) {
+        local->maxNanoseconds[index].store(value, std::memory_order_relaxed);
+    }
+}
+
+void PipelineStats::addDecodedFrame()
+{
+    m_framesDecoded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineStats::markOpened(Clock::time_point openedAt)
+{
+    m_firstPresentedAt.store(0, std::memory_order_relaxed);
+    m_openedAt.store(openedAt.time_since_epoch().count(), std::memory_order_release);
+}
+
+void PipelineStats::addPresentedFrame()
+{
+    m_framesPresented.fetch_add(1, std::memory_order_relaxed);
+
+    // 只有打开后的第一帧能把时间戳从0改为当前时刻
+    if (m_firstPresentedAt.load(std::memory_order_relaxed) == 0) {
+        qint64 expected = 0;
+        m_firstPresentedAt.compare_exchange_strong(expected, Clock::now().time_since_epoch().count(),
+                                                   std::memory_order_relaxed);
+    }
+}
+
+void PipelineStats::addDroppedFrame()
+{
+    m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineStats::addLateFrame()
+{
+    m_framesLate.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineStats::addDecodeError()
+{
+    m_decodeErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PipelineStats::setLateThreshold(qint64 nanoseconds)
+{
+    m_lateThreshold.store(nanoseconds, std::memory_order_relaxed);
+}
+
+void PipelineStats::frameQueued()
+{
+    // 单生产者：写入时间戳后再发布新的队尾
+    const qint64 head = m_queueHead.load(std::memory_order_relaxed);
+    const qint64 now = Clock::now().time_since_epoch().count();
+    m_queuedAt[head % kQueueCapacity].store(now, std::memory_order_relaxed);
+    m_queueHead.store(head + 1, std::memory_order_release);
+
+    updateMax(m_maxQueueDepth, head + 1 - m_queueTail.load(std::memory_order_relaxed));
+}
+
+qint64 PipelineStats::frameDequeued()
+{
+    // 单消费者；积压超过容量时旧时间戳已被覆盖，排队耗时会略偏小
+    const qint64 tail = m_queueTail.load(std::memory_order_relaxed);
+    const qint64 head = m_queueHead.load(std::memory_order_acquire);
+    if (tail >= head) {
+        return 0;
+    }
+
+    const qint64 queuedAt = m_queuedAt[tail % kQueueCapacity].load(std::memory_order_relaxed);
+    m_queueTail.store(tail + 1, std::memory_order_relaxed);
+
+    const Clock::duration waited(Clock::now().time_since_epoch().count() - queuedAt);
+    const qint64 nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+    record(Stage::Queue, nanoseconds);
+
+    const qint64 threshold = m_lateThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && nanoseconds > threshold) {
+        addLateFrame();
+    }
+    return head - tail - 1;
+}
+
+PipelineStats::Snapshot PipelineStats::snapshot() const
+{
+    // 合并各线程的直方图
+    std::vector<quint64> merged(static_cast<size_t>(kStageCount) * kBucketCount, 0);
+    std::array<quint64, kStageCount> totals = {};
+    std::array<quint64, kStageCount> maxima = {};
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadHistograms> &local : m_registry->histograms) {
+            for (int stage = 0; stage < kStageCount; ++stage) {
+                for (int i = 0; i < kBucketCount; ++i) {
+                    merged[stage * kBucketCount + i] += local->buckets[stage][i].load(std::memory_order_relaxed);
+                }
+                totals[stage] += local->totalNanoseconds[stage].load(std::memory_order_relaxed);
+                maxima[stage] = std::max(maxima[stage], local->maxNanoseconds[stage].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    Snapshot snapshot;
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        const quint64 *buckets = merged.data() + stage * kBucketCount;
+        quint64 count = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            count += buckets[i];
+        }
+
+        // 按最近秩法在直方图中查找分位数
+        auto percentile = [buckets, count](double fraction) {
+            if (count == 0) {
+                return 0.0;
+            }
+            const quint64 rank = std::max<quint64>(1, static_cast<quint64>(std::ceil(fraction * count)));
+            quint64 seen = 0;
+            for (int i = 0; i < kBucketCount; ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return bucketValue(i) / 1000.0;
+                }
+            }
+            return bucketValue(kBucketCount - 1) / 1000.0;
+        };
+
+        StageSummary &summary = snapshot.stages[stage];
+        summary.count = count;
+        summary.mean = count ? totals[stage] / 1000.0 / count : 0.0;
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = maxima[stage] / 1000.0;
+    }
+
+    const qint64 head = m_queueHead.load(std::memory_order_acquire);
+    const qint64 tail = m_queueTail.load(std::memory_order_acquire);
+    snapshot.framesDecoded = m_framesDecoded.load(std::memory_order_relaxed);
+    snapshot.framesPresented = m_framesPresented.load(std::memory_order_relaxed);
+    snapshot.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+    snapshot.framesLate = m_framesLate.load(std::memory_order_relaxed);
+    snapshot.decodeErrors = m_decodeErrors.load(std::memory_order_relaxed);
+    snapshot.queueDepth = std::max<qint64>(0, head - tail);
+    snapshot.maxQueueDepth = m_maxQueueDepth.load(std::memory_order_relaxed);
+
+    const qint64 openedAt = m_openedAt.load(std::memory_order_acquire);
+    const qint64 firstPresentedAt = m_firstPresentedAt.load(std::memory_order_relaxed);
+    snapshot.timeToFirstFrame = -1.0;
+    if (openedAt != 0 && firstPresentedAt >= openedAt) {
+        const Clock::duration elapsed(firstPresentedAt - openedAt);
+        snapshot.timeToFirstFrame = std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+    return snapshot;
+}
+
+void PipelineStats::reset()
+{
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadHistograms> &local : m_registry->histograms) {
+            local->clear();
+        }
+    }
+
+    m_framesDecoded.store(0);
+    m_framesPresented.store(0);
+    m_framesDropped.store(0);
+    m_framesLate.store(0);
+    m_decodeErrors.store(0);
+    m_maxQueueDepth.store(0);
+    m_openedAt.store(0);
+    m_firstPresentedAt.store(0);
+
+    // 丢弃尚未被取走的排队记录
+    m_queueTail.store(m_queueHead.load());
+}
+
+const char *PipelineStats::stageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Read:
+        return "read";
+    case Stage::Decode:
+        return "decode";
+    case Stage::Convert:
+        return "convert";
+    case Stage::Queue:
+        return "queue";
+    case Stage::Present:
+        return "present";
+    case Stage::Count:
+        break;
+    }
+    return "unknown";
+}
+
+PipelineStats::ThreadHistograms *PipelineStats::localHistograms()
+{
+    // 快速路径：当前线程最近一次使用的就是本对象
+    if (t_slot.instanceId == m_registry->instanceId) {
+        return static_cast<ThreadHistograms *>(t_slot.histograms);
+    }
+
+    // 归还之前缓存的直方图
+    if (t_slot.release) {
+        t_slot.release(t_slot.registry.get(), t_slot.histograms);
+    }
+
+    ThreadHistograms *local = nullptr;
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadHistograms> &candidate : m_registry->histograms) {
+            if (!candidate->inUse) {
+                candidate->inUse = true;
+                local = candidate.get();
+                break;
+            }
+        }
+        if (!local) {
+            m_registry->histograms.push_back(std::make_unique<ThreadHistograms>());
+            local = m_registry->histograms.back().get();
+        }
+    }
+
+    t_slot.registry = m_registry;
+    t_slot.instanceId = m_registry->instanceId;
+    t_slot.histograms = local;
+    t_slot.release = [](void *registry, void *histograms) {
+        Registry *owner = static_cast<Registry *>(registry);
+        QMutexLocker locker(&owner->mutex);
+        static_cast<ThreadHistograms *>(histograms)->inUse = false;
+    };
+    return local;
+}
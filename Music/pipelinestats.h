@@ -0,0 +1,212 @@
+#ifndef PIPELINESTATS_H
+#define PIPELINESTATS_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+/**
+ * @brief 播放流水线的各阶段统计
+ *
+ * 记录读包、解码、转换、排队、显示各阶段的耗时分布，以及帧计数、队列深度等计数器。
+ * 耗时写入调用线程私有的直方图（单写者，只做relaxed读写，不加锁），
+ * snapshot时再把所有线程的直方图合并，适合在界面定时器中周期性读取。
+ * 计数器均为原子变量，可在任意线程更新。
+ */
+class PipelineStats
+{
+public:
+    /**
+     * @brief 流水线阶段
+     */
+    enum class Stage {
+        Read,
+        Decode,
+        Convert,
+        Queue,
+        Present,
+        Count
+    };
+
+    static const int kStageCount = static_cast<int>(Stage::Count);
+
+    /**
+     * @brief 计时用的单调时钟
+     */
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief 单个阶段的汇总结果（时间单位为微秒）
+     */
+    struct StageSummary {
+        quint64 count;
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    /**
+     * @brief 某一时刻的统计快照（timeToFirstFrame单位为毫秒，尚未显示首帧时为-1）
+     */
+    struct Snapshot {
+        std::array<StageSummary, kStageCount> stages;
+        qint64 framesDecoded;
+        qint64 framesPresented;
+        qint64 framesDropped;
+        qint64 framesLate;
+        qint64 decodeErrors;
+        qint64 queueDepth;
+        qint64 maxQueueDepth;
+        double timeToFirstFrame;
+    };
+
+    /**
+     * @brief 作用域计时器，析构时把耗时记入对应阶段
+     */
+    class ScopedTimer
+    {
+    public:
+        /**
+         * @brief 构造函数，开始计时
+         * @param stats 统计对象
+         * @param stage 阶段
+         */
+        ScopedTimer(PipelineStats &stats, Stage stage);
+
+        /**
+         * @brief 析构函数，记录耗时
+         */
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        PipelineStats &m_stats;
+        Stage m_stage;
+        Clock::time_point m_start;
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    PipelineStats();
+
+    /**
+     * @brief 析构函数
+     */
+    ~PipelineStats();
+
+    PipelineStats(const PipelineStats &) = delete;
+    PipelineStats &operator=(const PipelineStats &) = delete;
+
+    /**
+     * @brief 记录一次阶段耗时（写入当前线程私有的直方图）
+     * @param stage 阶段
+     * @param nanoseconds 耗时（纳秒）
+     */
+    void record(Stage stage, qint64 nanoseconds);
+
+    /**
+     * @brief 解码得到一帧
+     */
+    void addDecodedFrame();
+
+    /**
+     * @brief 记录打开文件的时刻，作为首帧耗时的起点
+     * @param openedAt 开始打开文件的时刻
+     */
+    void markOpened(Clock::time_point openedAt);
+
+    /**
+     * @brief 一帧已显示（打开文件后的第一帧同时记下首帧耗时）
+     */
+    void addPresentedFrame();
+
+    /**
+     * @brief 一帧被丢弃（转换失败或显示端积压时跳过）
+     */
+    void addDroppedFrame();
+
+    /**
+     * @brief 一帧显示晚于预期
+     */
+    void addLateFrame();
+
+    /**
+     * @brief 解码出错一次
+     */
+    void addDecodeError();
+
+    /**
+     * @brief 设置判定迟到的排队时长
+     * @param nanoseconds 排队超过该时长的帧记为迟到，0表示不判定
+     */
+    void setLateThreshold(qint64 nanoseconds);
+
+    /**
+     * @brief 一帧进入显示队列（由解码线程调用）
+     */
+    void frameQueued();
+
+    /**
+     * @brief 一帧离开显示队列（由显示线程调用），排队耗时记入Queue阶段，超时的记为迟到
+     * @return 离开后队列中剩余的帧数
+     */
+    qint64 frameDequeued();
+
+    /**
+     * @brief 合并所有线程的直方图和计数器
+     * @return 统计快照
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief 清零所有统计（打开新文件时调用）
+     */
+    void reset();
+
+    /**
+     * @brief 获取阶段名称
+     * @param stage 阶段
+     * @return 名称
+     */
+    static const char *stageName(Stage stage);
+
+private:
+    struct ThreadHistograms;
+    struct Registry;
+
+    /**
+     * @brief 获取当前线程在本对象中的直方图（首次调用时登记）
+     * @return 直方图
+     */
+    ThreadHistograms *localHistograms();
+
+    std::shared_ptr<Registry> m_registry;
+
+    // Frame counters
+    std::atomic<qint64> m_framesDecoded;
+    std::atomic<qint64> m_framesPresented;
+    std::atomic<qint64> m_framesDropped;
+    std::atomic<qint64> m_framesLate;
+    std::atomic<qint64> m_decodeErrors;
+
+    // Time to first frame (clock ticks, 0 when unset)
+    std::atomic<qint64> m_openedAt;
+    std::atomic<qint64> m_firstPresentedAt;
+
+    // Display queue (single producer, single consumer)
+    static const int kQueueCapacity = 64;
+    std::array<std::atomic<qint64>, kQueueCapacity> m_queuedAt;
+    std::atomic<qint64> m_queueHead;
+    std::atomic<qint64> m_queueTail;
+    std::atomic<qint64> m_maxQueueDepth;
+    std::atomic<qint64> m_lateThreshold;
+};
+
+#endif // PIPELINESTATS_H
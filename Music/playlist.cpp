@@ -0,0 +1,251 @@
+#include "playlist.h"
+#include "ffmpegwrapper.h"
+#include "mediadecoder.h"
+#include <QFileInfo>
+
+namespace {
+
+// 探测以读文件头为主，受磁盘而非CPU限制，少量线程即可
+const int kPoolThreads = 4;
+
+// 每项预热的字节数，覆盖文件头和起播所需的前几秒数据
+const qint64 kWarmUpBytes = 16LL * 1024 * 1024;
+
+// 线程池任务优先级：打开下一项最急，其次预热，探测排在最后
+const int kPreparePriority = 2;
+const int kWarmUpPriority = 1;
+const int kProbePriority = 0;
+
+} // namespace
+
+Playlist::Playlist(QObject *parent)
+    : QObject(parent)
+    , m_currentIndex(-1)
+    , m_lookahead(3)
+    , m_repeat(false)
+    , m_generation(0)
+    , m_preparedIndex(-1)
+    , m_preparedToken(0)
+{
+    m_pool.setMaxThreadCount(kPoolThreads);
+    m_pool.setObjectName("qvp-playlist");
+}
+
+Playlist::~Playlist()
+{
+    // 未开始的任务直接丢弃，进行中的任务结束后其结果不再被接收
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void Playlist::setLookahead(int count)
+{
+    m_lookahead = qMax(0, count);
+}
+
+int Playlist::lookahead() const
+{
+    return m_lookahead;
+}
+
+void Playlist::setRepeat(bool repeat)
+{
+    m_repeat = repeat;
+}
+
+bool Playlist::isRepeat() const
+{
+    return m_repeat;
+}
+
+void Playlist::addFiles(const QStringList &filePaths)
+{
+    if (filePaths.isEmpty()) {
+        return;
+    }
+
+    const int first = m_items.size();
+    m_items.reserve(first + filePaths.size());
+    for (const QString &filePath : filePaths) {
+        Item item;
+        item.filePath = filePath;
+        item.state = NotProbed;
+        item.info.filePath = filePath;
+        m_items.append(item);
+    }
+    emit itemsInserted(first, m_items.size() - 1);
+
+    // 在列表末尾循环时，新加入的项可能成为下一项
+    if (m_currentIndex >= 0) {
+        prepareUpcoming();
+    }
+}
+
+void Playlist::clear()
+{
+    m_pool.clear();
+    ++m_generation;
+    discardPrepared();
+
+    m_items.clear();
+    m_currentIndex = -1;
+    emit itemsCleared();
+}
+
+void Playlist::requestProbe(int index)
+{
+    if (index < 0 || index >= m_items.size() || m_items.at(index).state != NotProbed) {
+        return;
+    }
+    m_items[index].state = Probing;
+    startProbe(index);
+}
+
+int Playlist::count() const
+{
+    return m_items.size();
+}
+
+const Playlist::Item &Playlist::item(int index) const
+{
+    return m_items.at(index);
+}
+
+int Playlist::currentIndex() const
+{
+    return m_currentIndex;
+}
+
+void Playlist::setCurrentIndex(int index)
+{
+    if (index < -1 || index >= m_items.size()) {
+        return;
+    }
+    if (index != m_currentIndex) {
+        m_currentIndex = index;
+        emit currentIndexChanged(index);
+    }
+    prepareUpcoming();
+}
+
+int Playlist::nextIndex() const
+{
+    if (m_items.isEmpty()) {
+        return -1;
+    }
+    if (m_currentIndex + 1 < m_items.size()) {
+        return m_currentIndex + 1;
+    }
+    return m_repeat ? 0 : -1;
+}
+
+int Playlist::previousIndex() const
+{
+    if (m_items.isEmpty()) {
+        return -1;
+    }
+    if (m_currentIndex > 0) {
+        return m_currentIndex - 1;
+    }
+    return m_repeat ? m_items.size() - 1 : -1;
+}
+
+std::unique_ptr<MediaDecoder> Playlist::takePreparedDecoder(int index)
+{
+    QMutexLocker locker(&m_preparedMutex);
+    if (index < 0 || index != m_preparedIndex || !m_preparedDecoder) {
+        return nullptr;
+    }
+    m_preparedIndex = -1;
+    return std::move(m_preparedDecoder);
+}
+
+void Playlist::startProbe(int index)
+{
+    const quint64 generation = m_generation;
+    const QString filePath = m_items.at(index).filePath;
+    m_pool.start([this, generation, index, filePath]() {
+        // 列表只显示文字信息，封面数据可能有几MB，不随列表项保存
+        MediaProber prober;
+        prober.setCoverArtEnabled(false);
+        MediaInfo info;
+        const bool ok = prober.probe(filePath, &info);
+
+        // 回到界面线程更新；期间列表被清空时丢弃
+        QMetaObject::invokeMethod(this, [this, generation, index, ok, info]() {
+            if (generation != m_generation || index >= m_items.size()) {
+                return;
+            }
+            Item &item = m_items[index];
+            item.state = ok ? Probed : ProbeFailed;
+            item.info = info;
+            emit itemChanged(index);
+        }, Qt::QueuedConnection);
+    }, kProbePriority);
+}
+
+void Playlist::prepareUpcoming()
+{
+    const int next = nextIndex();
+    if (next < 0 || next == m_currentIndex) {
+        discardPrepared();
+        return;
+    }
+
+    // 其后的若干项只读入页缓存，不占用文件句柄和解码器
+    int index = next;
+    for (int i = 0; i < m_lookahead && !m_items.isEmpty(); ++i) {
+        index = (index + 1) % m_items.size();
+        if (index == m_currentIndex || index == next || (!m_repeat && index <= next)) {
+            break;
+        }
+        const QString filePath = m_items.at(index).filePath;
+        if (QFileInfo(filePath).isFile()) {
+            m_pool.start([filePath]() {
+                MediaProber::warmUp(filePath, kWarmUpBytes);
+            }, kWarmUpPriority);
+        }
+    }
+
+    // 下一项已经打开（或正在打开）时不重复打开
+    quint64 token;
+    {
+        QMutexLocker locker(&m_preparedMutex);
+        if (m_preparedIndex == next) {
+            return;
+        }
+    }
+    discardPrepared();
+    {
+        QMutexLocker locker(&m_preparedMutex);
+        m_preparedIndex = next;
+        token = m_preparedToken;
+    }
+
+    const QString filePath = m_items.at(next).filePath;
+    m_pool.start([this, token, filePath]() {
+        std::unique_ptr<MediaDecoder> decoder = FFmpegWrapper::createDecoder();
+        if (!decoder->open(filePath)) {
+            return;
+        }
+
+        // 打开期间当前项又变了，这次的结果作废（解码器在锁释放后析构）
+        QMutexLocker locker(&m_preparedMutex);
+        if (token == m_preparedToken) {
+            m_preparedDecoder = std::move(decoder);
+        }
+    }, kPreparePriority);
+}
+
+void Playlist::discardPrepared()
+{
+    std::unique_ptr<MediaDecoder> decoder;
+    {
+        QMutexLocker locker(&m_preparedMutex);
+        ++m_preparedToken;
+        m_preparedIndex = -1;
+        decoder = std::move(m_preparedDecoder);
+    }
+    // 关闭解码器会等待其预读线程退出，不在锁内进行
+    decoder.reset();
+}
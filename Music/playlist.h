@@ -0,0 +1,204 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+#include "mediaprober.h"
+
+class MediaDecoder;
+
+/**
+ * @brief 播放列表
+ *
+ * 保存待播放的文件，并在后台线程池中为后续切换做准备：
+ * - 列表项在第一次被requestProbe（通常是视图绘制到该行）时才探测时长、流和标签，完成后发出itemChanged；
+ *   加入十万项只是追加路径，不会一次排出十万个探测任务，也不保存封面数据（封面由ThumbnailLoader按需加载）
+ * - 当前项之后的若干项提前读入系统页缓存
+ * - 紧接着的下一项直接用FFmpegWrapper::createDecoder打开，切换时由takePreparedDecoder交给播放引擎，
+ *   文件头解析和解码器初始化不再发生在切换的那一刻
+ * 只能在创建它的线程（界面线程）中调用；后台结果以排队调用的方式回到该线程。
+ */
+class Playlist : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 探测状态
+     */
+    enum ProbeState {
+        NotProbed,
+        Probing,
+        Probed,
+        ProbeFailed
+    };
+
+    /**
+     * @brief 列表项
+     */
+    struct Item {
+        QString filePath;
+        ProbeState state;
+        MediaInfo info;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit Playlist(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（等待后台任务结束）
+     */
+    ~Playlist() override;
+
+    /**
+     * @brief 设置提前读入页缓存的项数（不含已提前打开的下一项）
+     * @param count 项数
+     */
+    void setLookahead(int count);
+
+    /**
+     * @brief 获取提前读入页缓存的项数
+     * @return 项数
+     */
+    int lookahead() const;
+
+    /**
+     * @brief 设置播放到末尾后是否回到第一项
+     * @param repeat 是否循环
+     */
+    void setRepeat(bool repeat);
+
+    /**
+     * @brief 获取是否循环
+     * @return 是否循环
+     */
+    bool isRepeat() const;
+
+    /**
+     * @brief 在末尾追加文件（不探测）
+     * @param filePaths 文件路径
+     */
+    void addFiles(const QStringList &filePaths);
+
+    /**
+     * @brief 尚未探测的项排队探测，已探测或正在探测的项忽略
+     * @param index 序号
+     */
+    void requestProbe(int index);
+
+    /**
+     * @brief 清空列表，丢弃尚未完成的后台结果
+     */
+    void clear();
+
+    /**
+     * @brief 获取项数
+     * @return 项数
+     */
+    int count() const;
+
+    /**
+     * @brief 获取列表项
+     * @param index 序号，必须有效
+     * @return 列表项
+     */
+    const Item &item(int index) const;
+
+    /**
+     * @brief 获取当前项序号
+     * @return 序号，没有当前项时为-1
+     */
+    int currentIndex() const;
+
+    /**
+     * @brief 设置当前项，并为其后的项预热页缓存、提前打开下一项
+     * @param index 序号
+     */
+    void setCurrentIndex(int index);
+
+    /**
+     * @brief 获取当前项的下一项（按循环设置）
+     * @return 序号，没有下一项时为-1
+     */
+    int nextIndex() const;
+
+    /**
+     * @brief 获取当前项的上一项（按循环设置）
+     * @return 序号，没有上一项时为-1
+     */
+    int previousIndex() const;
+
+    /**
+     * @brief 取走为指定项提前打开的解码器
+     * @param index 序号
+     * @return 解码器，尚未打开完成或不是为该项打开的时返回空，调用者应自行打开
+     */
+    std::unique_ptr<MediaDecoder> takePreparedDecoder(int index);
+
+signals:
+    /**
+     * @brief 追加了列表项
+     * @param first 第一项的序号
+     * @param last 最后一项的序号
+     */
+    void itemsInserted(int first, int last);
+
+    /**
+     * @brief 列表已清空
+     */
+    void itemsCleared();
+
+    /**
+     * @brief 列表项的探测结果已更新
+     * @param index 序号
+     */
+    void itemChanged(int index);
+
+    /**
+     * @brief 当前项已改变
+     * @param index 序号
+     */
+    void currentIndexChanged(int index);
+
+private:
+    /**
+     * @brief 在线程池中探测一项，结果排队回到本对象所在线程
+     * @param index 序号
+     */
+    void startProbe(int index);
+
+    /**
+     * @brief 预热当前项之后的若干项，并在后台打开下一项
+     */
+    void prepareUpcoming();
+
+    /**
+     * @brief 丢弃已提前打开的解码器（或作废正在打开的那一个）
+     */
+    void discardPrepared();
+
+    QVector<Item> m_items;
+    int m_currentIndex;
+    int m_lookahead;
+    bool m_repeat;
+
+    // Worker pool for probing, page-cache warm-up and opening the next item
+    QThreadPool m_pool;
+    quint64 m_generation;
+
+    // Decoder opened ahead for the next item; filled in by a pool thread
+    QMutex m_preparedMutex;
+    std::unique_ptr<MediaDecoder> m_preparedDecoder;
+    int m_preparedIndex;
+    quint64 m_preparedToken;
+};
+
+#endif // PLAYLIST_H
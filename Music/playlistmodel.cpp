@@ -0,0 +1,141 @@
+#include "playlistmodel.h"
+#include "playlist.h"
+#include "thumbnailloader.h"
+#include <QFileInfo>
+#include <QFont>
+
+PlaylistModel::PlaylistModel(Playlist *playlist, ThumbnailLoader *thumbnails, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_playlist(playlist)
+    , m_thumbnails(thumbnails)
+    , m_count(playlist->count())
+    , m_currentIndex(playlist->currentIndex())
+{
+    connect(m_playlist, &Playlist::itemsInserted, this, &PlaylistModel::onItemsInserted);
+    connect(m_playlist, &Playlist::itemsCleared, this, &PlaylistModel::onItemsCleared);
+    connect(m_playlist, &Playlist::itemChanged, this, &PlaylistModel::onItemChanged);
+    connect(m_playlist, &Playlist::currentIndexChanged, this, &PlaylistModel::onCurrentIndexChanged);
+    if (m_thumbnails) {
+        connect(m_thumbnails, &ThumbnailLoader::thumbnailReady, this, &PlaylistModel::onThumbnailReady);
+    }
+}
+
+int PlaylistModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant PlaylistModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+    const Playlist::Item &item = m_playlist->item(row);
+
+    switch (role) {
+    case Qt::DisplayRole:
+        // 第一次显示到这一行时才探测
+        m_playlist->requestProbe(row);
+        if (item.info.title.isEmpty()) {
+            return QFileInfo(item.filePath).fileName();
+        }
+        if (item.info.artist.isEmpty()) {
+            return item.info.title;
+        }
+        return item.info.artist + " - " + item.info.title;
+    case Qt::DecorationRole: {
+        // 探测完成、确认有封面后才加载缩略图
+        if (!m_thumbnails) {
+            return QVariant();
+        }
+        if (item.state != Playlist::Probed || !item.info.hasCoverArt) {
+            return m_thumbnails->placeholder();
+        }
+        const QImage image = m_thumbnails->thumbnail(item.filePath);
+        if (image.isNull()) {
+            m_thumbnailRows.insert(item.filePath, row);
+            return m_thumbnails->placeholder();
+        }
+        return image;
+    }
+    case Qt::ToolTipRole:
+    case FilePathRole:
+        return item.filePath;
+    case Qt::FontRole:
+        if (row == m_currentIndex) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        return QVariant();
+    case DurationRole:
+        return item.info.duration;
+    case IsCurrentRole:
+        return row == m_currentIndex;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> PlaylistModel::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractListModel::roleNames();
+    names.insert(FilePathRole, "filePath");
+    names.insert(DurationRole, "duration");
+    names.insert(IsCurrentRole, "isCurrent");
+    return names;
+}
+
+void PlaylistModel::onItemsInserted(int first, int last)
+{
+    beginInsertRows(QModelIndex(), first, last);
+    m_count = m_playlist->count();
+    endInsertRows();
+}
+
+void PlaylistModel::onItemsCleared()
+{
+    beginResetModel();
+    m_count = 0;
+    m_currentIndex = -1;
+    m_thumbnailRows.clear();
+    endResetModel();
+}
+
+void PlaylistModel::onItemChanged(int index)
+{
+    if (index < m_count) {
+        const QModelIndex changed = this->index(index);
+        emit dataChanged(changed, changed);
+    }
+}
+
+void PlaylistModel::onCurrentIndexChanged(int index)
+{
+    const int previous = m_currentIndex;
+    m_currentIndex = index;
+    if (previous >= 0 && previous < m_count) {
+        const QModelIndex changed = this->index(previous);
+        emit dataChanged(changed, changed, {Qt::FontRole, IsCurrentRole});
+    }
+    if (index >= 0 && index < m_count) {
+        const QModelIndex changed = this->index(index);
+        emit dataChanged(changed, changed, {Qt::FontRole, IsCurrentRole});
+    }
+}
+
+void PlaylistModel::onThumbnailReady(const QString &filePath)
+{
+    const auto it = m_thumbnailRows.constFind(filePath);
+    if (it == m_thumbnailRows.constEnd()) {
+        return;
+    }
+    const int row = it.value();
+    m_thumbnailRows.remove(filePath);
+    if (row < m_count) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {Qt::DecorationRole});
+    }
+}
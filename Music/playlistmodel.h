@@ -0,0 +1,86 @@
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+
+class Playlist;
+class ThumbnailLoader;
+
+/**
+ * @brief 播放列表的列表模型
+ *
+ * 直接读取Playlist中的列表项，不复制数据；行数随Playlist的信号同步（保存一份行数，
+ * 使begin/endInsertRows之间rowCount仍返回旧值）。
+ * 视图取某行的数据时才请求探测该项和加载其封面缩略图，结果到达后只刷新该行。
+ * 配合QListView的uniformItemSizes使用时，十万项的列表也只为可见行取数据。
+ */
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 自定义数据角色
+     */
+    enum Roles {
+        FilePathRole = Qt::UserRole + 1,
+        DurationRole,
+        IsCurrentRole
+    };
+
+    /**
+     * @brief 构造函数
+     * @param playlist 播放列表，生命周期需长于本模型
+     * @param thumbnails 缩略图加载器，可为nullptr（不显示封面）
+     * @param parent 父对象
+     */
+    PlaylistModel(Playlist *playlist, ThumbnailLoader *thumbnails, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private slots:
+    /**
+     * @brief 播放列表追加了项
+     * @param first 第一项的序号
+     * @param last 最后一项的序号
+     */
+    void onItemsInserted(int first, int last);
+
+    /**
+     * @brief 播放列表已清空
+     */
+    void onItemsCleared();
+
+    /**
+     * @brief 某项的探测结果已更新
+     * @param index 序号
+     */
+    void onItemChanged(int index);
+
+    /**
+     * @brief 当前项已改变
+     * @param index 序号
+     */
+    void onCurrentIndexChanged(int index);
+
+    /**
+     * @brief 缩略图已加载
+     * @param filePath 媒体文件路径
+     */
+    void onThumbnailReady(const QString &filePath);
+
+private:
+    Playlist *m_playlist;
+    ThumbnailLoader *m_thumbnails;
+    int m_count;
+    int m_currentIndex;
+
+    // Rows waiting for a thumbnail, keyed by file path
+    mutable QHash<QString, int> m_thumbnailRows;
+};
+
+#endif // PLAYLISTMODEL_H
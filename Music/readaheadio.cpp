@@ -0,0 +1,528 @@
+#include "readaheadio.h"
+#include <QElapsedTimer>
+#include <cstring>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+
+// AVIOContext自身的缓冲区，解复用器每次从环形缓冲区取这么多
+const int kContextBufferSize = 256 * 1024;
+
+// 预读线程单次读取的上限，慢速设备上每次读取的耗时不会过长
+const qint64 kReadChunk = 1024 * 1024;
+
+// 环形缓冲区按页对齐，便于内核直接拷贝整页
+const size_t kRingAlignment = 4096;
+
+// io_uring同时在途的读取数和单个读取的上限；读取大小随缓冲区增大，在途部分最多占一半缓冲区
+const size_t kUringDepth = 4;
+const qint64 kUringMaxChunk = 8 * 1024 * 1024;
+
+// 取消操作自身完成事件的标识（读取以文件偏移为标识，不会与之冲突）
+const quint64 kUringCancelTag = ~0ULL;
+
+} // namespace
+
+ReadAheadIO::ReadAheadIO()
+    : m_fileSize(0)
+    , m_context(nullptr)
+    , m_ring(nullptr)
+    , m_capacity(0)
+    , m_readOffset(0)
+    , m_writeOffset(0)
+    , m_validStart(0)
+    , m_generation(0)
+    , m_endOfFile(false)
+    , m_readError(false)
+    , m_thread(nullptr)
+    , m_running(false)
+    , m_usingUring(false)
+    , m_submitOffset(0)
+    , m_uringBusySince(-1)
+    , m_stats()
+    , m_readNs(0)
+{
+}
+
+ReadAheadIO::~ReadAheadIO()
+{
+    close();
+}
+
+bool ReadAheadIO::open(const QString &filePath, qint64 bufferSize, bool preferUring)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        m_errorString = QString("无法打开文件：%1").arg(filePath);
+        return false;
+    }
+    m_fileSize = m_file.size();
+
+    // 容量按对齐粒度向上取整
+    m_capacity = (qMax<qint64>(bufferSize, kReadChunk) + kRingAlignment - 1) / kRingAlignment * kRingAlignment;
+    m_ring = static_cast<uchar *>(qMallocAligned(static_cast<size_t>(m_capacity), kRingAlignment));
+    unsigned char *contextBuffer = static_cast<unsigned char *>(av_malloc(kContextBufferSize));
+    if (m_ring) {
+        m_context = avio_alloc_context(contextBuffer, kContextBufferSize, 0, this,
+                                       &ReadAheadIO::readPacket, nullptr, &ReadAheadIO::seekPacket);
+    }
+    if (!m_context) {
+        av_free(contextBuffer);
+        m_errorString = "内存不足";
+        close();
+        return false;
+    }
+
+    {
+        // 统计可能正被其他线程读取
+        QMutexLocker locker(&m_mutex);
+        m_readOffset = 0;
+        m_writeOffset = 0;
+        m_validStart = 0;
+        m_generation = 0;
+        m_endOfFile = false;
+        m_readError = false;
+        m_stats = Stats();
+        m_readNs = 0;
+        m_submitOffset = 0;
+        m_uringBusySince = -1;
+    }
+
+    advise(0, true);
+
+    // 读取和取消各占一半提交队列，取消全部在途读取时不会排不下
+    m_usingUring = preferUring && m_uring.open(2 * kUringDepth);
+    if (m_usingUring) {
+        m_uringClock.start();
+        QMutexLocker locker(&m_mutex);
+        pumpUring(false);
+        return true;
+    }
+
+    m_running = true;
+    m_thread = QThread::create([this]() {
+        readLoop();
+    });
+    m_thread->setObjectName("qvp-readahead");
+    m_thread->start();
+    return true;
+}
+
+void ReadAheadIO::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // 内核写完或放弃在途读取之前不能释放环形缓冲区
+        if (m_usingUring) {
+            cancelUring();
+        }
+        m_running = false;
+        m_spaceAvailable.wakeAll();
+        m_dataAvailable.wakeAll();
+    }
+
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_uring.close();
+    m_usingUring = false;
+
+    if (m_context) {
+        av_freep(&m_context->buffer);
+        avio_context_free(&m_context);
+    }
+
+    qFreeAligned(m_ring);
+    m_ring = nullptr;
+    m_capacity = 0;
+    m_file.close();
+}
+
+bool ReadAheadIO::isUsingUring() const
+{
+    return m_usingUring;
+}
+
+AVIOContext *ReadAheadIO::context() const
+{
+    return m_context;
+}
+
+ReadAheadIO::Stats ReadAheadIO::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.readMBps = m_readNs > 0 ? m_stats.bytesRead / (m_readNs / 1.0e9) / (1024.0 * 1024.0) : 0.0;
+    stats.buffered = m_writeOffset - m_readOffset;
+    return stats;
+}
+
+QString ReadAheadIO::errorString() const
+{
+    return m_errorString;
+}
+
+bool ReadAheadIO::isLocalFile(const QString &url)
+{
+    // 带协议前缀的URL（http://、rtsp://、file:等）交给FFmpeg；Windows盘符形如"C:"，不算协议
+    int schemeLength = 0;
+    while (schemeLength < url.size() && url.at(schemeLength).isLetterOrNumber()) {
+        ++schemeLength;
+    }
+    if (schemeLength > 1 && schemeLength < url.size() && url.at(schemeLength) == QLatin1Char(':')) {
+        return false;
+    }
+    return QFile::exists(url);
+}
+
+int ReadAheadIO::readPacket(void *opaque, uint8_t *buffer, int size)
+{
+    return static_cast<ReadAheadIO *>(opaque)->read(buffer, size);
+}
+
+int64_t ReadAheadIO::seekPacket(void *opaque, int64_t offset, int whence)
+{
+    return static_cast<ReadAheadIO *>(opaque)->seek(offset, whence);
+}
+
+int ReadAheadIO::read(uint8_t *buffer, int size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_usingUring) {
+        // 收取已完成的读取并补发；缓冲区为空时记一次停顿，等待最早的读取完成
+        pumpUring(false);
+        if (m_readOffset == m_writeOffset && !m_endOfFile && !m_readError) {
+            ++m_stats.stalls;
+            QElapsedTimer stallClock;
+            stallClock.start();
+            while (m_readOffset == m_writeOffset && !m_endOfFile && !m_readError) {
+                pumpUring(true);
+            }
+            m_stats.stallMs += stallClock.nsecsElapsed() / 1.0e6;
+        }
+    } else if (m_readOffset == m_writeOffset && !m_endOfFile && !m_readError && m_running) {
+        // 缓冲区为空：记一次停顿并等待预读线程
+        ++m_stats.stalls;
+        QElapsedTimer stallClock;
+        stallClock.start();
+        while (m_readOffset == m_writeOffset && !m_endOfFile && !m_readError && m_running) {
+            m_dataAvailable.wait(&m_mutex);
+        }
+        m_stats.stallMs += stallClock.nsecsElapsed() / 1.0e6;
+    }
+
+    if (m_readOffset == m_writeOffset) {
+        return m_readError ? AVERROR(EIO) : AVERROR_EOF;
+    }
+
+    // 只拷贝到环形缓冲区末尾为止，绕回的部分留给下一次调用
+    const qint64 index = m_readOffset % m_capacity;
+    const int count = static_cast<int>(qMin<qint64>(qMin<qint64>(size, m_writeOffset - m_readOffset),
+                                                    m_capacity - index));
+    const qint64 readOffset = m_readOffset;
+    locker.unlock();
+
+    // [m_readOffset, m_writeOffset)不会被预读线程覆盖，可以在锁外拷贝
+    std::memcpy(buffer, m_ring + index, count);
+
+    locker.relock();
+    m_readOffset = readOffset + count;
+    m_stats.bytesDelivered += count;
+    m_spaceAvailable.wakeAll();
+
+    // 腾出的空间立即交给新的读取，解复用器处理这批数据时读取已在进行
+    if (m_usingUring) {
+        pumpUring(false);
+    }
+    return count;
+}
+
+int64_t ReadAheadIO::seek(int64_t offset, int whence)
+{
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) {
+        return m_fileSize;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    qint64 target;
+    switch (whence) {
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = m_readOffset + offset;
+        break;
+    case SEEK_END:
+        target = m_fileSize + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+
+    // 目标仍在环形缓冲区内（包括已交出但尚未被覆盖的数据）时只移动读取位置
+    if (target >= m_validStart && target <= m_writeOffset) {
+        m_readOffset = target;
+        m_spaceAvailable.wakeAll();
+        return target;
+    }
+
+    // 远距离跳转：丢弃缓冲数据，由预读线程从新位置重新开始；io_uring取消在途读取后从新位置重新发出
+    if (m_usingUring) {
+        cancelUring();
+    }
+    ++m_stats.seeks;
+    ++m_generation;
+    m_readOffset = target;
+    m_writeOffset = target;
+    m_validStart = target;
+    m_endOfFile = false;
+    m_readError = false;
+    m_spaceAvailable.wakeAll();
+    if (m_usingUring) {
+        m_submitOffset = target;
+        advise(target, false);
+        pumpUring(false);
+    }
+    return target;
+}
+
+void ReadAheadIO::readLoop()
+{
+    quint64 generation = 0;
+    for (;;) {
+        qint64 writeOffset;
+        qint64 chunk;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_running && m_generation == generation
+                   && (m_endOfFile || m_readError || m_writeOffset - m_readOffset >= m_capacity)) {
+                m_spaceAvailable.wait(&m_mutex);
+            }
+            if (!m_running) {
+                break;
+            }
+
+            // 跳转后从新位置读取，并提示内核预读该位置
+            const bool relocated = m_generation != generation;
+            generation = m_generation;
+            writeOffset = m_writeOffset;
+            if (relocated) {
+                locker.unlock();
+                if (!m_file.seek(writeOffset)) {
+                    locker.relock();
+                    if (m_generation == generation) {
+                        m_readError = true;
+                        m_dataAvailable.wakeAll();
+                    }
+                    continue;
+                }
+                advise(writeOffset, false);
+                locker.relock();
+                if (m_generation != generation) {
+                    continue;
+                }
+            }
+
+            // 只写到环形缓冲区末尾；写入前先让出这段区域，跳转不会再落到即将被覆盖的旧数据上
+            const qint64 index = writeOffset % m_capacity;
+            chunk = qMin(qMin(m_capacity - (writeOffset - m_readOffset), m_capacity - index), kReadChunk);
+            m_validStart = qMax(m_validStart, writeOffset + chunk - m_capacity);
+        }
+
+        QElapsedTimer readClock;
+        readClock.start();
+        const qint64 count = m_file.read(reinterpret_cast<char *>(m_ring + writeOffset % m_capacity), chunk);
+        const qint64 elapsed = readClock.nsecsElapsed();
+
+        QMutexLocker locker(&m_mutex);
+        // 读取期间发生了远距离跳转，这次的数据作废
+        if (m_generation != generation) {
+            continue;
+        }
+        if (count < 0) {
+            m_readError = true;
+        } else if (count == 0) {
+            m_endOfFile = true;
+        } else {
+            m_writeOffset = writeOffset + count;
+            m_stats.bytesRead += count;
+            m_readNs += elapsed;
+        }
+        m_dataAvailable.wakeAll();
+    }
+}
+
+void ReadAheadIO::pumpUring(bool wait)
+{
+    // 补发读取：不超过在途上限，也不覆盖尚未交出的数据；到文件末尾为止
+    const int fd = m_file.handle();
+    const qint64 chunk = qBound(kReadChunk, m_capacity / static_cast<qint64>(2 * kUringDepth), kUringMaxChunk);
+    while (!m_endOfFile && !m_readError && m_uringReads.size() < kUringDepth && m_submitOffset < m_fileSize) {
+        const qint64 index = m_submitOffset % m_capacity;
+        const qint64 length = qMin(qMin(chunk, m_capacity - index), m_fileSize - m_submitOffset);
+        if (m_submitOffset + length - m_readOffset > m_capacity
+                || !m_uring.queueRead(fd, m_ring + index, static_cast<unsigned>(length), m_submitOffset,
+                                      static_cast<quint64>(m_submitOffset))) {
+            break;
+        }
+
+        // 与预读线程相同：先让出即将被覆盖的区域
+        m_validStart = qMax(m_validStart, m_submitOffset + length - m_capacity);
+        if (m_uringReads.empty()) {
+            m_uringBusySince = m_uringClock.nsecsElapsed();
+        }
+        m_uringReads.push_back({ m_submitOffset, length, 0, true });
+        m_submitOffset += length;
+    }
+
+    // 没有在途读取时无事可等；未到文件末尾却发不出读取（提交队列异常）时按读取失败处理，避免空等
+    if (m_uringReads.empty()) {
+        if (m_writeOffset >= m_fileSize) {
+            m_endOfFile = true;
+        } else if (wait) {
+            m_readError = true;
+        }
+        return;
+    }
+
+    // 等待时放开锁，统计读取不会被阻塞；偏移只由本线程修改
+    m_mutex.unlock();
+    const int submitted = m_uring.submit(wait ? 1 : 0);
+    m_mutex.lock();
+    if (submitted < 0) {
+        m_readError = true;
+        cancelUring();
+        return;
+    }
+
+    quint64 userData = 0;
+    int result = 0;
+    while (m_uring.popCompletion(&userData, &result)) {
+        if (userData == kUringCancelTag) {
+            continue;
+        }
+        for (UringRead &read : m_uringReads) {
+            if (read.pending && static_cast<quint64>(read.offset) == userData) {
+                read.pending = false;
+                read.result = result;
+                break;
+            }
+        }
+    }
+
+    // 读取可能乱序完成，只按文件顺序把连续完成的部分并入缓冲数据
+    bool restart = false;
+    while (!m_uringReads.empty() && !m_uringReads.front().pending) {
+        const UringRead read = m_uringReads.front();
+        m_uringReads.pop_front();
+        if (read.result > 0) {
+            m_writeOffset += read.result;
+            m_stats.bytesRead += read.result;
+            // 读到的比请求的少：后面的读取与这里接不上，需要从实际读到的位置重新发出
+            if (read.result < read.length) {
+                restart = true;
+                break;
+            }
+        } else {
+            // 读到0字节说明文件在打开后被截短
+            if (read.result == 0) {
+                m_endOfFile = true;
+            } else {
+                m_readError = true;
+            }
+            restart = true;
+            break;
+        }
+    }
+    if (restart) {
+        cancelUring();
+        m_submitOffset = m_writeOffset;
+    }
+
+    // 吞吐量按有读取在途的时间计算，完成后等待被收取的时间也计入，结果偏保守
+    if (m_uringReads.empty() && m_uringBusySince >= 0) {
+        m_readNs += m_uringClock.nsecsElapsed() - m_uringBusySince;
+        m_uringBusySince = -1;
+    }
+}
+
+void ReadAheadIO::cancelUring()
+{
+    for (const UringRead &read : m_uringReads) {
+        if (read.pending) {
+            m_uring.queueCancel(static_cast<quint64>(read.offset), kUringCancelTag);
+        }
+    }
+
+    // 被取消的读取以ECANCELED完成，已在执行的读取正常完成，结果都丢弃
+    auto hasPending = [this]() {
+        for (const UringRead &read : m_uringReads) {
+            if (read.pending) {
+                return true;
+            }
+        }
+        return false;
+    };
+    while (hasPending()) {
+        m_mutex.unlock();
+        const int submitted = m_uring.submit(1);
+        m_mutex.lock();
+        if (submitted < 0) {
+            break;
+        }
+
+        quint64 userData = 0;
+        int result = 0;
+        while (m_uring.popCompletion(&userData, &result)) {
+            for (UringRead &read : m_uringReads) {
+                if (read.pending && static_cast<quint64>(read.offset) == userData) {
+                    read.pending = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    m_uringReads.clear();
+    if (m_uringBusySince >= 0) {
+        m_readNs += m_uringClock.nsecsElapsed() - m_uringBusySince;
+        m_uringBusySince = -1;
+    }
+}
+
+void ReadAheadIO::advise(qint64 offset, bool sequential)
+{
+#if defined(__linux__)
+    const int fd = m_file.handle();
+    if (fd < 0) {
+        return;
+    }
+    if (sequential) {
+        posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+    } else {
+        posix_fadvise(fd, offset, m_capacity, POSIX_FADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(offset);
+    Q_UNUSED(sequential);
+#endif
+}
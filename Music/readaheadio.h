@@ -0,0 +1,203 @@
+#ifndef READAHEADIO_H
+#define READAHEADIO_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include "iouring.h"
+
+extern "C" {
+    struct AVIOContext;
+}
+
+/**
+ * @brief 带预读线程的本地文件输入层
+ *
+ * 替代FFmpeg默认的file协议：独立线程按顺序把文件读入数MB的环形缓冲区，
+ * 解码线程通过自定义AVIOContext从缓冲区取数据，慢速U盘或NFS上的单次读取延迟
+ * 不再直接卡住解码。已读过但尚未被覆盖的数据仍保留在环形缓冲区中，
+ * 落在缓冲范围内的短距离跳转（包括解复用器常见的小幅回退）不需要重新读文件。
+ * Linux上打开时提示内核按顺序读取（posix_fadvise），远距离跳转后提示预读新位置。
+ * Linux上可改用io_uring：不再启动预读线程，由解码线程在AVIO回调中保持数个大块读取同时在途，
+ * 高速NVMe上单个读取的延迟不再叠加；远距离跳转时取消在途读取并从新位置重新发出。
+ * 内核不支持io_uring时自动退回预读线程。
+ * AVIO回调只在解码线程中调用；统计可在任意线程读取。
+ */
+class ReadAheadIO
+{
+public:
+    /**
+     * @brief 输入统计（seeks只计缓冲范围外、需要重新定位文件的跳转；stalls为解复用器要数据时缓冲区为空的次数；
+     * readMBps只计文件读取本身的耗时；buffered为已预读、尚未交出的字节数）
+     */
+    struct Stats {
+        quint64 bytesRead;
+        quint64 bytesDelivered;
+        quint64 seeks;
+        quint64 stalls;
+        double stallMs;
+        double readMBps;
+        qint64 buffered;
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    ReadAheadIO();
+
+    /**
+     * @brief 析构函数
+     */
+    ~ReadAheadIO();
+
+    ReadAheadIO(const ReadAheadIO &) = delete;
+    ReadAheadIO &operator=(const ReadAheadIO &) = delete;
+
+    /**
+     * @brief 打开文件并启动预读线程
+     * @param filePath 本地文件路径
+     * @param bufferSize 环形缓冲区大小（字节）
+     * @param preferUring 为true时优先使用io_uring，不可用时退回预读线程
+     * @return 是否成功，失败原因可通过errorString获取
+     */
+    bool open(const QString &filePath, qint64 bufferSize, bool preferUring = false);
+
+    /**
+     * @brief 停止预读线程（或等待在途的io_uring读取结束），释放AVIOContext和缓冲区
+     */
+    void close();
+
+    /**
+     * @brief 检查当前是否通过io_uring读取
+     * @return 是否使用io_uring，为false时使用预读线程
+     */
+    bool isUsingUring() const;
+
+    /**
+     * @brief 获取供avformat_open_input使用的AVIOContext
+     * @return 上下文，未打开时为nullptr
+     */
+    AVIOContext *context() const;
+
+    /**
+     * @brief 获取统计快照
+     * @return 统计
+     */
+    Stats stats() const;
+
+    /**
+     * @brief 获取失败原因
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+    /**
+     * @brief 检查路径是否为可由本类读取的本地文件（URL和设备输入仍交给FFmpeg）
+     * @param url 文件路径或URL
+     * @return 是否为本地文件
+     */
+    static bool isLocalFile(const QString &url);
+
+private:
+    /**
+     * @brief AVIO读回调
+     */
+    static int readPacket(void *opaque, uint8_t *buffer, int size);
+
+    /**
+     * @brief AVIO跳转回调
+     */
+    static int64_t seekPacket(void *opaque, int64_t offset, int whence);
+
+    /**
+     * @brief 从环形缓冲区取数据，缓冲区为空时等待预读线程或最早的在途读取
+     * @param buffer 输出缓冲区
+     * @param size 最多读取的字节数
+     * @return 读取的字节数，或AVERROR_EOF / AVERROR(EIO)
+     */
+    int read(uint8_t *buffer, int size);
+
+    /**
+     * @brief 移动读取位置，目标在缓冲范围外时通知预读线程重新定位
+     * @param offset 偏移
+     * @param whence SEEK_SET / SEEK_CUR / SEEK_END / AVSEEK_SIZE
+     * @return 新位置或文件大小，失败时为负数
+     */
+    int64_t seek(int64_t offset, int whence);
+
+    /**
+     * @brief 预读线程主函数
+     */
+    void readLoop();
+
+    /**
+     * @brief 收取已完成的io_uring读取，并在缓冲区有空间时补发新的读取（调用时持有m_mutex）
+     * @param wait 为true时在锁外等待至少一个读取完成
+     */
+    void pumpUring(bool wait);
+
+    /**
+     * @brief 取消全部在途的io_uring读取并等待其结束（调用时持有m_mutex）
+     *
+     * 已在执行的读取可能无法取消，必须等它们完成，之后才能把对应的缓冲区区域交给新的读取或释放。
+     */
+    void cancelUring();
+
+    /**
+     * @brief 提示内核预读（仅Linux有效）
+     * @param offset 起始偏移
+     * @param sequential 为true时提示从该位置起顺序读取，否则提示即将读取一个缓冲区大小的数据
+     */
+    void advise(qint64 offset, bool sequential);
+
+    QFile m_file;
+    qint64 m_fileSize;
+    AVIOContext *m_context;
+
+    // Ring buffer; offsets are absolute file positions, ring index is offset % m_capacity
+    uchar *m_ring;
+    qint64 m_capacity;
+    qint64 m_readOffset;
+    qint64 m_writeOffset;
+    qint64 m_validStart;
+    quint64 m_generation;
+    bool m_endOfFile;
+    bool m_readError;
+
+    // Thread management
+    QThread *m_thread;
+    bool m_running;
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataAvailable;
+    QWaitCondition m_spaceAvailable;
+
+    /**
+     * @brief 一个在途的io_uring读取（按文件偏移排列，完成后按顺序并入缓冲数据）
+     */
+    struct UringRead {
+        qint64 offset;
+        qint64 length;
+        int result;
+        bool pending;
+    };
+
+    // io_uring backend; reads are issued from the demuxer thread
+    IoUring m_uring;
+    bool m_usingUring;
+    std::deque<UringRead> m_uringReads;
+    qint64 m_submitOffset;
+    QElapsedTimer m_uringClock;
+    qint64 m_uringBusySince;
+
+    // Counters
+    Stats m_stats;
+    qint64 m_readNs;
+
+    QString m_errorString;
+};
+
+#endif // READAHEADIO_H
@@ -0,0 +1,246 @@
+#include "slicescaler.h"
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+// 单个条带的最小行数，过小的条带线程调度开销会超过转换本身
+const int kMinSliceHeight = 64;
+
+/**
+ * @brief 计算条带起始行对应的各平面指针
+ * @param desc 像素格式描述
+ * @param data 原始平面指针
+ * @param stride 平面行跨度
+ * @param y 条带起始行（已按色度垂直采样对齐）
+ * @param out 输出平面指针
+ */
+template <typename T>
+void offsetPlanes(const AVPixFmtDescriptor *desc, T *const data[], const int stride[], int y, T *out[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i] = data[i];
+        if (!data[i]) {
+            continue;
+        }
+
+        // 调色板格式的第二个平面是调色板，不能偏移
+        int paletteFlags = AV_PIX_FMT_FLAG_PAL;
+#ifdef AV_PIX_FMT_FLAG_PSEUDOPAL
+        paletteFlags |= AV_PIX_FMT_FLAG_PSEUDOPAL;
+#endif
+        if (i == 1 && (desc->flags & paletteFlags)) {
+            continue;
+        }
+
+        // 第1、2平面是色度平面，按垂直采样比例偏移
+        const bool chroma = (i == 1 || i == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        const int rows = chroma ? (y >> desc->log2_chroma_h) : y;
+        out[i] = data[i] + static_cast<ptrdiff_t>(rows) * stride[i];
+    }
+}
+
+} // namespace
+
+SliceScaler::SliceScaler(int maxSlices)
+    : m_maxSlices(maxSlices)
+    , m_width(0)
+    , m_height(0)
+    , m_srcFormat(AV_PIX_FMT_NONE)
+    , m_dstFormat(AV_PIX_FMT_NONE)
+    , m_flags(0)
+    , m_hasContexts(false)
+{
+    // 工作线程常驻，避免每帧重新创建线程
+    m_pool.setExpiryTimeout(-1);
+}
+
+SliceScaler::~SliceScaler()
+{
+    m_pool.waitForDone();
+    release();
+}
+
+bool SliceScaler::init(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat, int flags)
+{
+    const AVPixFmtDescriptor *srcDesc = av_pix_fmt_desc_get(srcFormat);
+    const AVPixFmtDescriptor *dstDesc = av_pix_fmt_desc_get(dstFormat);
+    if (width <= 0 || height <= 0 || !srcDesc || !dstDesc) {
+        release();
+        return false;
+    }
+
+    // 参数未变化时直接复用现有条带
+    if (isValid() && m_hasContexts && width == m_width && height == m_height
+            && srcFormat == m_srcFormat && dstFormat == m_dstFormat && flags == m_flags) {
+        return true;
+    }
+
+    std::vector<Slice> slices = planSlices(height, srcDesc, dstDesc);
+
+    // 多余的旧条带直接释放，其余交给sws_getCachedContext：参数相同的上下文原样复用，
+    // 不同的才重新创建（例如分辨率切换后条带高度相同的中间条带）
+    for (size_t i = slices.size(); i < m_slices.size(); ++i) {
+        sws_freeContext(m_slices[i].ctx);
+    }
+    m_slices.resize(std::min(m_slices.size(), slices.size()));
+
+    bool ok = true;
+    for (size_t i = 0; i < slices.size(); ++i) {
+        SwsContext *previous = i < m_slices.size() ? m_slices[i].ctx : nullptr;
+        // 失败时sws_getCachedContext已释放传入的上下文
+        slices[i].ctx = sws_getCachedContext(previous,
+                                             width, slices[i].height, srcFormat,
+                                             width, slices[i].height, dstFormat,
+                                             flags, nullptr, nullptr, nullptr);
+        if (!slices[i].ctx) {
+            ok = false;
+        }
+    }
+    m_slices.swap(slices);
+
+    if (!ok) {
+        release();
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_srcFormat = srcFormat;
+    m_dstFormat = dstFormat;
+    m_flags = flags;
+    m_hasContexts = true;
+
+    // 调用线程自己处理第一个条带，线程池只需承担其余条带
+    m_pool.setMaxThreadCount(std::max(1, sliceCount() - 1));
+
+    return true;
+}
+
+bool SliceScaler::initSlices(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat)
+{
+    const AVPixFmtDescriptor *srcDesc = av_pix_fmt_desc_get(srcFormat);
+    const AVPixFmtDescriptor *dstDesc = av_pix_fmt_desc_get(dstFormat);
+    if (width <= 0 || height <= 0 || !srcDesc || !dstDesc) {
+        release();
+        return false;
+    }
+
+    // 尺寸和格式未变时沿用现有条带（已有上下文也无妨，forEachSlice不使用它们）
+    if (isValid() && width == m_width && height == m_height
+            && srcFormat == m_srcFormat && dstFormat == m_dstFormat) {
+        return true;
+    }
+
+    std::vector<Slice> slices = planSlices(height, srcDesc, dstDesc);
+    release();
+    m_slices.swap(slices);
+
+    m_width = width;
+    m_height = height;
+    m_srcFormat = srcFormat;
+    m_dstFormat = dstFormat;
+    m_pool.setMaxThreadCount(std::max(1, sliceCount() - 1));
+    return true;
+}
+
+void SliceScaler::release()
+{
+    for (Slice &slice : m_slices) {
+        sws_freeContext(slice.ctx);
+    }
+    m_slices.clear();
+    m_width = 0;
+    m_height = 0;
+    m_srcFormat = AV_PIX_FMT_NONE;
+    m_dstFormat = AV_PIX_FMT_NONE;
+    m_flags = 0;
+    m_hasContexts = false;
+}
+
+bool SliceScaler::isValid() const
+{
+    return !m_slices.empty();
+}
+
+int SliceScaler::sliceCount() const
+{
+    return static_cast<int>(m_slices.size());
+}
+
+void SliceScaler::scale(const AVFrame *src, uint8_t *const dst[], const int dstStride[])
+{
+    runSlices([this, src, dst, dstStride](const Slice &slice) {
+        scaleSlice(slice, src, dst, dstStride);
+    });
+}
+
+void SliceScaler::forEachSlice(const std::function<void(int y, int height)> &job)
+{
+    runSlices([&job](const Slice &slice) {
+        job(slice.y, slice.height);
+    });
+}
+
+void SliceScaler::runSlices(const std::function<void(const Slice &slice)> &job)
+{
+    const int count = sliceCount();
+    if (count == 0) {
+        return;
+    }
+
+    // 其余条带交给线程池，当前线程处理第一个条带后等待全部完成
+    QSemaphore done;
+    for (int i = 1; i < count; ++i) {
+        const Slice &slice = m_slices[i];
+        m_pool.start([&job, &slice, &done]() {
+            job(slice);
+            done.release();
+        });
+    }
+
+    job(m_slices[0]);
+    done.acquire(count - 1);
+}
+
+std::vector<SliceScaler::Slice> SliceScaler::planSlices(int height, const AVPixFmtDescriptor *srcDesc,
+                                                       const AVPixFmtDescriptor *dstDesc) const
+{
+    // 计算条带数：不超过核心数，且每个条带不少于最小行数
+    int count = m_maxSlices > 0 ? m_maxSlices : QThread::idealThreadCount();
+    count = std::max(1, std::min(count, height / kMinSliceHeight));
+
+    // 条带边界必须与色度垂直采样对齐，否则色度行会错位
+    const int align = 1 << std::max(srcDesc->log2_chroma_h, dstDesc->log2_chroma_h);
+    int sliceHeight = (height + count - 1) / count;
+    sliceHeight = (sliceHeight + align - 1) / align * align;
+
+    std::vector<Slice> slices;
+    for (int y = 0; y < height; y += sliceHeight) {
+        Slice slice;
+        slice.y = y;
+        slice.height = std::min(sliceHeight, height - y);
+        slice.ctx = nullptr;
+        slices.push_back(slice);
+    }
+    return slices;
+}
+
+void SliceScaler::scaleSlice(const Slice &slice, const AVFrame *src,
+                             uint8_t *const dst[], const int dstStride[]) const
+{
+    const uint8_t *srcPlanes[4];
+    uint8_t *dstPlanes[4];
+    offsetPlanes<const uint8_t>(av_pix_fmt_desc_get(m_srcFormat), src->data, src->linesize, slice.y, srcPlanes);
+    offsetPlanes<uint8_t>(av_pix_fmt_desc_get(m_dstFormat), dst, dstStride, slice.y, dstPlanes);
+
+    // 每个条带作为独立的小图像交给自己的SwsContext
+    sws_scale(slice.ctx, srcPlanes, src->linesize, 0, slice.height, dstPlanes, dstStride);
+}
@@ -0,0 +1,142 @@
+#ifndef SLICESCALER_H
+#define SLICESCALER_H
+
+#include <QThreadPool>
+#include <functional>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+    struct SwsContext;
+    struct AVFrame;
+    struct AVPixFmtDescriptor;
+}
+
+/**
+ * @brief 分片并行像素格式转换器
+ *
+ * 将一帧图像按水平条带切分，每个条带持有独立的SwsContext，
+ * 条带在工作线程池中并行转换，结果直接写入调用者提供的目标缓冲区。
+ * 仅做格式转换，不做缩放（源与目标尺寸相同）。
+ * 只使用条带划分和线程池时可以用initSlices，不创建任何SwsContext。
+ * 重复init时通过sws_getCachedContext复用参数未变的上下文，可在每帧调用以跟随分辨率变化。
+ */
+class SliceScaler
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param maxSlices 最大条带数，0表示使用CPU核心数
+     */
+    explicit SliceScaler(int maxSlices = 0);
+
+    /**
+     * @brief 析构函数
+     */
+    ~SliceScaler();
+
+    /**
+     * @brief 按图像尺寸和格式初始化各条带的SwsContext（参数未变时不做任何操作）
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param srcFormat 源像素格式
+     * @param dstFormat 目标像素格式
+     * @param flags SWS算法标志
+     * @return 是否初始化成功
+     */
+    bool init(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat, int flags);
+
+    /**
+     * @brief 只划分条带，不创建SwsContext（参数未变时不做任何操作）
+     *
+     * 供只用forEachSlice的转换实现使用，此后不能调用scale，需要时再调用init补建上下文。
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param srcFormat 源像素格式（决定条带对齐）
+     * @param dstFormat 目标像素格式（决定条带对齐）
+     * @return 格式无效或尺寸为0时返回false
+     */
+    bool initSlices(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat);
+
+    /**
+     * @brief 释放所有条带的SwsContext
+     */
+    void release();
+
+    /**
+     * @brief 检查是否已初始化
+     * @return 是否可用
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 获取当前条带数
+     * @return 条带数
+     */
+    int sliceCount() const;
+
+    /**
+     * @brief 并行转换一帧图像
+     * @param src 源帧
+     * @param dst 目标平面指针
+     * @param dstStride 目标平面行跨度
+     */
+    void scale(const AVFrame *src, uint8_t *const dst[], const int dstStride[]);
+
+    /**
+     * @brief 按init时的条带划分并行执行任务（供其他转换实现复用条带和线程池）
+     * @param job 条带任务，参数为起始行和行数
+     */
+    void forEachSlice(const std::function<void(int y, int height)> &job);
+
+private:
+    /**
+     * @brief 单个条带
+     */
+    struct Slice {
+        SwsContext *ctx;
+        int y;
+        int height;
+    };
+
+    /**
+     * @brief 在线程池上并行执行各条带任务，当前线程处理第一个条带
+     * @param job 条带任务
+     */
+    void runSlices(const std::function<void(const Slice &slice)> &job);
+
+    /**
+     * @brief 按尺寸和格式划分条带（不创建上下文）
+     * @param height 图像高度
+     * @param srcDesc 源像素格式描述
+     * @param dstDesc 目标像素格式描述
+     * @return 条带，ctx均为空
+     */
+    std::vector<Slice> planSlices(int height, const AVPixFmtDescriptor *srcDesc,
+                                  const AVPixFmtDescriptor *dstDesc) const;
+
+    /**
+     * @brief 转换单个条带
+     * @param slice 条带
+     * @param src 源帧
+     * @param dst 目标平面指针
+     * @param dstStride 目标平面行跨度
+     */
+    void scaleSlice(const Slice &slice, const AVFrame *src,
+                    uint8_t *const dst[], const int dstStride[]) const;
+
+    // Worker threads
+    QThreadPool m_pool;
+    int m_maxSlices;
+
+    // Per-band conversion contexts
+    std::vector<Slice> m_slices;
+    int m_width;
+    int m_height;
+    AVPixelFormat m_srcFormat;
+    AVPixelFormat m_dstFormat;
+    int m_flags;
+    bool m_hasContexts;
+};
+
+#endif // SLICESCALER_H
@@ -0,0 +1,120 @@
+#include "statsoverlay.h"
+#include <QFontDatabase>
+
+StatsOverlay::StatsOverlay(QWidget *parent) : QLabel(parent)
+    , m_stats(nullptr)
+    , m_readAhead(nullptr)
+    , m_refreshTimer(new QTimer(this))
+    , m_lastPresented(0)
+    , m_lastRefresh(PipelineStats::Clock::now())
+{
+    // 半透明背景、等宽字体，不遮挡下层控件的鼠标操作
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: #e0e0e0; padding: 6px; }");
+    setTextFormat(Qt::PlainText);
+    setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    move(8, 8);
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &StatsOverlay::refresh);
+    m_refreshTimer->setInterval(500);
+}
+
+void StatsOverlay::setStats(const PipelineStats *stats)
+{
+    m_stats = stats;
+    m_lastPresented = 0;
+    m_lastRefresh = PipelineStats::Clock::now();
+    refresh();
+}
+
+void StatsOverlay::setReadAhead(const ReadAheadIO *readAhead)
+{
+    m_readAhead = readAhead;
+    refresh();
+}
+
+void StatsOverlay::showEvent(QShowEvent *event)
+{
+    QLabel::showEvent(event);
+    m_lastRefresh = PipelineStats::Clock::now();
+    if (m_stats) {
+        m_lastPresented = m_stats->snapshot().framesPresented;
+    }
+    refresh();
+    m_refreshTimer->start();
+}
+
+void StatsOverlay::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer->stop();
+    QLabel::hideEvent(event);
+}
+
+void StatsOverlay::refresh()
+{
+    if (!m_stats) {
+        setText(tr("无统计数据"));
+        adjustSize();
+        return;
+    }
+
+    const PipelineStats::Snapshot snapshot = m_stats->snapshot();
+
+    // 按两次刷新之间显示的帧数估算实际帧率；打开新文件后计数清零，需重新起算
+    const PipelineStats::Clock::time_point now = PipelineStats::Clock::now();
+    const double elapsed = std::chrono::duration<double>(now - m_lastRefresh).count();
+    if (snapshot.framesPresented < m_lastPresented) {
+        m_lastPresented = 0;
+    }
+    const double fps = elapsed > 0.0 ? (snapshot.framesPresented - m_lastPresented) / elapsed : 0.0;
+    m_lastPresented = snapshot.framesPresented;
+    m_lastRefresh = now;
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg("stage", -8)
+            .arg("count", 8)
+            .arg("mean", 8)
+            .arg("p50", 8)
+            .arg("p95", 8)
+            .arg("p99", 8)
+            .arg("max", 8);
+    for (int i = 0; i < PipelineStats::kStageCount; ++i) {
+        const PipelineStats::StageSummary &stage = snapshot.stages[i];
+        text += QString("%1 %2 %3 %4 %5 %6 %7\n")
+                .arg(QLatin1String(PipelineStats::stageName(static_cast<PipelineStats::Stage>(i))), -8)
+                .arg(stage.count, 8)
+                .arg(stage.mean, 8, 'f', 0)
+                .arg(stage.p50, 8, 'f', 0)
+                .arg(stage.p95, 8, 'f', 0)
+                .arg(stage.p99, 8, 'f', 0)
+                .arg(stage.max, 8, 'f', 0);
+    }
+    text += tr("（耗时单位：微秒）\n");
+    text += tr("解码 %1  显示 %2  丢弃 %3  迟到 %4  解码错误 %5\n")
+            .arg(snapshot.framesDecoded)
+            .arg(snapshot.framesPresented)
+            .arg(snapshot.framesDropped)
+            .arg(snapshot.framesLate)
+            .arg(snapshot.decodeErrors);
+    text += tr("队列 %1（峰值 %2）  显示帧率 %3 fps\n")
+            .arg(snapshot.queueDepth)
+            .arg(snapshot.maxQueueDepth)
+            .arg(fps, 0, 'f', 1);
+    text += snapshot.timeToFirstFrame < 0.0
+            ? tr("首帧耗时 --")
+            : tr("首帧耗时 %1 ms").arg(snapshot.timeToFirstFrame, 0, 'f', 1);
+    if (m_readAhead) {
+        const ReadAheadIO::Stats io = m_readAhead->stats();
+        text += tr("\n读取 %1 MB/s（%2）  预读 %3 KB  停顿 %4 次（%5 ms）  重新定位 %6")
+                .arg(io.readMBps, 0, 'f', 1)
+                .arg(m_readAhead->isUsingUring() ? QString("io_uring") : tr("预读线程"))
+                .arg(io.buffered / 1024)
+                .arg(io.stalls)
+                .arg(io.stallMs, 0, 'f', 1)
+                .arg(io.seeks);
+    }
+
+    setText(text);
+    adjustSize();
+}
@@ -0,0 +1,70 @@
+#ifndef STATSOVERLAY_H
+#define STATSOVERLAY_H
+
+#include <QLabel>
+#include <QTimer>
+#include "pipelinestats.h"
+#include "readaheadio.h"
+
+/**
+ * @brief 叠加在视频画面上的流水线统计面板
+ *
+ * 定时读取PipelineStats快照，显示各阶段耗时分位数、帧计数和队列深度。
+ * 面板不接收鼠标事件，隐藏时停止刷新。
+ */
+class StatsOverlay : public QLabel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父窗口（通常是视频显示区域）
+     */
+    explicit StatsOverlay(QWidget *parent = nullptr);
+
+    /**
+     * @brief 设置要显示的统计对象
+     * @param stats 统计对象，生命周期需长于本面板
+     */
+    void setStats(const PipelineStats *stats);
+
+    /**
+     * @brief 设置要显示的输入层统计
+     * @param readAhead 预读层，生命周期需长于本面板
+     */
+    void setReadAhead(const ReadAheadIO *readAhead);
+
+protected:
+    /**
+     * @brief 显示时开始刷新
+     * @param event 事件
+     */
+    void showEvent(QShowEvent *event) override;
+
+    /**
+     * @brief 隐藏时停止刷新
+     * @param event 事件
+     */
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    /**
+     * @brief 读取快照并更新显示内容
+     */
+    void refresh();
+
+private:
+    // Data source
+    const PipelineStats *m_stats;
+    const ReadAheadIO *m_readAhead;
+
+    // Refresh timer
+    QTimer *m_refreshTimer;
+
+    // Frame rate estimation
+    qint64 m_lastPresented;
+    PipelineStats::Clock::time_point m_lastRefresh;
+};
+
+#endif // STATSOVERLAY_H
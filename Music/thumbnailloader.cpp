@@ -0,0 +1,190 @@
+#include "thumbnailloader.h"
+#include "mediaprober.h"
+#include <QBuffer>
+#include <QImageReader>
+
+namespace {
+
+// 默认缩略图尺寸，与列表视图的图标尺寸一致
+const int kDefaultSize = 48;
+
+// 内存缓存上限（KB）；48x48的缩略图约9KB，可缓存三千余个
+const int kCacheKilobytes = 32 * 1024;
+
+// 排队请求的上限，超过时丢弃最早的（多半已滚出屏幕）
+const size_t kMaxQueued = 64;
+
+// 解码封面主要受磁盘和JPEG解码限制，两个线程即可，不与播放争抢CPU
+const int kPoolThreads = 2;
+
+} // namespace
+
+ThumbnailLoader::ThumbnailLoader(QObject *parent)
+    : QObject(parent)
+    , m_size(kDefaultSize, kDefaultSize)
+    , m_cache(kCacheKilobytes)
+    , m_generation(0)
+{
+    m_pool.setMaxThreadCount(kPoolThreads);
+    m_pool.setObjectName("qvp-thumbnail");
+
+    m_placeholder = QImage(m_size, QImage::Format_ARGB32_Premultiplied);
+    m_placeholder.fill(Qt::transparent);
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    clearQueue();
+    m_pool.waitForDone();
+}
+
+void ThumbnailLoader::setThumbnailSize(const QSize &size)
+{
+    if (size == m_size || size.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_size = size;
+        ++m_generation;
+        m_queue.clear();
+        m_requested.clear();
+    }
+    m_cache.clear();
+    m_missing.clear();
+
+    m_placeholder = QImage(m_size, QImage::Format_ARGB32_Premultiplied);
+    m_placeholder.fill(Qt::transparent);
+}
+
+QSize ThumbnailLoader::thumbnailSize() const
+{
+    return m_size;
+}
+
+void ThumbnailLoader::setCacheDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_diskCache = CoverArtCache(directory);
+}
+
+QImage ThumbnailLoader::thumbnail(const QString &filePath)
+{
+    if (const QImage *image = m_cache.object(filePath)) {
+        return *image;
+    }
+    if (m_missing.contains(filePath)) {
+        return QImage();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_requested.contains(filePath)) {
+            return QImage();
+        }
+        m_requested.insert(filePath);
+        m_queue.push_back(filePath);
+        if (m_queue.size() > kMaxQueued) {
+            m_requested.remove(m_queue.front());
+            m_queue.erase(m_queue.begin());
+        }
+    }
+
+    // 每个请求对应一个任务，任务执行时取的是当时最新的请求
+    m_pool.start([this]() {
+        loadNext();
+    });
+    return QImage();
+}
+
+QImage ThumbnailLoader::placeholder() const
+{
+    return m_placeholder;
+}
+
+void ThumbnailLoader::clearQueue()
+{
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_requested.clear();
+}
+
+void ThumbnailLoader::loadNext()
+{
+    QString filePath;
+    QSize size;
+    quint64 generation;
+    CoverArtCache diskCache;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_queue.empty()) {
+            return;
+        }
+        filePath = m_queue.back();
+        m_queue.pop_back();
+        size = m_size;
+        generation = m_generation;
+        diskCache = m_diskCache;
+    }
+
+    const QImage image = loadThumbnail(filePath, size, diskCache);
+
+    QMetaObject::invokeMethod(this, [this, filePath, image, generation]() {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_requested.remove(filePath);
+        }
+        // 期间尺寸变了，这张作废
+        if (generation != m_generation) {
+            return;
+        }
+        if (image.isNull()) {
+            m_missing.insert(filePath);
+            return;
+        }
+        m_cache.insert(filePath, new QImage(image), qMax<int>(1, static_cast<int>(image.sizeInBytes() / 1024)));
+        emit thumbnailReady(filePath);
+    }, Qt::QueuedConnection);
+}
+
+QImage ThumbnailLoader::loadThumbnail(const QString &filePath, const QSize &size, const CoverArtCache &diskCache)
+{
+    MediaProber prober;
+    MediaInfo info;
+    if (!prober.probe(filePath, &info) || info.coverArt.isEmpty()) {
+        return QImage();
+    }
+
+    // 先查磁盘缓存：键只取决于封面数据，同一专辑的曲目第一次出现时也能命中
+    const QByteArray key = CoverArtCache::keyFor(info.coverArt);
+    const int bucket = CoverArtCache::bucketFor(size);
+    QImage image = diskCache.load(key, bucket);
+
+    if (image.isNull()) {
+        QBuffer buffer(&info.coverArt);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer);
+
+        // 让解码器直接输出档位尺寸的图像，JPEG可在解码时按1/2、1/4、1/8缩小，不必先解出整幅大图
+        const QSize bucketSize(bucket, bucket);
+        const QSize original = reader.size();
+        if (original.width() > bucket || original.height() > bucket) {
+            reader.setScaledSize(original.scaled(bucketSize, Qt::KeepAspectRatio));
+        }
+        image = reader.read();
+        if (image.isNull()) {
+            return QImage();
+        }
+        if (image.width() > bucket || image.height() > bucket) {
+            image = image.scaled(bucketSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        diskCache.store(key, bucket, image);
+    }
+
+    // 档位尺寸只比需要的略大，再缩一次的开销很小
+    if (image.width() > size.width() || image.height() > size.height()) {
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
@@ -0,0 +1,116 @@
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <vector>
+#include "coverartcache.h"
+
+/**
+ * @brief 封面缩略图的异步加载器
+ *
+ * 列表视图绘制某行时调用thumbnail：已在内存缓存中则直接返回，否则排队后返回空图，
+ * 后台线程读出内嵌封面、按缩略图尺寸解码后发出thumbnailReady，视图再重绘该行。
+ * 设置了磁盘缓存目录时，解码结果按封面内容存入CoverArtCache，之后（包括下次启动和同一专辑的其他曲目）
+ * 只读取缓存的小图，不再解码原始封面。
+ * 请求按后进先出处理且队列有上限：快速滚动时已滚出屏幕的行让位于当前可见的行，
+ * 被挤出队列的请求在该行再次绘制时重新排队。
+ * 没有封面或解码失败的文件会被记住，不再重复尝试。
+ * 只能在创建它的线程（界面线程）中调用。
+ */
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param parent 父对象
+     */
+    explicit ThumbnailLoader(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（丢弃排队的请求，等待进行中的解码结束）
+     */
+    ~ThumbnailLoader() override;
+
+    /**
+     * @brief 设置缩略图尺寸（保持宽高比缩放到不超过该尺寸），会清空内存缓存
+     * @param size 尺寸
+     */
+    void setThumbnailSize(const QSize &size);
+
+    /**
+     * @brief 获取缩略图尺寸
+     * @return 尺寸
+     */
+    QSize thumbnailSize() const;
+
+    /**
+     * @brief 设置磁盘缓存目录（可与其他加载器共用，按尺寸分档互不影响）
+     * @param directory 目录路径，为空时不使用磁盘缓存
+     */
+    void setCacheDirectory(const QString &directory);
+
+    /**
+     * @brief 获取缩略图，没有时排队加载
+     * @param filePath 媒体文件路径
+     * @return 缩略图，尚未加载或没有封面时为空图
+     */
+    QImage thumbnail(const QString &filePath);
+
+    /**
+     * @brief 获取与缩略图同尺寸的透明占位图（没有封面的行也占同样的位置，列表行高一致）
+     * @return 占位图
+     */
+    QImage placeholder() const;
+
+    /**
+     * @brief 丢弃所有排队的请求（列表内容整体更换时）
+     */
+    void clearQueue();
+
+signals:
+    /**
+     * @brief 缩略图已加载，可再次调用thumbnail取得
+     * @param filePath 媒体文件路径
+     */
+    void thumbnailReady(const QString &filePath);
+
+private:
+    /**
+     * @brief 取出最新的一个请求并加载（在线程池中运行）
+     */
+    void loadNext();
+
+    /**
+     * @brief 读取内嵌封面并解码为缩略图，磁盘缓存中已有同一封面时直接读取缓存
+     * @param filePath 媒体文件路径
+     * @param size 缩略图尺寸
+     * @param diskCache 磁盘缓存
+     * @return 缩略图，没有封面或解码失败时为空图
+     */
+    static QImage loadThumbnail(const QString &filePath, const QSize &size, const CoverArtCache &diskCache);
+
+    QSize m_size;
+    QImage m_placeholder;
+    QCache<QString, QImage> m_cache;
+    QSet<QString> m_missing;
+
+    // Pending requests, newest last; shared with the pool threads
+    QMutex m_mutex;
+    std::vector<QString> m_queue;
+    QSet<QString> m_requested;
+    quint64 m_generation;
+    CoverArtCache m_diskCache;
+
+    QThreadPool m_pool;
+};
+
+#endif // THUMBNAILLOADER_H
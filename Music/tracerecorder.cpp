@@ -0,0 +1,351 @@
+#include "tracerecorder.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <chrono>
+#include <vector>
+
+namespace {
+
+// 所有事件使用同一分类，便于在Perfetto中按分类过滤
+const char *const kCategory = "qvp";
+
+/**
+ * @brief 获取单调时钟的当前时间
+ * @return 时间（纳秒）
+ */
+qint64 monotonicNanoseconds()
+{
+    const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count();
+}
+
+// 用于区分TraceRecorder实例，避免不同实例复用同一地址时误用旧的线程缓存
+std::atomic<quint64> s_nextInstanceId(1);
+
+} // namespace
+
+/**
+ * @brief 单条事件，name指向静态字符串
+ */
+struct TraceRecorder::Event {
+    char phase;
+    const char *name;
+    qint64 timestamp;
+    qint64 duration;
+    qint64 pts;
+    qint64 id;
+};
+
+/**
+ * @brief 单个线程的环形缓冲区，只有所属线程写入
+ */
+struct TraceRecorder::ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    std::atomic<quint64> written;
+    int threadId;
+    QString threadName;
+    bool inUse;
+
+    explicit ThreadBuffer(int id)
+        : events(new Event[kEventsPerThread])
+        , written(0)
+        , threadId(id)
+        , inUse(true)
+    {
+    }
+};
+
+/**
+ * @brief 已登记的线程缓冲区，线程退出后其缓冲区留给后来的线程复用
+ */
+struct TraceRecorder::Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    quint64 instanceId;
+};
+
+namespace {
+
+/**
+ * @brief 线程本地缓存：当前线程最近使用的记录器及其缓冲区
+ *
+ * 持有Registry的共享引用，线程退出时即使记录器已销毁也能安全归还缓冲区。
+ */
+struct TraceSlot {
+    std::shared_ptr<void> registry;
+    quint64 instanceId = 0;
+    void *buffer = nullptr;
+    void (*release)(void *registry, void *buffer) = nullptr;
+
+    ~TraceSlot()
+    {
+        if (release) {
+            release(registry.get(), buffer);
+        }
+    }
+};
+
+thread_local TraceSlot t_traceSlot;
+
+} // namespace
+
+TraceRecorder::ScopedEvent::ScopedEvent(TraceRecorder &recorder, const char *name, qint64 pts)
+    : m_recorder(recorder)
+    , m_name(name)
+    , m_pts(pts)
+    , m_start(0)
+    , m_generation(0)
+    , m_active(recorder.isEnabled())
+{
+    if (m_active) {
+        m_generation = m_recorder.m_generation.load(std::memory_order_acquire);
+        m_start = m_recorder.now();
+    }
+}
+
+TraceRecorder::ScopedEvent::~ScopedEvent()
+{
+    // 事件进行中停止（或重新开始）记录的，丢弃该事件
+    if (m_active && m_recorder.isEnabled()) {
+        m_recorder.append('X', m_name, m_start, m_recorder.now() - m_start, m_pts, 0, m_generation);
+    }
+}
+
+void TraceRecorder::ScopedEvent::setPts(qint64 pts)
+{
+    m_pts = pts;
+}
+
+TraceRecorder::TraceRecorder()
+    : m_registry(std::make_shared<Registry>())
+    , m_enabled(false)
+    , m_epoch(0)
+    , m_generation(0)
+    , m_queuedFrames(0)
+    , m_dequeuedFrames(0)
+{
+    m_registry->instanceId = s_nextInstanceId.fetch_add(1);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+}
+
+void TraceRecorder::start()
+{
+    m_enabled.store(false);
+
+    // 先换起点再换代：读到新代数的写者一定也读到新起点。
+    // 换代之后才清零计数，与此同时仍在写上一代事件的线程发布后会看到新代数并撤销发布
+    m_epoch.store(monotonicNanoseconds());
+    m_generation.fetch_add(1);
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadBuffer> &buffer : m_registry->buffers) {
+            buffer->written.store(0);
+        }
+    }
+
+    // 新的一轮记录中，已在队列中的帧不再配对
+    m_dequeuedFrames.store(m_queuedFrames.load());
+    m_enabled.store(true);
+}
+
+void TraceRecorder::stop()
+{
+    // 换代使停止前已开始、停止后才写入的事件被丢弃，导出时缓冲区不再变化
+    m_enabled.store(false);
+    m_generation.fetch_add(1);
+}
+
+void TraceRecorder::instant(const char *name, qint64 pts)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    const quint64 generation = m_generation.load(std::memory_order_acquire);
+    append('i', name, now(), 0, pts, 0, generation);
+}
+
+void TraceRecorder::frameQueued(qint64 pts)
+{
+    // 未启用时也要计数，保证与消费端的配对不错位
+    const qint64 id = m_queuedFrames.fetch_add(1, std::memory_order_relaxed);
+    if (isEnabled()) {
+        const quint64 generation = m_generation.load(std::memory_order_acquire);
+        append('b', "queue", now(), 0, pts, id, generation);
+    }
+}
+
+void TraceRecorder::frameDequeued()
+{
+    const qint64 id = m_dequeuedFrames.load(std::memory_order_relaxed);
+    if (id >= m_queuedFrames.load(std::memory_order_relaxed)) {
+        return;
+    }
+    m_dequeuedFrames.store(id + 1, std::memory_order_relaxed);
+    if (isEnabled()) {
+        const quint64 generation = m_generation.load(std::memory_order_acquire);
+        append('e', "queue", now(), 0, kNoPts, id, generation);
+    }
+}
+
+bool TraceRecorder::writeJson(const QString &filePath)
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadBuffer> &buffer : m_registry->buffers) {
+            // 线程名称元数据
+            QJsonObject nameArgs;
+            nameArgs["name"] = buffer->threadName;
+            QJsonObject metadata;
+            metadata["ph"] = "M";
+            metadata["name"] = "thread_name";
+            metadata["pid"] = pid;
+            metadata["tid"] = buffer->threadId;
+            metadata["args"] = nameArgs;
+            events.append(metadata);
+
+            // 环形缓冲区写满后只保留最近的kEventsPerThread条；最旧的一条与下一个写入位置是同一格，
+            // 可能正被停止前开始的写入覆盖，一并舍去
+            const quint64 written = buffer->written.load(std::memory_order_acquire);
+            const quint64 first = written >= static_cast<quint64>(kEventsPerThread)
+                    ? written - kEventsPerThread + 1 : 0;
+            for (quint64 i = first; i < written; ++i) {
+                const Event &event = buffer->events[i % kEventsPerThread];
+                QJsonObject object;
+                object["ph"] = QString::fromLatin1(&event.phase, 1);
+                object["name"] = event.name;
+                object["cat"] = kCategory;
+                object["pid"] = pid;
+                object["tid"] = buffer->threadId;
+                object["ts"] = event.timestamp / 1000.0;
+                if (event.phase == 'X') {
+                    object["dur"] = event.duration / 1000.0;
+                } else if (event.phase == 'i') {
+                    object["s"] = "t";
+                } else {
+                    object["id"] = event.id;
+                }
+                if (event.pts != kNoPts) {
+                    QJsonObject args;
+                    args["pts"] = event.pts;
+                    object["args"] = args;
+                }
+                events.append(object);
+            }
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QString("无法写入跟踪文件：%1").arg(filePath);
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    m_errorString.clear();
+    return true;
+}
+
+QString TraceRecorder::errorString() const
+{
+    return m_errorString;
+}
+
+qint64 TraceRecorder::now() const
+{
+    return monotonicNanoseconds() - m_epoch.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::append(char phase, const char *name, qint64 timestamp, qint64 duration, qint64 pts, qint64 id,
+                           quint64 generation)
+{
+    // 事件开始于上一代（之后start或stop过），时间起点或所属的一轮记录已经不对
+    if (m_generation.load() != generation) {
+        return;
+    }
+
+    ThreadBuffer *buffer = localBuffer();
+    const quint64 index = buffer->written.load(std::memory_order_relaxed);
+
+    Event &event = buffer->events[index % kEventsPerThread];
+    event.phase = phase;
+    event.name = name;
+    event.timestamp = timestamp;
+    event.duration = duration;
+    event.pts = pts;
+    event.id = id;
+
+    // 先写事件再发布计数，导出时只读取已发布的事件
+    buffer->written.store(index + 1);
+
+    // 写入期间start或stop换了代：撤销发布。start换代后才清零，
+    // 这里看不到新代数时清零一定排在发布之后；计数已被清零时比较失败，保持为0
+    if (m_generation.load() != generation) {
+        quint64 published = index + 1;
+        buffer->written.compare_exchange_strong(published, index);
+    }
+}
+
+TraceRecorder::ThreadBuffer *TraceRecorder::localBuffer()
+{
+    // 快速路径：当前线程最近一次使用的就是本对象
+    if (t_traceSlot.instanceId == m_registry->instanceId) {
+        return static_cast<ThreadBuffer *>(t_traceSlot.buffer);
+    }
+
+    // 归还之前缓存的缓冲区
+    if (t_traceSlot.release) {
+        t_traceSlot.release(t_traceSlot.registry.get(), t_traceSlot.buffer);
+    }
+
+    // 线程名称优先使用QThread的objectName（如解码线程的qvp-decode）
+    QThread *thread = QThread::currentThread();
+    QString threadName = thread ? thread->objectName() : QString();
+    if (threadName.isEmpty() && QCoreApplication::instance()
+            && thread == QCoreApplication::instance()->thread()) {
+        threadName = "main";
+    }
+
+    ThreadBuffer *local = nullptr;
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        for (const std::unique_ptr<ThreadBuffer> &candidate : m_registry->buffers) {
+            if (!candidate->inUse) {
+                candidate->inUse = true;
+                local = candidate.get();
+                break;
+            }
+        }
+        if (!local) {
+            const int threadId = static_cast<int>(m_registry->buffers.size()) + 1;
+            m_registry->buffers.push_back(std::make_unique<ThreadBuffer>(threadId));
+            local = m_registry->buffers.back().get();
+        }
+        local->threadName = threadName.isEmpty()
+                ? QString("thread-%1").arg(local->threadId) : threadName;
+    }
+
+    t_traceSlot.registry = m_registry;
+    t_traceSlot.instanceId = m_registry->instanceId;
+    t_traceSlot.buffer = local;
+    t_traceSlot.release = [](void *registry, void *buffer) {
+        Registry *owner = static_cast<Registry *>(registry);
+        QMutexLocker locker(&owner->mutex);
+        static_cast<ThreadBuffer *>(buffer)->inUse = false;
+    };
+    return local;
+}
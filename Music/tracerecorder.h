@@ -0,0 +1,175 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 播放流水线的事件跟踪记录器
+ *
+ * 记录读包、解码、转换、排队、显示等事件的起止时间、所在线程和帧PTS，
+ * 导出为Chrome trace-event格式的JSON文件，可直接在Perfetto或chrome://tracing中查看，
+ * 用于定位跨线程的等待和锁竞争。
+ * 每个线程写入自己的定长环形缓冲区（单写者，不加锁），写满后覆盖最旧的事件。
+ * start和stop都会换代，开始于上一代的事件（包括与start、stop同时进行的写入）一律丢弃。
+ * 未启用时每个事件只有一次relaxed原子读，开销可以忽略。
+ */
+class TraceRecorder
+{
+public:
+    /**
+     * @brief 表示事件没有对应的PTS
+     */
+    static const qint64 kNoPts = INT64_MIN;
+
+    /**
+     * @brief 每个线程环形缓冲区可保存的事件数
+     */
+    static const int kEventsPerThread = 1 << 15;
+
+    /**
+     * @brief 作用域事件，构造时记录开始时间，析构时写入一条完整事件
+     */
+    class ScopedEvent
+    {
+    public:
+        /**
+         * @brief 构造函数，记录器已启用时开始计时
+         * @param recorder 记录器
+         * @param name 事件名称（必须是静态字符串）
+         * @param pts 帧PTS，没有时为kNoPts
+         */
+        ScopedEvent(TraceRecorder &recorder, const char *name, qint64 pts = kNoPts);
+
+        /**
+         * @brief 析构函数，写入事件
+         */
+        ~ScopedEvent();
+
+        /**
+         * @brief 设置事件的帧PTS（PTS在事件结束前才知道时使用）
+         * @param pts 帧PTS
+         */
+        void setPts(qint64 pts);
+
+        ScopedEvent(const ScopedEvent &) = delete;
+        ScopedEvent &operator=(const ScopedEvent &) = delete;
+
+    private:
+        TraceRecorder &m_recorder;
+        const char *m_name;
+        qint64 m_pts;
+        qint64 m_start;
+        quint64 m_generation;
+        bool m_active;
+    };
+
+    /**
+     * @brief 构造函数（默认不启用）
+     */
+    TraceRecorder();
+
+    /**
+     * @brief 析构函数
+     */
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    /**
+     * @brief 清空之前的事件并开始记录
+     */
+    void start();
+
+    /**
+     * @brief 停止记录（已记录的事件保留到下次start）
+     */
+    void stop();
+
+    /**
+     * @brief 检查是否正在记录
+     * @return 是否正在记录
+     */
+    bool isEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 记录一个瞬时事件
+     * @param name 事件名称（必须是静态字符串）
+     * @param pts 帧PTS，没有时为kNoPts
+     */
+    void instant(const char *name, qint64 pts = kNoPts);
+
+    /**
+     * @brief 记录一帧进入显示队列（由生产线程调用），与frameDequeued按顺序配对成跨线程的异步事件
+     * @param pts 帧PTS
+     */
+    void frameQueued(qint64 pts);
+
+    /**
+     * @brief 记录一帧离开显示队列（由消费线程调用）
+     */
+    void frameDequeued();
+
+    /**
+     * @brief 把已记录的事件写入trace-event JSON文件（应在stop之后调用）
+     * @param filePath 文件路径
+     * @return 是否写入成功
+     */
+    bool writeJson(const QString &filePath);
+
+    /**
+     * @brief 获取最近一次错误信息
+     * @return 错误信息
+     */
+    QString errorString() const;
+
+private:
+    struct Event;
+    struct ThreadBuffer;
+    struct Registry;
+
+    /**
+     * @brief 获取相对于开始记录时刻的时间
+     * @return 时间（纳秒）
+     */
+    qint64 now() const;
+
+    /**
+     * @brief 向当前线程的缓冲区追加事件
+     * @param phase 事件类型（trace-event格式的ph字段）
+     * @param name 事件名称
+     * @param timestamp 开始时间（纳秒）
+     * @param duration 持续时间（纳秒），只对完整事件有效
+     * @param pts 帧PTS
+     * @param id 异步事件的配对编号
+     * @param generation 事件开始时的记录代数，与当前代数不同时丢弃
+     */
+    void append(char phase, const char *name, qint64 timestamp, qint64 duration, qint64 pts, qint64 id,
+                quint64 generation);
+
+    /**
+     * @brief 获取当前线程在本对象中的缓冲区（首次调用时登记）
+     * @return 缓冲区
+     */
+    ThreadBuffer *localBuffer();
+
+    std::shared_ptr<Registry> m_registry;
+    std::atomic<bool> m_enabled;
+    std::atomic<qint64> m_epoch;
+    std::atomic<quint64> m_generation;
+
+    // Queue handoff pairing (single producer, single consumer)
+    std::atomic<qint64> m_queuedFrames;
+    std::atomic<qint64> m_dequeuedFrames;
+
+    QString m_errorString;
+};
+
+#endif // TRACERECORDER_H
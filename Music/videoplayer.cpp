@@ -1,8 +1,21 @@
 #include "videoplayer.h"
 #include "ui_videoplayer.h"
 #include "ffmpegwrapper.h"
+#include "statsoverlay.h"
+#include "playlist.h"
+#include "playlistmodel.h"
+#include "mediadecoder.h"
+#include "librarymodel.h"
+#include "libraryscanner.h"
+#include "librarywatcher.h"
+#include "thumbnailloader.h"
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QDir>
+#include <QEvent>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThread>
 #include <QDebug>
 
 VideoPlayer::VideoPlayer(QWidget *parent)
@@ -12,6 +25,14 @@ VideoPlayer::VideoPlayer(QWidget *parent)
     , m_isPlaying(false)
     , m_isDraggingSlider(false)
     , m_uiUpdateTimer(new QTimer(this))
+    , m_statsOverlay(nullptr)
+    , m_playlist(new Playlist(this))
+    , m_thumbnails(new ThumbnailLoader(this))
+    , m_playlistModel(new PlaylistModel(m_playlist, m_thumbnails, this))
+    , m_libraryModel(new LibraryModel(this))
+    , m_libraryWatcher(new LibraryWatcher(this))
+    , m_scanThread(nullptr)
+    , m_coverArt(new ThumbnailLoader(this))
     , m_currentFilePath()
     , m_duration(0.0)
     , m_currentPosition(0.0)
@@ -22,6 +43,58 @@ VideoPlayer::VideoPlayer(QWidget *parent)
     ui->positionSlider->setRange(0, 1000);
     ui->positionSlider->setValue(0);
     
+    // 解码输出与绘制设备相同的格式，QPixmap::fromImage时无需再整帧转换
+    if (!m_ffmpegWrapper->setOutputFormat(probeNativeFormat())) {
+        m_ffmpegWrapper->setOutputFormat(QImage::Format_RGB32);
+    }
+    
+    // 统计面板叠加在视频区域左上角，默认隐藏
+    m_statsOverlay = new StatsOverlay(ui->videoLabel);
+    m_statsOverlay->setStats(&m_ffmpegWrapper->stats());
+    m_statsOverlay->setReadAhead(&m_ffmpegWrapper->readAhead());
+    m_statsOverlay->hide();
+    
+    // 跟踪记录视频区域的重绘
+    ui->videoLabel->installEventFilter(this);
+    
+    // 播放列表与媒体库：模型只为可见行提供数据，封面缩略图在后台加载
+    m_thumbnails->setThumbnailSize(ui->playlistView->iconSize());
+    m_thumbnails->setCacheDirectory(coverCachePath());
+    m_libraryModel->setThumbnailLoader(m_thumbnails);
+    ui->playlistView->setModel(m_playlistModel);
+    ui->libraryView->setModel(m_libraryModel);
+    ui->menuView->addAction(ui->libraryDock->toggleViewAction());
+    
+    connect(m_libraryModel, &LibraryModel::searchReady, this, [this](int records, double milliseconds) {
+        ui->libraryStatusLabel->setText(tr("媒体库共 %1 项（索引耗时 %2 毫秒）")
+                                        .arg(records).arg(milliseconds, 0, 'f', 0));
+    });
+    connect(m_libraryModel, &LibraryModel::filterApplied, this, [this](int matches, double milliseconds) {
+        if (!m_libraryModel->filterText().isEmpty()) {
+            ui->libraryStatusLabel->setText(tr("找到 %1 项（%2 毫秒）").arg(matches).arg(milliseconds, 0, 'f', 2));
+        }
+    });
+    
+    // 增量更新写入索引后重新加载；无法增量处理时整体重新扫描
+    connect(m_libraryWatcher, &LibraryWatcher::indexUpdated, this, [this]() {
+        m_libraryModel->open(libraryIndexPath());
+    });
+    connect(m_libraryWatcher, &LibraryWatcher::rescanRequired, this, &VideoPlayer::startLibraryScan);
+    
+    // 音乐文件的封面按播放区域的档位缓存，与列表缩略图共用磁盘缓存目录
+    m_coverArt->setThumbnailSize(QSize(512, 512));
+    m_coverArt->setCacheDirectory(coverCachePath());
+    connect(m_coverArt, &ThumbnailLoader::thumbnailReady, this, [this](const QString &filePath) {
+        if (filePath == m_currentFilePath && m_ffmpegWrapper->isCoverArtOnly()) {
+            showCoverArt();
+        }
+    });
+    
+    // 上次扫描的索引直接打开（映射文件，不需要等待）
+    if (QFile::exists(libraryIndexPath()) && !m_libraryModel->open(libraryIndexPath())) {
+        ui->libraryStatusLabel->setText(tr("媒体库索引无效，请重新扫描"));
+    }
+    
     // 连接信号槽
     connect(m_ffmpegWrapper, &FFmpegWrapper::frameReady, this, &VideoPlayer::onFrameReady);
     connect(m_ffmpegWrapper, &FFmpegWrapper::playbackFinished, this, &VideoPlayer::onPlaybackFinished);
@@ -42,25 +115,51 @@ VideoPlayer::VideoPlayer(QWidget *parent)
 
 VideoPlayer::~VideoPlayer()
 {
+    // 扫描可中断，中断时不写索引
+    if (m_scanThread) {
+        disconnect(m_scanThread, nullptr, this, nullptr);
+        m_libraryScanner->cancel();
+        m_scanThread->wait();
+        delete m_scanThread;
+    }
     delete ui;
 }
 
 void VideoPlayer::on_openButton_clicked()
 {
-    // 打开文件对话框
-    QString filePath = QFileDialog::getOpenFileName(
+    // 打开文件对话框，多选时按选择顺序组成播放列表
+    const QStringList filePaths = QFileDialog::getOpenFileNames(
                 this, 
                 tr("打开视频文件"), 
                 "/", 
                 tr("视频文件 (*.mp4 *.avi *.mkv *.flv *.wmv *.mov);;所有文件 (*.*)")
                 );
     
-    if (filePath.isEmpty()) {
+    if (filePaths.isEmpty()) {
         return;
     }
     
+    m_playlist->clear();
+    m_playlist->addFiles(filePaths);
+    ui->sideTabWidget->setCurrentWidget(ui->playlistTab);
+    openItem(0, false);
+}
+
+bool VideoPlayer::openItem(int index, bool autoPlay)
+{
+    const QString filePath = m_playlist->item(index).filePath;
+    
+    // 先取走为该项提前打开的解码器，再切换当前项（切换会开始准备再下一项）
+    std::unique_ptr<MediaDecoder> prepared = m_playlist->takePreparedDecoder(index);
+    m_playlist->setCurrentIndex(index);
+    
     // 打开视频文件
-    if (m_ffmpegWrapper->openFile(filePath)) {
+    const bool opened = m_ffmpegWrapper->openFile(filePath, std::move(prepared));
+    
+    // 接管预先打开的解码器后预读层换成了新对象
+    m_statsOverlay->setReadAhead(&m_ffmpegWrapper->readAhead());
+    
+    if (opened) {
         m_currentFilePath = filePath;
         m_duration = m_ffmpegWrapper->getDuration();
         
@@ -75,9 +174,26 @@ void VideoPlayer::on_openButton_clicked()
         ui->currentTimeLabel->setText(formatTime(0.0));
         ui->positionSlider->setValue(0);
         m_currentPosition = 0.0;
+        
+        // 音乐文件不解码内嵌封面，显示缓存的缩小图；顺便加载下一项的封面，切换时直接可用
+        if (m_ffmpegWrapper->isCoverArtOnly()) {
+            showCoverArt();
+            const int next = m_playlist->nextIndex();
+            if (next >= 0) {
+                m_coverArt->thumbnail(m_playlist->item(next).filePath);
+            }
+        }
+        
+        if (autoPlay) {
+            m_ffmpegWrapper->play();
+            m_isPlaying = true;
+            ui->playPauseButton->setText(tr("暂停"));
+            ui->statusLabel->setText(tr("正在播放: %1").arg(filePath.split("/").last()));
+        }
     } else {
         ui->statusLabel->setText(tr("打开文件失败"));
     }
+    return opened;
 }
 
 void VideoPlayer::on_playPauseButton_clicked()
@@ -141,8 +257,205 @@ void VideoPlayer::on_positionSlider_valueChanged(int value)
     }
 }
 
+void VideoPlayer::on_actionPlayReverse_triggered()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    // 暂停按钮照常可用，再次点击播放时恢复正向播放
+    m_ffmpegWrapper->playReverse();
+    m_isPlaying = true;
+    ui->playPauseButton->setText(tr("暂停"));
+    ui->statusLabel->setText(tr("正在倒放"));
+}
+
+void VideoPlayer::on_actionStepBackward_triggered()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    m_ffmpegWrapper->stepBackward();
+    m_isPlaying = false;
+    ui->playPauseButton->setText(tr("播放"));
+    ui->statusLabel->setText(tr("逐帧"));
+}
+
+void VideoPlayer::on_actionStepForward_triggered()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    m_ffmpegWrapper->stepForward();
+    m_isPlaying = false;
+    ui->playPauseButton->setText(tr("播放"));
+    ui->statusLabel->setText(tr("逐帧"));
+}
+
+void VideoPlayer::on_actionLoop_toggled(bool checked)
+{
+    m_ffmpegWrapper->setLooping(checked);
+    ui->statusLabel->setText(checked ? tr("循环播放") : tr("循环已关闭"));
+}
+
+void VideoPlayer::on_actionSetLoopA_triggered()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    // 保留已设置的B点，B点不在A点之后时由引擎视为循环到结尾
+    m_ffmpegWrapper->setLoopRange(m_currentPosition, m_ffmpegWrapper->loopEnd());
+    ui->statusLabel->setText(tr("A点: %1").arg(formatTime(m_currentPosition)));
+}
+
+void VideoPlayer::on_actionSetLoopB_triggered()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    if (m_currentPosition <= m_ffmpegWrapper->loopStart()) {
+        ui->statusLabel->setText(tr("B点必须在A点之后"));
+        return;
+    }
+    
+    m_ffmpegWrapper->setLoopRange(m_ffmpegWrapper->loopStart(), m_currentPosition);
+    ui->actionLoop->setChecked(true);
+    ui->statusLabel->setText(tr("A-B循环: %1 - %2")
+                             .arg(formatTime(m_ffmpegWrapper->loopStart()))
+                             .arg(formatTime(m_currentPosition)));
+}
+
+void VideoPlayer::on_actionClearLoopRange_triggered()
+{
+    m_ffmpegWrapper->clearLoopRange();
+    ui->statusLabel->setText(tr("已清除A-B区间"));
+}
+
+void VideoPlayer::on_actionNextItem_triggered()
+{
+    const int next = m_playlist->nextIndex();
+    if (next >= 0) {
+        openItem(next, m_isPlaying);
+    }
+}
+
+void VideoPlayer::on_actionPreviousItem_triggered()
+{
+    const int previous = m_playlist->previousIndex();
+    if (previous >= 0) {
+        openItem(previous, m_isPlaying);
+    }
+}
+
+void VideoPlayer::on_actionRepeatPlaylist_toggled(bool checked)
+{
+    m_playlist->setRepeat(checked);
+    
+    // 循环后末尾项也有下一项，需要重新准备
+    if (m_playlist->currentIndex() >= 0) {
+        m_playlist->setCurrentIndex(m_playlist->currentIndex());
+    }
+}
+
+void VideoPlayer::on_actionStatsOverlay_toggled(bool checked)
+{
+    m_statsOverlay->setVisible(checked);
+    if (checked) {
+        m_statsOverlay->raise();
+    }
+}
+
+void VideoPlayer::on_actionTrace_toggled(bool checked)
+{
+    TraceRecorder &trace = m_ffmpegWrapper->trace();
+    if (checked) {
+        trace.start();
+        ui->statusLabel->setText(tr("正在录制跟踪"));
+        return;
+    }
+    
+    trace.stop();
+    QString filePath = QFileDialog::getSaveFileName(
+                this, 
+                tr("保存跟踪文件"), 
+                "qvp-trace.json", 
+                tr("跟踪文件 (*.json)")
+                );
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    if (trace.writeJson(filePath)) {
+        ui->statusLabel->setText(tr("跟踪已保存: %1").arg(filePath.split("/").last()));
+    } else {
+        QMessageBox::critical(this, tr("错误"), trace.errorString());
+    }
+}
+
+void VideoPlayer::on_actionScanLibrary_triggered()
+{
+    const QString dirPath = QFileDialog::getExistingDirectory(this, tr("选择媒体库文件夹"), QDir::homePath());
+    if (dirPath.isEmpty()) {
+        return;
+    }
+    
+    if (!m_libraryRoots.contains(dirPath)) {
+        m_libraryRoots.append(dirPath);
+    }
+    ui->sideTabWidget->setCurrentWidget(ui->libraryTab);
+    startLibraryScan();
+}
+
+void VideoPlayer::on_playlistView_activated(const QModelIndex &index)
+{
+    if (index.isValid()) {
+        openItem(index.row(), true);
+    }
+}
+
+void VideoPlayer::on_libraryView_activated(const QModelIndex &index)
+{
+    const QString filePath = m_libraryModel->filePath(index.row());
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    m_playlist->addFiles(QStringList() << filePath);
+    openItem(m_playlist->count() - 1, true);
+}
+
+void VideoPlayer::on_librarySearchEdit_textChanged(const QString &text)
+{
+    m_libraryModel->setFilterText(text);
+}
+
+bool VideoPlayer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->videoLabel && event->type() == QEvent::Paint) {
+        m_ffmpegWrapper->trace().instant("paint");
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void VideoPlayer::onFrameReady(const QImage &image)
 {
+    // 界面线程处理不过来时队列中还有更新的帧，直接跳过这一帧
+    PipelineStats &stats = m_ffmpegWrapper->stats();
+    TraceRecorder &trace = m_ffmpegWrapper->trace();
+    trace.frameDequeued();
+    if (stats.frameDequeued() > 0) {
+        stats.addDroppedFrame();
+        trace.instant("drop");
+        return;
+    }
+    
+    PipelineStats::ScopedTimer timer(stats, PipelineStats::Stage::Present);
+    TraceRecorder::ScopedEvent event(trace, "present");
+    
     // 将QImage转换为QPixmap并显示
     QPixmap pixmap = QPixmap::fromImage(image);
     
@@ -153,10 +466,17 @@ void VideoPlayer::onFrameReady(const QImage &image)
                 Qt::SmoothTransformation);
     
     ui->videoLabel->setPixmap(scaledPixmap);
+    stats.addPresentedFrame();
 }
 
 void VideoPlayer::onPlaybackFinished()
 {
+    // 播放列表还有下一项时直接切换，下一项已在后台打开
+    const int next = m_playlist->nextIndex();
+    if (next >= 0 && openItem(next, true)) {
+        return;
+    }
+    
     m_isPlaying = false;
     ui->playPauseButton->setText(tr("播放"));
     ui->statusLabel->setText(tr("播放结束"));
@@ -193,8 +513,13 @@ void VideoPlayer::updateUI()
 
 void VideoPlayer::updatePlaybackStatus()
 {
+    // 状态查询需要解码器的互斥锁，解码线程持锁时这里会阻塞
+    TraceRecorder::ScopedEvent event(m_ffmpegWrapper->trace(), "poll_status");
+    
     // 根据播放器状态更新UI
-    if (m_ffmpegWrapper->isPlaying()) {
+    if (m_ffmpegWrapper->isReversing()) {
+        ui->statusLabel->setText(tr("正在倒放"));
+    } else if (m_ffmpegWrapper->isPlaying()) {
         ui->statusLabel->setText(tr("正在播放"));
     } else if (m_ffmpegWrapper->isPaused()) {
         ui->statusLabel->setText(tr("已暂停"));
@@ -222,6 +547,137 @@ void VideoPlayer::resetPlayer()
     ui->videoLabel->setPixmap(QPixmap());
 }
 
+void VideoPlayer::showCoverArt()
+{
+    const QImage image = m_coverArt->thumbnail(m_currentFilePath);
+    if (image.isNull()) {
+        ui->videoLabel->setPixmap(QPixmap());
+        ui->videoLabel->setText(QFileInfo(m_currentFilePath).completeBaseName());
+        return;
+    }
+    
+    // 缓存的封面只有几百像素见方，缩放到label大小的开销可以忽略
+    ui->videoLabel->setPixmap(QPixmap::fromImage(image).scaled(
+                                  ui->videoLabel->size(),
+                                  Qt::KeepAspectRatio,
+                                  Qt::SmoothTransformation));
+}
+
+void VideoPlayer::startLibraryScan()
+{
+    // 已在扫描时不重复开始，扫描结束后的结果已包含这次要求的内容
+    if (m_scanThread || m_libraryRoots.isEmpty()) {
+        return;
+    }
+    
+    // 扫描期间停止增量监视，扫描结束后重新建立
+    m_libraryWatcher->stop();
+    ui->libraryStatusLabel->setText(tr("正在扫描媒体库..."));
+    
+    const QStringList roots = m_libraryRoots;
+    const QString indexPath = libraryIndexPath();
+    // 媒体库模型正映射着原索引（Windows上被映射的文件不能替换），
+    // 扫描线程先写到旁边的文件，结束后由界面线程释放映射再替换
+    const QString stagedPath = indexPath + ".new";
+    m_libraryScanError.clear();
+    QString *errorString = &m_libraryScanError;
+    m_libraryScanner.reset(new LibraryScanner());
+    LibraryScanner *scanner = m_libraryScanner.get();
+    m_scanThread = QThread::create([scanner, roots, indexPath, stagedPath, errorString]() {
+        // 上次的索引中未变化的文件沿用原记录，不再探测
+        LibraryIndex previous;
+        const bool hasPrevious = QFile::exists(indexPath) && previous.open(indexPath);
+        scanner->setPreviousIndex(hasPrevious ? &previous : nullptr);
+        if (!scanner->scan(roots)) {
+            *errorString = "扫描被取消";
+            return;
+        }
+        std::vector<LibraryRecord> records = scanner->takeRecords();
+        previous.close();
+        LibraryIndex::write(stagedPath, std::move(records), errorString);
+    });
+    m_scanThread->setObjectName("qvp-libscan");
+    
+    connect(m_scanThread, &QThread::finished, this, [this, roots, indexPath, stagedPath]() {
+        const LibraryScanner::Stats stats = m_libraryScanner->stats();
+        m_scanThread->deleteLater();
+        m_scanThread = nullptr;
+        m_libraryScanner.reset();
+        
+        // 写索引失败时原索引不变，列表照旧显示，也不恢复监视（监视写入同一文件多半也会失败）
+        if (!m_libraryScanError.isEmpty()) {
+            QFile::remove(stagedPath);
+            ui->libraryStatusLabel->setText(tr("媒体库扫描失败: %1").arg(m_libraryScanError));
+            return;
+        }
+        
+        // 释放模型对原索引的映射后再替换；替换失败时重新打开原索引，新索引留给下次
+        // （被放弃的倒排索引建立线程可能还映射着原索引，Windows上这时无法移走）
+        m_libraryModel->close();
+        QString replaceError;
+        if (!replaceLibraryIndex(stagedPath, indexPath, &replaceError)) {
+            if (QFile::exists(indexPath)) {
+                m_libraryModel->open(indexPath);
+            }
+            // 重新打开后标签会显示记录数，失败原因留在状态栏
+            ui->statusbar->showMessage(tr("媒体库扫描失败: %1").arg(replaceError));
+            return;
+        }
+        if (!m_libraryModel->open(indexPath)) {
+            ui->libraryStatusLabel->setText(tr("媒体库索引无效: %1").arg(m_libraryModel->errorString()));
+            return;
+        }
+        // 播放状态标签由定时器刷新，扫描结果显示在状态栏
+        if (m_libraryWatcher->start(roots, indexPath)) {
+            ui->statusbar->showMessage(tr("媒体库扫描完成: %1 个文件，%2 秒")
+                                       .arg(stats.files).arg(stats.seconds, 0, 'f', 1), 5000);
+        } else if (m_libraryWatcher->isWatching()) {
+            ui->statusbar->showMessage(tr("媒体库扫描完成，但%1").arg(m_libraryWatcher->errorString()));
+        } else {
+            ui->statusbar->showMessage(tr("媒体库不会自动更新: %1").arg(m_libraryWatcher->errorString()));
+        }
+    });
+    m_scanThread->start();
+}
+
+bool VideoPlayer::replaceLibraryIndex(const QString &stagedPath, const QString &indexPath, QString *errorString)
+{
+    // 原索引先改名为备份，新索引就位后才删除备份，任何一步失败都不会没有索引
+    const QString backupPath = indexPath + ".old";
+    QFile::remove(backupPath);
+    if (QFile::exists(indexPath) && !QFile::rename(indexPath, backupPath)) {
+        *errorString = QString("无法移走原索引文件 %1").arg(indexPath);
+        return false;
+    }
+    if (!QFile::rename(stagedPath, indexPath)) {
+        QFile::rename(backupPath, indexPath);
+        *errorString = QString("无法替换索引文件 %1").arg(indexPath);
+        return false;
+    }
+    QFile::remove(backupPath);
+    return true;
+}
+
+QString VideoPlayer::libraryIndexPath()
+{
+    const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dirPath);
+    return QDir(dirPath).filePath("library.idx");
+}
+
+QString VideoPlayer::coverCachePath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("covers");
+}
+
+QImage::Format VideoPlayer::probeNativeFormat()
+{
+    // 不透明的QPixmap转回QImage时不会做格式转换，得到的就是其内部格式
+    QPixmap probe(1, 1);
+    probe.fill(Qt::black);
+    return probe.toImage().format();
+}
+
 QString VideoPlayer::formatTime(double seconds) const
 {
     int totalSeconds = static_cast<int>(seconds);
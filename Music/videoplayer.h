@@ -6,9 +6,20 @@
 #include <QPixmap>
 #include <QTimer>
 #include <QString>
+#include <QStringList>
+#include <memory>
 
 // Forward declaration to reduce compile time
 class FFmpegWrapper;
+class LibraryModel;
+class LibraryScanner;
+class LibraryWatcher;
+class Playlist;
+class PlaylistModel;
+class QModelIndex;
+class QThread;
+class StatsOverlay;
+class ThumbnailLoader;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class VideoPlayer; }
@@ -21,7 +32,9 @@ QT_END_NAMESPACE
  * - 视频显示
  * - 播放控制（播放/暂停/停止）
  * - 进度条控制
- * - 文件选择
+ * - 文件选择（多选时组成播放列表，依次播放）
+ * - 播放列表与媒体库面板（扫描文件夹建立索引，搜索，增量更新）
+ * - 音乐文件显示缓存的内嵌封面缩小图
  * - 时间显示
  */
 class VideoPlayer : public QMainWindow
@@ -40,6 +53,15 @@ public:
      */
     ~VideoPlayer() override;
 
+protected:
+    /**
+     * @brief 事件过滤器，用于跟踪视频区域的重绘
+     * @param watched 被监视的对象
+     * @param event 事件
+     * @return 是否拦截该事件
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
     /**
      * @brief 打开文件按钮点击事件
@@ -72,6 +94,93 @@ private slots:
      */
     void on_positionSlider_valueChanged(int value);
     
+    /**
+     * @brief 从当前位置开始倒放
+     */
+    void on_actionPlayReverse_triggered();
+    
+    /**
+     * @brief 后退一帧并暂停
+     */
+    void on_actionStepBackward_triggered();
+    
+    /**
+     * @brief 前进一帧并暂停
+     */
+    void on_actionStepForward_triggered();
+    
+    /**
+     * @brief 循环播放菜单项切换事件
+     * @param checked 是否循环播放
+     */
+    void on_actionLoop_toggled(bool checked);
+    
+    /**
+     * @brief 以当前位置为A点
+     */
+    void on_actionSetLoopA_triggered();
+    
+    /**
+     * @brief 以当前位置为B点并开启循环播放
+     */
+    void on_actionSetLoopB_triggered();
+    
+    /**
+     * @brief 清除A-B区间，恢复整个文件循环
+     */
+    void on_actionClearLoopRange_triggered();
+    
+    /**
+     * @brief 播放列表中的下一项
+     */
+    void on_actionNextItem_triggered();
+    
+    /**
+     * @brief 播放列表中的上一项
+     */
+    void on_actionPreviousItem_triggered();
+    
+    /**
+     * @brief 列表循环菜单项切换事件
+     * @param checked 播放到末尾后是否回到第一项
+     */
+    void on_actionRepeatPlaylist_toggled(bool checked);
+    
+    /**
+     * @brief 统计信息菜单项切换事件
+     * @param checked 是否显示统计面板
+     */
+    void on_actionStatsOverlay_toggled(bool checked);
+    
+    /**
+     * @brief 录制跟踪菜单项切换事件（停止时保存为Chrome trace JSON）
+     * @param checked 是否开始录制
+     */
+    void on_actionTrace_toggled(bool checked);
+    
+    /**
+     * @brief 选择文件夹加入媒体库并扫描
+     */
+    void on_actionScanLibrary_triggered();
+    
+    /**
+     * @brief 双击播放列表中的一项时播放该项
+     * @param index 模型索引
+     */
+    void on_playlistView_activated(const QModelIndex &index);
+    
+    /**
+     * @brief 双击媒体库中的一项时加入播放列表并播放
+     * @param index 模型索引
+     */
+    void on_libraryView_activated(const QModelIndex &index);
+    
+    /**
+     * @brief 媒体库搜索框内容改变时过滤
+     * @param text 搜索文本
+     */
+    void on_librarySearchEdit_textChanged(const QString &text);
+    
     /**
      * @brief 视频帧更新事件
      * @param image 解码后的视频帧
@@ -108,6 +217,14 @@ private:
      */
     QString formatTime(double seconds) const;
     
+    /**
+     * @brief 打开播放列表中的一项（使用后台提前打开的解码器）
+     * @param index 序号
+     * @param autoPlay 打开后是否立即播放
+     * @return 是否成功
+     */
+    bool openItem(int index, bool autoPlay);
+    
     /**
      * @brief 更新播放状态显示
      */
@@ -118,6 +235,43 @@ private:
      */
     void resetPlayer();
     
+    /**
+     * @brief 音乐文件在视频区域显示缓存的封面（尚未加载时先显示文件名，加载完成后再次调用）
+     */
+    void showCoverArt();
+
+    /**
+     * @brief 在后台扫描媒体库根目录并重写索引，完成后重新加载列表并开始增量监视
+     */
+    void startLibraryScan();
+    
+    /**
+     * @brief 用扫描写好的新索引替换原索引（调用前须释放对原索引的映射）
+     * @param stagedPath 新索引文件，失败时保留
+     * @param indexPath 索引文件，失败时保持原样
+     * @param errorString 失败时输出原因
+     * @return 是否成功
+     */
+    static bool replaceLibraryIndex(const QString &stagedPath, const QString &indexPath, QString *errorString);
+    
+    /**
+     * @brief 获取媒体库索引文件的路径
+     * @return 路径（所在目录不存在时会创建）
+     */
+    static QString libraryIndexPath();
+    
+    /**
+     * @brief 获取封面缩小图磁盘缓存的目录
+     * @return 路径
+     */
+    static QString coverCachePath();
+
+    /**
+     * @brief 探测绘制设备的原生图像格式
+     * @return QPixmap内部使用的图像格式
+     */
+    static QImage::Format probeNativeFormat();
+    
     Ui::VideoPlayer *ui;
     
     // Video playback core
@@ -130,6 +284,25 @@ private:
     // UI update timer
     QTimer *m_uiUpdateTimer;
     
+    // Pipeline statistics overlay
+    StatsOverlay *m_statsOverlay;
+    
+    // Playlist with background probing and next-item preparation
+    Playlist *m_playlist;
+    
+    // Playlist and library views
+    ThumbnailLoader *m_thumbnails;
+    PlaylistModel *m_playlistModel;
+    LibraryModel *m_libraryModel;
+    LibraryWatcher *m_libraryWatcher;
+    QStringList m_libraryRoots;
+    std::unique_ptr<LibraryScanner> m_libraryScanner;
+    QString m_libraryScanError;
+    QThread *m_scanThread;
+    
+    // Cover art shown in place of the attached picture of music files
+    ThumbnailLoader *m_coverArt;
+    
     // Video information
     QString m_currentFilePath;
     double m_duration;
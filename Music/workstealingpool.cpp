@@ -0,0 +1,146 @@
+#include "workstealingpool.h"
+
+namespace {
+
+// 当前线程所属线程池及其序号
+thread_local const WorkStealingPool *t_pool = nullptr;
+thread_local int t_worker = -1;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(const QString &name, int threadCount)
+    : m_nextQueue(0)
+    , m_queued(0)
+    , m_pending(0)
+    , m_stopping(false)
+    , m_steals(0)
+{
+    const int count = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < count; ++i) {
+        m_queues.push_back(std::unique_ptr<Queue>(new Queue));
+    }
+    for (int i = 0; i < count; ++i) {
+        QThread *thread = QThread::create([this, i]() {
+            run(i);
+        });
+        thread->setObjectName(QString("%1-%2").arg(name).arg(i));
+        thread->start();
+        m_threads.push_back(thread);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_taskQueued.wakeAll();
+    }
+    for (QThread *thread : m_threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    // 工作线程提交的子任务留在本线程，外部提交的任务轮流分配
+    const int index = (t_pool == this && t_worker >= 0)
+            ? t_worker
+            : static_cast<int>(m_nextQueue++ % m_queues.size());
+
+    m_pending++;
+    {
+        Queue &queue = *m_queues[index];
+        QMutexLocker locker(&queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    // 计数在m_mutex内增加，空闲线程检查计数和进入等待之间不会漏掉唤醒
+    QMutexLocker locker(&m_mutex);
+    m_queued++;
+    m_taskQueued.wakeOne();
+}
+
+void WorkStealingPool::waitForDone()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pending > 0) {
+        m_allDone.wait(&m_mutex);
+    }
+}
+
+int WorkStealingPool::threadCount() const
+{
+    return static_cast<int>(m_threads.size());
+}
+
+int WorkStealingPool::currentWorker()
+{
+    return t_worker;
+}
+
+quint64 WorkStealingPool::stealCount() const
+{
+    return m_steals;
+}
+
+void WorkStealingPool::run(int index)
+{
+    t_pool = this;
+    t_worker = index;
+
+    for (;;) {
+        Task task;
+        if (!takeTask(index, &task)) {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopping && m_queued == 0) {
+                m_taskQueued.wait(&m_mutex);
+            }
+            if (m_stopping) {
+                break;
+            }
+            continue;
+        }
+
+        m_queued--;
+        task();
+        task = nullptr;
+
+        // 最后一个任务完成时唤醒waitForDone（子任务在父任务返回前已计入）
+        if (--m_pending == 0) {
+            QMutexLocker locker(&m_mutex);
+            m_allDone.wakeAll();
+        }
+    }
+
+    t_pool = nullptr;
+    t_worker = -1;
+}
+
+bool WorkStealingPool::takeTask(int index, Task *task)
+{
+    {
+        Queue &own = *m_queues[index];
+        QMutexLocker locker(&own.mutex);
+        if (!own.tasks.empty()) {
+            *task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // 从下一个队列开始依次尝试，避免所有空闲线程都去抢同一个队列
+    const int count = static_cast<int>(m_queues.size());
+    for (int offset = 1; offset < count; ++offset) {
+        Queue &victim = *m_queues[(index + offset) % count];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.tasks.empty()) {
+            *task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_steals++;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,114 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程有自己的任务队列：任务中再提交的子任务放入本线程队列的尾部并优先取出（后进先出，
+ * 目录遍历时先深入当前子树，数据局部性好），空闲线程从其他队列的头部窃取最早提交的任务（通常是更大的子树）。
+ * 适合任务数量事先未知、大小差别很大的递归工作，例如遍历目录树并逐个探测文件：
+ * 一个线程遇到大目录时，其余线程会把它的子目录分走，不会只剩一个线程在忙。
+ * 每个队列有各自的锁，线程之间只在窃取时竞争。
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * @brief 任务
+     */
+    using Task = std::function<void()>;
+
+    /**
+     * @brief 构造函数，立即启动工作线程
+     * @param name 线程名前缀
+     * @param threadCount 线程数，0表示CPU核心数
+     */
+    explicit WorkStealingPool(const QString &name, int threadCount = 0);
+
+    /**
+     * @brief 析构函数，丢弃未开始的任务并等待工作线程退出
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * @brief 提交任务（在工作线程中调用时放入本线程的队列，否则轮流放入各队列）
+     * @param task 任务
+     */
+    void submit(Task task);
+
+    /**
+     * @brief 等待全部任务（包括执行中提交的子任务）完成，不能在工作线程中调用
+     */
+    void waitForDone();
+
+    /**
+     * @brief 获取线程数
+     * @return 线程数
+     */
+    int threadCount() const;
+
+    /**
+     * @brief 获取调用线程在其所属线程池中的序号
+     * @return 序号，不是工作线程时为-1
+     */
+    static int currentWorker();
+
+    /**
+     * @brief 获取从其他线程队列窃取的任务数
+     * @return 次数
+     */
+    quint64 stealCount() const;
+
+private:
+    /**
+     * @brief 单个工作线程的任务队列
+     */
+    struct Queue {
+        QMutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * @brief 工作线程主函数
+     * @param index 线程序号
+     */
+    void run(int index);
+
+    /**
+     * @brief 取一个任务：先从本线程队列尾部取，没有时从其他队列头部窃取
+     * @param index 线程序号
+     * @param task 输出任务
+     * @return 所有队列都为空时返回false
+     */
+    bool takeTask(int index, Task *task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<QThread *> m_threads;
+    std::atomic<unsigned> m_nextQueue;
+
+    // Idle workers sleep until a task is queued; waitForDone sleeps until nothing is pending
+    QMutex m_mutex;
+    QWaitCondition m_taskQueued;
+    QWaitCondition m_allDone;
+    std::atomic<qint64> m_queued;
+    std::atomic<qint64> m_pending;
+    bool m_stopping;
+
+    // Counters
+    std::atomic<quint64> m_steals;
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,806 @@
+#include "yuvconverter.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <libavutil/cpu.h>
+#include <libavutil/frame.h>
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define QVP_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// GCC/Clang需要按函数开启指令集，MSVC可直接使用内建函数
+#if defined(__GNUC__) || defined(__clang__)
+#define QVP_TARGET(x) __attribute__((target(x)))
+#else
+#define QVP_TARGET(x)
+#endif
+
+namespace {
+
+typedef YuvConverter::Coefficients Coefficients;
+
+// Q6定点系数：{亮度偏移, 亮度系数, R-V, G-U, G-V, B-U}
+const Coefficients kBt601Limited = { 16, 75, 102, 25, 52, 129 };
+const Coefficients kBt601Full    = {  0, 64,  90, 22, 46, 113 };
+const Coefficients kBt709Limited = { 16, 75, 115, 14, 34, 135 };
+const Coefficients kBt709Full    = {  0, 64, 101, 12, 30, 119 };
+
+// 中间结果的舍入量（Q6的0.5）
+const int kRound = 32;
+
+/**
+ * @brief 根据帧的色彩空间和范围选择系数
+ * @param frame 源帧
+ * @param forceFullRange 格式本身即为全范围（yuvj系列）
+ */
+const Coefficients &coefficientsFor(const AVFrame *frame, bool forceFullRange)
+{
+    const bool fullRange = forceFullRange || frame->color_range == AVCOL_RANGE_JPEG;
+
+    // 未标注色彩空间时按常见约定：高清内容使用BT.709
+    bool bt709 = frame->colorspace == AVCOL_SPC_BT709;
+    if (frame->colorspace == AVCOL_SPC_UNSPECIFIED && frame->height > 576) {
+        bt709 = true;
+    }
+
+    if (bt709) {
+        return fullRange ? kBt709Full : kBt709Limited;
+    }
+    return fullRange ? kBt601Full : kBt601Limited;
+}
+
+// ---------------------------------------------------------------------------
+// 格式特征：源格式的位深、色度采样和排列方式，目标格式的字节顺序
+// ---------------------------------------------------------------------------
+
+template <int BitDepth, int ChromaShiftW, int ChromaShiftH,
+          bool Interleaved = false, bool SwapUV = false, bool FullRange = false>
+struct YuvLayout {
+    static constexpr int kBitDepth = BitDepth;
+    static constexpr int kChromaShiftW = ChromaShiftW;
+    static constexpr int kChromaShiftH = ChromaShiftH;
+    static constexpr bool kInterleaved = Interleaved;
+    static constexpr bool kSwapUV = SwapUV;
+    static constexpr bool kFullRange = FullRange;
+};
+
+template <AVPixelFormat Format> struct SourceTraits;
+template <> struct SourceTraits<AV_PIX_FMT_YUV420P>     : YuvLayout<8, 1, 1> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUVJ420P>    : YuvLayout<8, 1, 1, false, false, true> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUV422P>     : YuvLayout<8, 1, 0> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUVJ422P>    : YuvLayout<8, 1, 0, false, false, true> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUV444P>     : YuvLayout<8, 0, 0> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUVJ444P>    : YuvLayout<8, 0, 0, false, false, true> {};
+template <> struct SourceTraits<AV_PIX_FMT_NV12>        : YuvLayout<8, 1, 1, true> {};
+template <> struct SourceTraits<AV_PIX_FMT_NV21>        : YuvLayout<8, 1, 1, true, true> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUV420P10LE> : YuvLayout<10, 1, 1> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUV422P10LE> : YuvLayout<10, 1, 0> {};
+template <> struct SourceTraits<AV_PIX_FMT_YUV444P10LE> : YuvLayout<10, 0, 0> {};
+
+template <AVPixelFormat Format> struct DestTraits;
+template <> struct DestTraits<AV_PIX_FMT_BGRA> { static constexpr bool kSwapRB = false; };
+template <> struct DestTraits<AV_PIX_FMT_RGBA> { static constexpr bool kSwapRB = true; };
+
+// ---------------------------------------------------------------------------
+// 标量参考实现
+// 每一步都模拟16位饱和运算，与SIMD实现逐字节一致
+// ---------------------------------------------------------------------------
+
+inline int saturate16(int value)
+{
+    return std::min(32767, std::max(-32768, value));
+}
+
+inline uint8_t clampPixel(int value)
+{
+    return static_cast<uint8_t>(std::min(255, std::max(0, value >> 6)));
+}
+
+template <bool SwapRB, int ChromaShiftW>
+void convertRangeScalar(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                        uint8_t *dst, int begin, int end, const Coefficients &c)
+{
+    for (int i = begin; i < end; ++i) {
+        const int yy = (y[i] - c.yOffset) * c.yCoef;
+        const int uu = u[i >> ChromaShiftW] - 128;
+        const int vv = v[i >> ChromaShiftW] - 128;
+
+        const uint8_t r = clampPixel(saturate16(saturate16(yy + vv * c.rv) + kRound));
+        const uint8_t g = clampPixel(saturate16(saturate16(saturate16(yy - uu * c.gu) - vv * c.gv) + kRound));
+        const uint8_t b = clampPixel(saturate16(saturate16(yy + uu * c.bu) + kRound));
+
+        uint8_t *pixel = dst + i * 4;
+        pixel[0] = SwapRB ? r : b;
+        pixel[1] = g;
+        pixel[2] = SwapRB ? b : r;
+        pixel[3] = 0xFF;
+    }
+}
+
+struct ScalarIsa {
+    template <bool SwapRB, int ChromaShiftW>
+    static void row(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                    uint8_t *dst, int width, const Coefficients &c)
+    {
+        convertRangeScalar<SwapRB, ChromaShiftW>(y, u, v, dst, 0, width, c);
+    }
+
+    static void deinterleave(const uint8_t *uv, uint8_t *u, uint8_t *v, int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+    }
+
+    template <int Shift>
+    static void pack(const uint8_t *src, uint8_t *dst, int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            const int sample = src[i * 2] | (src[i * 2 + 1] << 8);
+            dst[i] = static_cast<uint8_t>(std::min(255, (sample + (1 << (Shift - 1))) >> Shift));
+        }
+    }
+};
+
+#ifdef QVP_X86_SIMD
+
+// ---------------------------------------------------------------------------
+// SSE4.1：每次处理16个像素
+// ---------------------------------------------------------------------------
+
+struct Sse41Coefficients {
+    __m128i yOffset;
+    __m128i yCoef;
+    __m128i rv;
+    __m128i gu;
+    __m128i gv;
+    __m128i bu;
+    __m128i chromaOffset;
+    __m128i round;
+};
+
+QVP_TARGET("sse4.1")
+inline Sse41Coefficients loadSse41(const Coefficients &c)
+{
+    Sse41Coefficients k;
+    k.yOffset = _mm_set1_epi16(c.yOffset);
+    k.yCoef = _mm_set1_epi16(c.yCoef);
+    k.rv = _mm_set1_epi16(c.rv);
+    k.gu = _mm_set1_epi16(c.gu);
+    k.gv = _mm_set1_epi16(c.gv);
+    k.bu = _mm_set1_epi16(c.bu);
+    k.chromaOffset = _mm_set1_epi16(128);
+    k.round = _mm_set1_epi16(kRound);
+    return k;
+}
+
+QVP_TARGET("sse4.1")
+inline void yuvToRgbSse41(__m128i y, __m128i u, __m128i v, const Sse41Coefficients &k,
+                          __m128i &r, __m128i &g, __m128i &b)
+{
+    y = _mm_mullo_epi16(_mm_sub_epi16(y, k.yOffset), k.yCoef);
+    u = _mm_sub_epi16(u, k.chromaOffset);
+    v = _mm_sub_epi16(v, k.chromaOffset);
+
+    r = _mm_adds_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(v, k.rv)), k.round);
+    g = _mm_subs_epi16(_mm_subs_epi16(y, _mm_mullo_epi16(u, k.gu)), _mm_mullo_epi16(v, k.gv));
+    g = _mm_adds_epi16(g, k.round);
+    b = _mm_adds_epi16(_mm_adds_epi16(y, _mm_mullo_epi16(u, k.bu)), k.round);
+
+    r = _mm_srai_epi16(r, 6);
+    g = _mm_srai_epi16(g, 6);
+    b = _mm_srai_epi16(b, 6);
+}
+
+/**
+ * @brief 把16个像素的R/G/B字节交织为4字节像素写出（64字节）
+ */
+template <bool SwapRB>
+QVP_TARGET("sse4.1")
+inline void storePixelsSse41(uint8_t *dst, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i first = SwapRB ? r : b;
+    const __m128i third = SwapRB ? b : r;
+    const __m128i a = _mm_set1_epi8(static_cast<char>(0xFF));
+    const __m128i lo01 = _mm_unpacklo_epi8(first, g);
+    const __m128i hi01 = _mm_unpackhi_epi8(first, g);
+    const __m128i lo23 = _mm_unpacklo_epi8(third, a);
+    const __m128i hi23 = _mm_unpackhi_epi8(third, a);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(lo01, lo23));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(lo01, lo23));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), _mm_unpacklo_epi16(hi01, hi23));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 48), _mm_unpackhi_epi16(hi01, hi23));
+}
+
+/**
+ * @brief 读取16个像素对应的色度（水平2:1时复制到每个像素）
+ */
+template <int ChromaShiftW>
+QVP_TARGET("sse4.1")
+inline __m128i loadChromaSse41(const uint8_t *chroma, int pixel)
+{
+    if (ChromaShiftW == 1) {
+        const __m128i half = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(chroma + pixel / 2));
+        return _mm_unpacklo_epi8(half, half);
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(chroma + pixel));
+}
+
+struct Sse41Isa {
+    template <bool SwapRB, int ChromaShiftW>
+    QVP_TARGET("sse4.1")
+    static void row(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                    uint8_t *dst, int width, const Coefficients &c)
+    {
+        const Sse41Coefficients k = loadSse41(c);
+
+        int i = 0;
+        for (; i + 16 <= width; i += 16) {
+            const __m128i yy = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            const __m128i uu = loadChromaSse41<ChromaShiftW>(u, i);
+            const __m128i vv = loadChromaSse41<ChromaShiftW>(v, i);
+
+            __m128i rLo, gLo, bLo, rHi, gHi, bHi;
+            yuvToRgbSse41(_mm_cvtepu8_epi16(yy), _mm_cvtepu8_epi16(uu), _mm_cvtepu8_epi16(vv),
+                          k, rLo, gLo, bLo);
+            yuvToRgbSse41(_mm_cvtepu8_epi16(_mm_srli_si128(yy, 8)),
+                          _mm_cvtepu8_epi16(_mm_srli_si128(uu, 8)),
+                          _mm_cvtepu8_epi16(_mm_srli_si128(vv, 8)),
+                          k, rHi, gHi, bHi);
+
+            storePixelsSse41<SwapRB>(dst + i * 4, _mm_packus_epi16(rLo, rHi),
+                                     _mm_packus_epi16(gLo, gHi), _mm_packus_epi16(bLo, bHi));
+        }
+
+        convertRangeScalar<SwapRB, ChromaShiftW>(y, u, v, dst, i, width, c);
+    }
+
+    QVP_TARGET("sse4.1")
+    static void deinterleave(const uint8_t *uv, uint8_t *u, uint8_t *v, int count)
+    {
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + i * 2));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + i * 2 + 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(u + i),
+                             _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(v + i),
+                             _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+        }
+
+        ScalarIsa::deinterleave(uv + i * 2, u + i, v + i, count - i);
+    }
+
+    template <int Shift>
+    QVP_TARGET("sse4.1")
+    static void pack(const uint8_t *src, uint8_t *dst, int count)
+    {
+        const __m128i round = _mm_set1_epi16(1 << (Shift - 1));
+
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2 + 16));
+            a = _mm_srli_epi16(_mm_add_epi16(a, round), Shift);
+            b = _mm_srli_epi16(_mm_add_epi16(b, round), Shift);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+        }
+
+        ScalarIsa::pack<Shift>(src + i * 2, dst + i, count - i);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// AVX2：每次处理32个像素
+// ---------------------------------------------------------------------------
+
+struct Avx2Coefficients {
+    __m256i yOffset;
+    __m256i yCoef;
+    __m256i rv;
+    __m256i gu;
+    __m256i gv;
+    __m256i bu;
+    __m256i chromaOffset;
+    __m256i round;
+};
+
+QVP_TARGET("avx2")
+inline Avx2Coefficients loadAvx2(const Coefficients &c)
+{
+    Avx2Coefficients k;
+    k.yOffset = _mm256_set1_epi16(c.yOffset);
+    k.yCoef = _mm256_set1_epi16(c.yCoef);
+    k.rv = _mm256_set1_epi16(c.rv);
+    k.gu = _mm256_set1_epi16(c.gu);
+    k.gv = _mm256_set1_epi16(c.gv);
+    k.bu = _mm256_set1_epi16(c.bu);
+    k.chromaOffset = _mm256_set1_epi16(128);
+    k.round = _mm256_set1_epi16(kRound);
+    return k;
+}
+
+QVP_TARGET("avx2")
+inline void yuvToRgbAvx2(__m256i y, __m256i u, __m256i v, const Avx2Coefficients &k,
+                         __m256i &r, __m256i &g, __m256i &b)
+{
+    y = _mm256_mullo_epi16(_mm256_sub_epi16(y, k.yOffset), k.yCoef);
+    u = _mm256_sub_epi16(u, k.chromaOffset);
+    v = _mm256_sub_epi16(v, k.chromaOffset);
+
+    r = _mm256_adds_epi16(_mm256_adds_epi16(y, _mm256_mullo_epi16(v, k.rv)), k.round);
+    g = _mm256_subs_epi16(_mm256_subs_epi16(y, _mm256_mullo_epi16(u, k.gu)), _mm256_mullo_epi16(v, k.gv));
+    g = _mm256_adds_epi16(g, k.round);
+    b = _mm256_adds_epi16(_mm256_adds_epi16(y, _mm256_mullo_epi16(u, k.bu)), k.round);
+
+    r = _mm256_srai_epi16(r, 6);
+    g = _mm256_srai_epi16(g, 6);
+    b = _mm256_srai_epi16(b, 6);
+}
+
+/**
+ * @brief 16个16位结果饱和压缩为16字节（避免AVX2跨128位通道的打包顺序问题）
+ */
+QVP_TARGET("avx2")
+inline __m128i packAvx2(__m256i value)
+{
+    return _mm_packus_epi16(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+}
+
+/**
+ * @brief 读取32个像素对应的色度，分为前后两组16个像素
+ */
+template <int ChromaShiftW>
+QVP_TARGET("avx2")
+inline void loadChromaAvx2(const uint8_t *chroma, int pixel, __m256i &first, __m256i &second)
+{
+    if (ChromaShiftW == 1) {
+        const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chroma + pixel / 2));
+        first = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(half, half));
+        second = _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(half, half));
+    } else {
+        first = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(chroma + pixel)));
+        second = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(chroma + pixel + 16)));
+    }
+}
+
+struct Avx2Isa {
+    template <bool SwapRB, int ChromaShiftW>
+    QVP_TARGET("avx2")
+    static void row(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                    uint8_t *dst, int width, const Coefficients &c)
+    {
+        const Avx2Coefficients k = loadAvx2(c);
+
+        int i = 0;
+        for (; i + 32 <= width; i += 32) {
+            const __m128i y0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            const __m128i y1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i + 16));
+            __m256i u0, u1, v0, v1;
+            loadChromaAvx2<ChromaShiftW>(u, i, u0, u1);
+            loadChromaAvx2<ChromaShiftW>(v, i, v0, v1);
+
+            __m256i r0, g0, b0, r1, g1, b1;
+            yuvToRgbAvx2(_mm256_cvtepu8_epi16(y0), u0, v0, k, r0, g0, b0);
+            yuvToRgbAvx2(_mm256_cvtepu8_epi16(y1), u1, v1, k, r1, g1, b1);
+
+            storePixelsSse41<SwapRB>(dst + i * 4, packAvx2(r0), packAvx2(g0), packAvx2(b0));
+            storePixelsSse41<SwapRB>(dst + (i + 16) * 4, packAvx2(r1), packAvx2(g1), packAvx2(b1));
+        }
+
+        // 剩余不足32个像素交给SSE4.1处理（i为32的倍数，色度偏移是整数）
+        Sse41Isa::row<SwapRB, ChromaShiftW>(y + i, u + (i >> ChromaShiftW), v + (i >> ChromaShiftW),
+                                            dst + i * 4, width - i, c);
+    }
+
+    // 拆分和降精度开销远小于行转换，直接复用SSE4.1实现
+    static void deinterleave(const uint8_t *uv, uint8_t *u, uint8_t *v, int count)
+    {
+        Sse41Isa::deinterleave(uv, u, v, count);
+    }
+
+    template <int Shift>
+    static void pack(const uint8_t *src, uint8_t *dst, int count)
+    {
+        Sse41Isa::pack<Shift>(src, dst, count);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// AVX-512（需要BW扩展）：每次处理64个像素
+// ---------------------------------------------------------------------------
+
+struct Avx512Coefficients {
+    __m512i yOffset;
+    __m512i yCoef;
+    __m512i rv;
+    __m512i gu;
+    __m512i gv;
+    __m512i bu;
+    __m512i chromaOffset;
+    __m512i round;
+};
+
+QVP_TARGET("avx512f,avx512bw")
+inline Avx512Coefficients loadAvx512(const Coefficients &c)
+{
+    Avx512Coefficients k;
+    k.yOffset = _mm512_set1_epi16(c.yOffset);
+    k.yCoef = _mm512_set1_epi16(c.yCoef);
+    k.rv = _mm512_set1_epi16(c.rv);
+    k.gu = _mm512_set1_epi16(c.gu);
+    k.gv = _mm512_set1_epi16(c.gv);
+    k.bu = _mm512_set1_epi16(c.bu);
+    k.chromaOffset = _mm512_set1_epi16(128);
+    k.round = _mm512_set1_epi16(kRound);
+    return k;
+}
+
+QVP_TARGET("avx512f,avx512bw")
+inline void yuvToRgbAvx512(__m512i y, __m512i u, __m512i v, const Avx512Coefficients &k,
+                           __m512i &r, __m512i &g, __m512i &b)
+{
+    y = _mm512_mullo_epi16(_mm512_sub_epi16(y, k.yOffset), k.yCoef);
+    u = _mm512_sub_epi16(u, k.chromaOffset);
+    v = _mm512_sub_epi16(v, k.chromaOffset);
+
+    r = _mm512_adds_epi16(_mm512_adds_epi16(y, _mm512_mullo_epi16(v, k.rv)), k.round);
+    g = _mm512_subs_epi16(_mm512_subs_epi16(y, _mm512_mullo_epi16(u, k.gu)), _mm512_mullo_epi16(v, k.gv));
+    g = _mm512_adds_epi16(g, k.round);
+    b = _mm512_adds_epi16(_mm512_adds_epi16(y, _mm512_mullo_epi16(u, k.bu)), k.round);
+
+    r = _mm512_srai_epi16(r, 6);
+    g = _mm512_srai_epi16(g, 6);
+    b = _mm512_srai_epi16(b, 6);
+}
+
+/**
+ * @brief 读取32个像素对应的色度并扩展为16位
+ */
+template <int ChromaShiftW>
+QVP_TARGET("avx512f,avx512bw")
+inline __m512i loadChromaAvx512(const uint8_t *chroma, int pixel)
+{
+    if (ChromaShiftW == 1) {
+        const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chroma + pixel / 2));
+        const __m256i dup = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_unpacklo_epi8(half, half)),
+            _mm_unpackhi_epi8(half, half), 1);
+        return _mm512_cvtepu8_epi16(dup);
+    }
+    return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(chroma + pixel)));
+}
+
+/**
+ * @brief 32个16位结果饱和压缩为32字节（vpmovuswb不跨通道打乱顺序）
+ */
+QVP_TARGET("avx512f,avx512bw")
+inline __m256i packAvx512(__m512i value)
+{
+    const __m512i clamped = _mm512_max_epi16(value, _mm512_setzero_si512());
+    return _mm512_mask_cvtusepi16_epi8(_mm256_setzero_si256(), static_cast<__mmask32>(-1), clamped);
+}
+
+/**
+ * @brief 写出32个像素（两组16像素）
+ */
+template <bool SwapRB>
+QVP_TARGET("avx512f,avx512bw")
+inline void storePixelsAvx512(uint8_t *dst, __m512i r, __m512i g, __m512i b)
+{
+    const __m256i r8 = packAvx512(r);
+    const __m256i g8 = packAvx512(g);
+    const __m256i b8 = packAvx512(b);
+
+    storePixelsSse41<SwapRB>(dst, _mm256_castsi256_si128(r8), _mm256_castsi256_si128(g8),
+                             _mm256_castsi256_si128(b8));
+    storePixelsSse41<SwapRB>(dst + 64, _mm256_extracti128_si256(r8, 1), _mm256_extracti128_si256(g8, 1),
+                             _mm256_extracti128_si256(b8, 1));
+}
+
+struct Avx512Isa {
+    template <bool SwapRB, int ChromaShiftW>
+    QVP_TARGET("avx512f,avx512bw")
+    static void row(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                    uint8_t *dst, int width, const Coefficients &c)
+    {
+        const Avx512Coefficients k = loadAvx512(c);
+
+        int i = 0;
+        for (; i + 64 <= width; i += 64) {
+            const __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            const __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i + 32));
+
+            __m512i r0, g0, b0, r1, g1, b1;
+            yuvToRgbAvx512(_mm512_cvtepu8_epi16(y0),
+                           loadChromaAvx512<ChromaShiftW>(u, i), loadChromaAvx512<ChromaShiftW>(v, i),
+                           k, r0, g0, b0);
+            yuvToRgbAvx512(_mm512_cvtepu8_epi16(y1),
+                           loadChromaAvx512<ChromaShiftW>(u, i + 32), loadChromaAvx512<ChromaShiftW>(v, i + 32),
+                           k, r1, g1, b1);
+
+            storePixelsAvx512<SwapRB>(dst + i * 4, r0, g0, b0);
+            storePixelsAvx512<SwapRB>(dst + (i + 32) * 4, r1, g1, b1);
+        }
+
+        Avx2Isa::row<SwapRB, ChromaShiftW>(y + i, u + (i >> ChromaShiftW), v + (i >> ChromaShiftW),
+                                           dst + i * 4, width - i, c);
+    }
+
+    static void deinterleave(const uint8_t *uv, uint8_t *u, uint8_t *v, int count)
+    {
+        Sse41Isa::deinterleave(uv, u, v, count);
+    }
+
+    template <int Shift>
+    static void pack(const uint8_t *src, uint8_t *dst, int count)
+    {
+        Sse41Isa::pack<Shift>(src, dst, count);
+    }
+};
+
+#else
+
+// 非x86平台只有标量实现，SIMD实现永远不会被选中
+typedef ScalarIsa Sse41Isa;
+typedef ScalarIsa Avx2Isa;
+typedef ScalarIsa Avx512Isa;
+
+#endif // QVP_X86_SIMD
+
+// ---------------------------------------------------------------------------
+// 按(源格式, 目标格式, 指令集)在编译期特化的条带转换函数
+// 格式相关的分支全部在编译期展开，逐像素循环中没有任何格式判断
+// ---------------------------------------------------------------------------
+
+template <AVPixelFormat SrcFormat, AVPixelFormat DstFormat, class Isa>
+void convertSlice(const AVFrame *src, uint8_t *dst, int dstStride, int y, int height)
+{
+    typedef SourceTraits<SrcFormat> Src;
+    constexpr bool kSwapRB = DestTraits<DstFormat>::kSwapRB;
+    constexpr bool kHighBitDepth = Src::kBitDepth > 8;
+
+    const Coefficients &c = coefficientsFor(src, Src::kFullRange);
+    const int width = src->width;
+    const int chromaWidth = (width + (1 << Src::kChromaShiftW) - 1) >> Src::kChromaShiftW;
+
+    // 交错色度拆分和高位深降精度需要临时行缓冲，每个条带各自分配，可被多线程并发调用
+    std::vector<uint8_t> scratch;
+    uint8_t *yTmp = nullptr;
+    uint8_t *uTmp = nullptr;
+    uint8_t *vTmp = nullptr;
+    if (Src::kInterleaved || kHighBitDepth) {
+        scratch.resize(static_cast<size_t>(width) + chromaWidth * 2);
+        yTmp = scratch.data();
+        uTmp = yTmp + width;
+        vTmp = uTmp + chromaWidth;
+    }
+
+    int preparedChromaRow = -1;
+    for (int row = y; row < y + height; ++row) {
+        const int chromaRow = row >> Src::kChromaShiftH;
+        const uint8_t *yRow = src->data[0] + static_cast<ptrdiff_t>(row) * src->linesize[0];
+        const uint8_t *uRow = src->data[1] + static_cast<ptrdiff_t>(chromaRow) * src->linesize[1];
+        const uint8_t *vRow = nullptr;
+
+        if constexpr (kHighBitDepth) {
+            Isa::template pack<Src::kBitDepth - 8>(yRow, yTmp, width);
+            yRow = yTmp;
+        }
+
+        if constexpr (Src::kInterleaved) {
+            // 多行亮度共用一行色度，只在色度行变化时拆分
+            if (chromaRow != preparedChromaRow) {
+                if (Src::kSwapUV) {
+                    Isa::deinterleave(uRow, vTmp, uTmp, chromaWidth);
+                } else {
+                    Isa::deinterleave(uRow, uTmp, vTmp, chromaWidth);
+                }
+                preparedChromaRow = chromaRow;
+            }
+            uRow = uTmp;
+            vRow = vTmp;
+        } else if constexpr (kHighBitDepth) {
+            if (chromaRow != preparedChromaRow) {
+                Isa::template pack<Src::kBitDepth - 8>(uRow, uTmp, chromaWidth);
+                Isa::template pack<Src::kBitDepth - 8>(
+                    src->data[2] + static_cast<ptrdiff_t>(chromaRow) * src->linesize[2], vTmp, chromaWidth);
+                preparedChromaRow = chromaRow;
+            }
+            uRow = uTmp;
+            vRow = vTmp;
+        } else {
+            vRow = src->data[2] + static_cast<ptrdiff_t>(chromaRow) * src->linesize[2];
+        }
+
+        Isa::template row<kSwapRB, Src::kChromaShiftW>(
+            yRow, uRow, vRow, dst + static_cast<ptrdiff_t>(row) * dstStride, width, c);
+    }
+}
+
+/**
+ * @brief 调度表项：一个格式组合在各指令集下的特化函数
+ */
+struct Conversion {
+    AVPixelFormat src;
+    AVPixelFormat dst;
+    YuvConverter::SliceFunction functions[4];
+};
+
+template <AVPixelFormat SrcFormat, AVPixelFormat DstFormat>
+constexpr Conversion makeConversion()
+{
+    return { SrcFormat, DstFormat, {
+        convertSlice<SrcFormat, DstFormat, ScalarIsa>,
+        convertSlice<SrcFormat, DstFormat, Sse41Isa>,
+        convertSlice<SrcFormat, DstFormat, Avx2Isa>,
+        convertSlice<SrcFormat, DstFormat, Avx512Isa>
+    } };
+}
+
+// 函数下标与YuvConverter::Backend的枚举值一一对应
+const Conversion kConversions[] = {
+    makeConversion<AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUV422P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV422P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUV444P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV444P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUVJ444P, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUVJ444P, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_NV12, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_NV12, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_NV21, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_NV21, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_RGBA>(),
+    makeConversion<AV_PIX_FMT_YUV444P10LE, AV_PIX_FMT_BGRA>(),
+    makeConversion<AV_PIX_FMT_YUV444P10LE, AV_PIX_FMT_RGBA>(),
+};
+
+const Conversion *findConversion(AVPixelFormat src, AVPixelFormat dst)
+{
+    for (const Conversion &conversion : kConversions) {
+        if (conversion.src == src && conversion.dst == dst) {
+            return &conversion;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+YuvConverter::YuvConverter()
+    : m_backend(detectBackend())
+    , m_srcFormat(AV_PIX_FMT_NONE)
+    , m_dstFormat(AV_PIX_FMT_NONE)
+    , m_function(nullptr)
+{
+}
+
+bool YuvConverter::isSupported(AVPixelFormat src, AVPixelFormat dst)
+{
+    return findConversion(src, dst) != nullptr;
+}
+
+std::vector<std::pair<AVPixelFormat, AVPixelFormat>> YuvConverter::supportedConversions()
+{
+    std::vector<std::pair<AVPixelFormat, AVPixelFormat>> conversions;
+    for (const Conversion &conversion : kConversions) {
+        conversions.emplace_back(conversion.src, conversion.dst);
+    }
+    return conversions;
+}
+
+YuvConverter::Backend YuvConverter::detectBackend()
+{
+    if (isBackendAvailable(Backend::AVX512)) {
+        return Backend::AVX512;
+    }
+    if (isBackendAvailable(Backend::AVX2)) {
+        return Backend::AVX2;
+    }
+    if (isBackendAvailable(Backend::SSE41)) {
+        return Backend::SSE41;
+    }
+    return Backend::Scalar;
+}
+
+bool YuvConverter::isBackendAvailable(Backend backend)
+{
+#ifdef QVP_X86_SIMD
+    const int flags = av_get_cpu_flags();
+    switch (backend) {
+    case Backend::AVX512:
+        return (flags & AV_CPU_FLAG_AVX512) != 0;
+    case Backend::AVX2:
+        return (flags & AV_CPU_FLAG_AVX2) != 0;
+    case Backend::SSE41:
+        return (flags & AV_CPU_FLAG_SSE4) != 0;
+    case Backend::Scalar:
+        return true;
+    }
+    return false;
+#else
+    return backend == Backend::Scalar;
+#endif
+}
+
+const char *YuvConverter::backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::AVX512:
+        return "avx512";
+    case Backend::AVX2:
+        return "avx2";
+    case Backend::SSE41:
+        return "sse4.1";
+    case Backend::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+bool YuvConverter::setBackend(Backend backend)
+{
+    if (!isBackendAvailable(backend)) {
+        return false;
+    }
+    m_backend = backend;
+
+    // 已选定格式组合时重新查表
+    if (m_function) {
+        prepare(m_srcFormat, m_dstFormat);
+    }
+    return true;
+}
+
+YuvConverter::Backend YuvConverter::backend() const
+{
+    return m_backend;
+}
+
+bool YuvConverter::prepare(AVPixelFormat src, AVPixelFormat dst)
+{
+    const Conversion *conversion = findConversion(src, dst);
+    if (!conversion) {
+        m_srcFormat = AV_PIX_FMT_NONE;
+        m_dstFormat = AV_PIX_FMT_NONE;
+        m_function = nullptr;
+        return false;
+    }
+
+    m_srcFormat = src;
+    m_dstFormat = dst;
+    m_function = conversion->functions[static_cast<int>(m_backend)];
+    return true;
+}
+
+bool YuvConverter::isPrepared() const
+{
+    return m_function != nullptr;
+}
+
+void YuvConverter::convert(const AVFrame *src, uint8_t *dst, int dstStride, int y, int height) const
+{
+    // 源格式与prepare时不一致（例如流中途切换格式）时不做转换
+    if (!m_function || src->format != m_srcFormat) {
+        return;
+    }
+    m_function(src, dst, dstStride, y, height);
+}
@@ -0,0 +1,136 @@
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+    struct AVFrame;
+}
+
+/**
+ * @brief YUV到32位RGB的快速转换器
+ *
+ * 每个(源格式, 目标格式)组合在编译期按色度采样、位深和排列方式特化出独立的转换函数，
+ * 逐像素循环中没有格式判断；prepare时查表选出对应函数，之后每帧直接调用。
+ * 支持yuv420p/422p/444p（含yuvj全范围变体）、nv12/nv21和10位的yuv420p/422p/444p，
+ * 目标为BGRA（小端下即AV_PIX_FMT_RGB32 / QImage::Format_RGB32）或RGBA。
+ * 运行时通过av_get_cpu_flags选择SSE4.1/AVX2/AVX-512实现，并保留标量参考实现。
+ * 所有实现使用相同的定点运算，输出逐字节一致，标量实现可作为正确性校验基准。
+ */
+class YuvConverter
+{
+public:
+    /**
+     * @brief 转换内核实现
+     */
+    enum class Backend {
+        Scalar,
+        SSE41,
+        AVX2,
+        AVX512
+    };
+
+    /**
+     * @brief YUV到RGB的定点系数（Q6）
+     */
+    struct Coefficients {
+        int16_t yOffset;
+        int16_t yCoef;
+        int16_t rv;
+        int16_t gu;
+        int16_t gv;
+        int16_t bu;
+    };
+
+    /**
+     * @brief 特化后的条带转换函数
+     */
+    typedef void (*SliceFunction)(const AVFrame *src, uint8_t *dst, int dstStride, int y, int height);
+
+    /**
+     * @brief 构造函数，自动选择当前CPU支持的最快实现
+     */
+    YuvConverter();
+
+    /**
+     * @brief 检查格式组合是否有快速转换路径
+     * @param src 源像素格式
+     * @param dst 目标像素格式
+     * @return 是否支持
+     */
+    static bool isSupported(AVPixelFormat src, AVPixelFormat dst);
+
+    /**
+     * @brief 获取所有支持的格式组合
+     * @return (源格式, 目标格式)列表
+     */
+    static std::vector<std::pair<AVPixelFormat, AVPixelFormat>> supportedConversions();
+
+    /**
+     * @brief 检测当前CPU支持的最快实现
+     * @return 实现类型
+     */
+    static Backend detectBackend();
+
+    /**
+     * @brief 检查当前CPU能否运行指定实现
+     * @param backend 实现类型
+     * @return 是否可用
+     */
+    static bool isBackendAvailable(Backend backend);
+
+    /**
+     * @brief 获取实现名称
+     * @param backend 实现类型
+     * @return 名称
+     */
+    static const char *backendName(Backend backend);
+
+    /**
+     * @brief 强制使用指定实现（用于正确性校验和性能对比）
+     * @param backend 实现类型
+     * @return 当前CPU不支持该实现时返回false且不做修改
+     */
+    bool setBackend(Backend backend);
+
+    /**
+     * @brief 获取当前使用的实现
+     * @return 实现类型
+     */
+    Backend backend() const;
+
+    /**
+     * @brief 选定格式组合，查表得到对应的特化转换函数
+     * @param src 源像素格式
+     * @param dst 目标像素格式
+     * @return 不支持该组合时返回false
+     */
+    bool prepare(AVPixelFormat src, AVPixelFormat dst);
+
+    /**
+     * @brief 检查是否已选定格式组合
+     * @return 是否可以转换
+     */
+    bool isPrepared() const;
+
+    /**
+     * @brief 转换源帧的若干行
+     * @param src 源帧（格式必须与prepare时一致，否则不做转换）
+     * @param dst 目标图像首行指针
+     * @param dstStride 目标图像行跨度
+     * @param y 起始行（垂直色度二次采样的格式需为偶数）
+     * @param height 行数
+     */
+    void convert(const AVFrame *src, uint8_t *dst, int dstStride, int y, int height) const;
+
+private:
+    Backend m_backend;
+    AVPixelFormat m_srcFormat;
+    AVPixelFormat m_dstFormat;
+    SliceFunction m_function;
+};
+
+#endif // YUVCONVERTER_H